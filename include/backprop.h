@@ -0,0 +1,85 @@
+#ifndef BACKPROP_H
+#define BACKPROP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "neural_network.h"
+#include "data_loader.h"
+#include "rng.h"
+
+// --- Activations ---
+
+typedef enum {
+    ACTIVATION_SIGMOID,
+    ACTIVATION_TANH,
+    ACTIVATION_RELU
+} Activation;
+
+double activate(Activation activation, double x);
+
+// Derivative expressed through the activation's output y = f(x), which is
+// what the backward pass keeps around
+double activation_derivative(Activation activation, double y);
+
+// --- Optimizers ---
+
+typedef enum {
+    OPTIMIZER_SGD,
+    OPTIMIZER_MOMENTUM,
+    OPTIMIZER_ADAM
+} OptimizerKind;
+
+typedef struct {
+    OptimizerKind optimizer;
+    double learning_rate;
+    double momentum;       // OPTIMIZER_MOMENTUM
+    double beta1, beta2;   // OPTIMIZER_ADAM
+    double epsilon;        // OPTIMIZER_ADAM
+    int batch_size;
+    // Hidden layers only; the output layer is always a sigmoid trained with
+    // binary cross-entropy. forward_pass and the model files assume sigmoid
+    // everywhere, so other choices are for in-memory experiments.
+    Activation hidden_activation;
+} TrainerConfig;
+
+// Fills in the usual defaults for the optimizer: learning rate 0.5 for
+// SGD, 0.1 with momentum 0.9, and 0.001 for Adam; batches of 64
+void default_trainer_config(TrainerConfig* config, OptimizerKind optimizer);
+
+// Trains one network in place. Gradients of a mini-batch are computed in
+// shards, one per worker thread, each with its own activations and
+// gradient buffers, and summed before the update.
+typedef struct {
+    NeuralNetwork* net;
+    TrainerConfig config;
+    size_t num_params;
+    double* gradients;     // Mean gradient of the last batch, weights then biases per layer
+    double* velocity;      // Momentum, or Adam's first moment
+    double* second_moment; // Adam only
+    long step;
+    int num_shards;
+    struct TrainerShard* shards;
+    double* batch;         // batch_size rows of gathered inputs
+    unsigned char* labels; // Class of each gathered row
+} Trainer;
+
+// Re-draws the weights uniformly in +-sqrt(6 / (fan_in + fan_out)) and
+// zeroes the biases. Gradient descent needs weights of both signs;
+// initialize_network only draws positive ones.
+void initialize_network_for_training(NeuralNetwork* net, Rng* rng);
+
+Trainer* create_trainer(NeuralNetwork* net, const TrainerConfig* config);
+void free_trainer(Trainer* trainer);
+
+// Computes the mean loss and gradient over dataset records indices[0..count)
+// into trainer->gradients without touching the weights
+double compute_batch_gradients(Trainer* trainer, const Dataset* dataset, const int* indices, int count);
+
+// Applies trainer->gradients with the configured optimizer
+void apply_optimizer_step(Trainer* trainer);
+
+// One pass over the first num_samples records in a shuffled order. Returns
+// the mean training loss.
+double train_epoch(Trainer* trainer, const Dataset* dataset, int num_samples, Rng* rng);
+
+#endif // BACKPROP_H
@@ -0,0 +1,69 @@
+#ifndef BINARIZED_NETWORK_H
+#define BINARIZED_NETWORK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "data_loader.h"
+
+// A network with +-1 weights and +-1 activations, one bit each: a set bit
+// is +1, a clear bit -1. A neuron's pre-activation over n inputs is
+//
+//   dot = n - 2 * popcount(x XOR w)
+//
+// computed 64 inputs per word. Hidden neurons fire (+1) when dot reaches
+// their integer threshold; output neurons score dot - threshold and the
+// prediction is the best score. Rows are padded to whole words with clear
+// bits in both inputs and weights, so padding never counts as a mismatch.
+typedef struct {
+    int num_layers;
+    int* architecture;
+    int* words;            // Per layer: 64-bit words per input row
+    uint64_t** weights;    // Per layer: outputs rows of words[l] words
+    int32_t** thresholds;  // Per layer: outputs values
+} BinarizedNetwork;
+
+// --- Binarized Network Functions ---
+
+// All weights -1 and zero thresholds
+BinarizedNetwork* create_binarized_network(int num_layers, const int* architecture);
+// Uniformly random weight bits and zero thresholds, drawn from rand()
+BinarizedNetwork* create_binarized_genome(int num_layers, const int* architecture);
+BinarizedNetwork* clone_binarized_network(const BinarizedNetwork* src);
+void free_binarized_network(BinarizedNetwork* net);
+
+// Bytes of parameters held by the network
+size_t binarized_network_size(const BinarizedNetwork* net);
+
+// Words of scratch space binarized_predict needs
+int binarized_scratch_words(const BinarizedNetwork* net);
+
+// Writes the output scores for bit-packed inputs and returns the predicted
+// class. `scores` may be NULL. `scratch` must hold binarized_scratch_words
+// words; it lets callers on different threads share one network.
+int binarized_forward(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch, int32_t* scores);
+int binarized_predict(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch);
+
+// Accuracy of each network over the first num_samples records, written to
+// fitness. Networks are scored in parallel.
+void binarized_population_fitness(BinarizedNetwork** population, int population_size, const BitDataset* dataset,
+                                  int num_samples, double* fitness);
+
+// Model files use the binary model header with BINARIZED_MODEL_MAGIC
+int save_binarized_network(const BinarizedNetwork* net, const char* filepath);
+BinarizedNetwork* load_binarized_network(const char* filepath);
+
+// --- Genome Operators ---
+
+// Each word of the child takes its bits from the parents through a random
+// mask; each threshold comes from one parent or the other
+BinarizedNetwork* crossover_binarized(const BinarizedNetwork* parent1, const BinarizedNetwork* parent2);
+
+// Flips each weight bit with mutation_chance, and with the same chance moves
+// each threshold by up to mutation_rate / 2 of the neuron's fan-in (at least 1)
+void mutate_binarized_network(BinarizedNetwork* net, float mutation_rate, float mutation_chance);
+
+// "popcnt" when the CPU has the instruction, otherwise "scalar".
+// GENNET_BINARIZED_KERNEL=scalar forces the portable path.
+const char* binarized_kernel_name(void);
+
+#endif // BINARIZED_NETWORK_H
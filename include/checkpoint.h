@@ -0,0 +1,50 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "neural_network.h"
+
+#define CHECKPOINT_MAGIC 0x504B4347 // "GCKP" little-endian
+#define CHECKPOINT_VERSION 1
+
+// Everything needed to continue an evolutionary run: the evaluated
+// population of one generation, its fitness values, the seed the random
+// number generator was reset to afterwards, and the run's hyperparameters
+typedef struct {
+    int generation;      // Index of the generation the population belongs to
+    int num_generations;
+    int population_size;
+    float mutation_rate;
+    float mutation_chance;
+    int fitness_samples;
+    int projection_kind; // 0 when training on raw pixels
+    int projection_size;
+    unsigned int rng_seed;
+    NeuralNetwork** population;
+    double* fitness;
+} EvolutionState;
+
+// Writes checkpoints on a background thread
+typedef struct CheckpointWriter CheckpointWriter;
+
+// --- Checkpoint Functions ---
+
+// Writes a checkpoint synchronously. The file is replaced atomically.
+int save_checkpoint(const EvolutionState* state, const char* filepath);
+EvolutionState* load_checkpoint(const char* filepath);
+
+// Allocates a state holding deep copies of the given networks and fitness values
+EvolutionState* snapshot_evolution_state(NeuralNetwork** population, const double* fitness, int population_size);
+void free_evolution_state(EvolutionState* state);
+
+// --- Background Writer ---
+
+CheckpointWriter* start_checkpoint_writer(const char* filepath);
+
+// Hands a snapshot to the writer, which takes ownership. Never waits for
+// disk: a snapshot still waiting to be written is replaced by the newer one.
+void checkpoint_writer_submit(CheckpointWriter* writer, EvolutionState* snapshot);
+
+// Writes any pending snapshot and stops the thread
+void stop_checkpoint_writer(CheckpointWriter* writer);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,66 @@
+#ifndef CODEBOOK_H
+#define CODEBOOK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "neural_network.h"
+
+// Centroids per layer codebook. Up to 16 centroids are indexed with 4 bits,
+// more with 8.
+#define CODEBOOK_MIN_CENTROIDS 16
+#define CODEBOOK_MAX_CENTROIDS 256
+
+// Rows of indices are padded to a multiple of this many inputs; padding
+// indices are 0 and meet zero-padded inputs
+#define CODEBOOK_ROW_ALIGNMENT 8
+
+// A network whose weights are shared through one k-means codebook per
+// layer: each weight is stored as the index of its centroid. Inference adds
+// up the inputs that share a centroid and multiplies once per centroid, or,
+// on AVX2, looks each weight's centroid up and multiplies directly.
+typedef struct {
+    int num_layers;
+    int* architecture;
+    int* padded_inputs;  // Per layer: inputs rounded up to CODEBOOK_ROW_ALIGNMENT
+    int* num_centroids;  // Per layer
+    int* index_bits;     // Per layer: 4 or 8
+    float** centroids;   // Per layer: CODEBOOK_MAX_CENTROIDS values, unused ones zero
+    uint8_t** indices;   // Per layer: outputs rows of padded_inputs * index_bits / 8 bytes
+    float** biases;
+    float* sums;         // Scratch: per-centroid input sums
+    float* scratch[2];   // Scratch: float activations, ping-pong
+} CodebookNetwork;
+
+// --- Compression ---
+
+// Clusters each layer's weights into `num_centroids` centroids
+// (CODEBOOK_MIN_CENTROIDS..CODEBOOK_MAX_CENTROIDS) with 1-D k-means
+CodebookNetwork* compress_network(const NeuralNetwork* net, int num_centroids);
+void free_codebook_network(CodebookNetwork* cnet);
+
+// Root-mean-square difference between the original and the shared weights
+double codebook_weight_error(const CodebookNetwork* cnet, const NeuralNetwork* net);
+
+// Bytes of parameters held by the compressed network, excluding scratch
+size_t codebook_network_size(const CodebookNetwork* cnet);
+
+// Codebook models use the binary model header with CODEBOOK_MODEL_MAGIC.
+// The CRC covers everything after the header.
+int save_codebook_network(const CodebookNetwork* cnet, const char* filepath);
+CodebookNetwork* load_codebook_network(const char* filepath);
+
+// --- Codebook Inference ---
+
+// Writes the output activations for one input row. Scratch buffers make
+// this allocation-free but not shareable between threads.
+void codebook_forward(CodebookNetwork* cnet, const double* input, double* output);
+
+// Returns the class with the largest output logit
+int codebook_predict(CodebookNetwork* cnet, const double* input);
+
+// "avx2" when 4-bit layers look centroids up in registers and 8-bit layers
+// gather them, otherwise "sums". GENNET_CODEBOOK_KERNEL=sums forces the
+// portable kernel.
+const char* codebook_kernel_name(void);
+
+#endif // CODEBOOK_H
@@ -0,0 +1,17 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "neural_network.h"
+
+// --- Code Generation ---
+
+// Writes a self-contained C source file and header that evaluate `net`
+// without loading anything at run time. The weights become `static const`
+// 64-byte aligned arrays and each layer is a loop nest with compile-time
+// bounds. The generated functions are `<name>_forward`, which writes the
+// output activations, and `<name>_predict`, which returns the winning class.
+// `name` must be a valid C identifier. Returns 1 on success, 0 on failure.
+int compile_network_source(const NeuralNetwork* net, const char* name,
+                           const char* source_path, const char* header_path);
+
+#endif // CODEGEN_H
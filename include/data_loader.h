@@ -1,31 +1,140 @@
 #ifndef DATA_LOADER_H
 #define DATA_LOADER_H
 
+#include <stdio.h>
+#include <stdint.h>
 #include "neural_network.h"
 
 #define MNIST_IMAGE_ROWS 28
 #define MNIST_IMAGE_COLS 28
 #define MNIST_IMAGE_SIZE (MNIST_IMAGE_ROWS * MNIST_IMAGE_COLS)
 #define MNIST_NUM_CLASSES 10
+#define MNIST_TRAIN_SIZE 60000 // Records in the standard training files
+
+// IDX reads are split across threads only when every thread gets at least
+// this many records
+#define DECODE_MIN_RECORDS_PER_THREAD 2048
+
+// Binary dataset cache format (see load_mnist_dataset_cached)
+#define DATASET_CACHE_MAGIC 0x43445347 // "GSDC" little-endian
+#define DATASET_CACHE_VERSION 1
+#define DATASET_CACHE_ALIGNMENT 64
 
 // Represents a dataset of images and labels
 typedef struct {
     int num_items;
     Matrix* images; // Each row is a flattened image
     Matrix* labels; // Each row is a one-hot encoded label
+    unsigned char* label_indices; // Class index of each item
+    void* mapping;       // Backing mmap of a dataset cache, or NULL
+    size_t mapping_size;
 } Dataset;
 
-// --- Data Loader Functions ---
+// A dataset whose records stay on disk until first accessed. Records are
+// read a page (page_size records) at a time and kept resident afterwards.
+typedef struct {
+    FILE* image_file;
+    FILE* label_file;
+    int num_items;
+    int image_size;
+    int page_size;
+    int num_pages;
+    int resident_pages;
+    double** image_pages;        // NULL until the page is faulted in
+    unsigned char** label_pages;
+} PagedDataset;
 
 // --- Data Loader Functions ---
 
 // Loads the MNIST dataset from the specified files
 Dataset* load_mnist_dataset(const char* image_path, const char* label_path);
 
+// Loads `count` consecutive records starting at `start`. Only those records
+// are read from the IDX files.
+Dataset* load_mnist_range(const char* image_path, const char* label_path, int start, int count);
+
+// Loads the records at the given indices, in order
+Dataset* load_mnist_subset(const char* image_path, const char* label_path, const int* indices, int count);
+
+// Loads the MNIST dataset through a binary cache. If cache_path holds a cache
+// at least as new as both IDX files, in the precision GENNET_CACHE_DTYPE asks
+// for (float64 by default, or float32), it is mapped directly; otherwise the
+// IDX files are parsed and the cache is (re)built for the next run.
+Dataset* load_mnist_dataset_cached(const char* image_path, const char* label_path, const char* cache_path);
+
+// Writes a dataset to a binary cache file with pixels stored as
+// sizeof(double) or sizeof(float) bytes. Returns 1 on success, 0 on failure.
+int save_dataset_cache(const Dataset* dataset, const char* cache_path, int dtype_size);
+
+// Maps a binary cache file read-only. Float64 images point straight into the
+// mapping; float32 images are widened into an owned matrix.
+Dataset* map_dataset_cache(const char* cache_path);
+
+// Keeps only the first `count` records (at least one). The storage is left
+// as it is, so cutting down a mapped cache costs nothing.
+void truncate_dataset(Dataset* dataset, int count);
+
+// Allocates a zeroed dataset of the given shape
+Dataset* create_dataset(int num_items, int image_size, int num_classes);
+
 // Creates a dummy dataset with random values
 Dataset* create_dummy_dataset(int num_items);
 
 // Frees the memory allocated for a dataset
 void free_dataset(Dataset* dataset);
 
+// Rebuilds the one-hot label matrix from dataset->label_indices
+void fill_one_hot_labels(Dataset* dataset);
+
+// --- Low-level IDX Access ---
+
+// Opens and validates an IDX image/label file pair. Returns 1 on success.
+int open_idx_files(const char* image_path, const char* label_path,
+                   FILE** image_file, FILE** label_file,
+                   int* num_items, int* image_size);
+
+// Number of records in an IDX image/label file pair, or -1 if the pair
+// cannot be opened or is invalid
+int count_idx_records(const char* image_path, const char* label_path);
+
+// Reads `count` records starting at `first` into normalized pixels and class
+// indices. Returns 1 on success.
+int read_idx_records(FILE* image_file, FILE* label_file, int image_size,
+                     long first, int count, double* images, unsigned char* labels);
+
+// --- Bit-Packed Datasets ---
+//
+// Thresholded images for binarized networks: bit k of a record is set when
+// pixel k is at least the threshold. Each record is padded with zero bits to
+// a whole number of 64-bit words.
+
+#define MNIST_BINARIZE_THRESHOLD 0.5
+
+typedef struct {
+    int num_items;
+    int num_inputs;
+    int words_per_item;
+    uint64_t* bits;               // num_items * words_per_item words
+    unsigned char* label_indices;
+} BitDataset;
+
+// Loads up to `count` records starting at `start`, packing them as they are
+// read so the unpacked pixels are never held all at once
+BitDataset* load_mnist_binarized(const char* image_path, const char* label_path, int start, int count, double threshold);
+BitDataset* binarize_dataset(const Dataset* dataset, double threshold);
+void free_bit_dataset(BitDataset* dataset);
+
+// 64-bit words needed to hold `bits` bits
+int words_for_bits(int bits);
+
+// Sets the bits of `out` (words_for_bits(n) words) from n values
+void pack_threshold_bits(const double* values, int n, double threshold, uint64_t* out);
+
+// --- Paged Dataset Functions ---
+
+PagedDataset* open_paged_dataset(const char* image_path, const char* label_path, int page_size);
+const double* paged_dataset_image(PagedDataset* paged, int index);
+int paged_dataset_label(PagedDataset* paged, int index);
+void close_paged_dataset(PagedDataset* paged);
+
 #endif // DATA_LOADER_H
@@ -0,0 +1,37 @@
+#ifndef DATASET_STREAM_H
+#define DATASET_STREAM_H
+
+#include "data_loader.h"
+#include "evolution.h"
+
+// Reads an IDX dataset from disk in fixed-size batches. A background thread
+// fills one batch buffer while the caller consumes the other, so at most two
+// batches are ever resident regardless of the size of the files.
+typedef struct DatasetStream DatasetStream;
+
+// --- Dataset Stream Functions ---
+
+DatasetStream* open_dataset_stream(const char* image_path, const char* label_path, int batch_size);
+
+// Returns the next batch, or NULL once the end of the dataset is reached.
+// The batch stays valid until the next call to dataset_stream_next,
+// dataset_stream_rewind or close_dataset_stream.
+const Dataset* dataset_stream_next(DatasetStream* stream);
+
+// Restarts the stream from the first record
+void dataset_stream_rewind(DatasetStream* stream);
+
+int dataset_stream_num_items(const DatasetStream* stream);
+void close_dataset_stream(DatasetStream* stream);
+
+// --- Streaming Evaluation ---
+
+// Accuracy of a network over the first max_samples records of the stream
+// (all records if max_samples <= 0)
+double stream_accuracy(const NeuralNetwork* network, DatasetStream* stream, int max_samples);
+
+// Scores every network of a population in a single pass over the stream
+void stream_population_fitness(NetworkFitness* population, int population_size,
+                               DatasetStream* stream, int max_samples);
+
+#endif // DATASET_STREAM_H
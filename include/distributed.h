@@ -0,0 +1,74 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "evolution.h"
+#include "data_loader.h"
+
+// Spreads fitness evaluation over worker processes, on this machine or
+// others. The master keeps the population and ships genomes over TCP or a
+// Unix socket; every worker holds its own copy of the fitness records and
+// streams back one fitness value per genome as soon as it is scored.
+//
+// Addresses are "unix:/path/to/socket" or "host:port". Messages are a
+// 12-byte header (magic, type, payload length) and a payload of
+// fixed-width fields in the host's byte order, so master and workers must
+// share an endianness. Genomes travel as float32 parameters in
+// flatten_network order, half the size of the double genome; workers
+// score the rounded weights.
+//
+// The master opens with the architecture and the number of records to
+// score. The worker answers with a HELLO carrying dataset_fingerprint of
+// those records, and the master sends work only if it matches its own, so
+// a worker with other records or another projection is turned away.
+
+// Genomes sent to a worker in one message. The master keeps two batches
+// in flight per worker, so a worker starts the next batch while its
+// results for the previous one are on the way back.
+#define DISTRIBUTED_DEFAULT_BATCH 4
+
+typedef struct DistributedMaster DistributedMaster;
+
+typedef struct {
+    int workers;          // Currently connected
+    long jobs_sent;       // Genomes shipped, including re-sends
+    long jobs_requeued;   // Genomes lost with a worker and sent again
+    long jobs_local;      // Genomes scored by the master while no worker was connected
+} DistributedStats;
+
+// CRC-32 of the first num_samples images, as the doubles the networks see,
+// followed by their class indices
+uint32_t dataset_fingerprint(const Dataset* dataset, int num_samples);
+
+// --- Master ---
+
+// Listens on the address. Workers must hold the same first num_samples
+// records as dataset. With score_locally the master scores genomes itself
+// whenever no worker is connected, so a run never stalls; otherwise it
+// waits for workers. Returns NULL on failure.
+DistributedMaster* start_master(const char* address, int num_layers, const int* architecture, int num_samples,
+                                int batch_size, const Dataset* dataset, int score_locally);
+
+// Scores every network of the population on the workers. Genomes a worker
+// took with it when it disconnected are sent to another. Returns 1 once
+// every fitness is set, 0 on failure.
+int distributed_evaluate(DistributedMaster* master, NetworkFitness* population, int population_size);
+
+void distributed_stats(const DistributedMaster* master, DistributedStats* stats);
+
+// Tells connected workers to exit, closes the socket and removes a Unix
+// socket file
+void stop_master(DistributedMaster* master);
+
+// --- Worker ---
+
+// Connects to the master (retrying for a few seconds while it starts up)
+// and scores genomes on the dataset until the master shuts down. With
+// max_jobs > 0 the worker disconnects after answering that many genomes,
+// leaving the rest of its batch to be re-queued, which lets long runs
+// recycle workers. Returns the number of genomes scored, or -1 if the
+// connection could not be made or the master's shape does not match the
+// dataset, or if the master closed the connection after the HELLO without
+// sending any work, which is how it turns away a worker with other records.
+long run_worker(const char* address, const Dataset* dataset, long max_jobs);
+
+#endif // DISTRIBUTED_H
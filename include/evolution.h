@@ -2,6 +2,10 @@
 #define EVOLUTION_H
 
 #include "neural_network.h"
+#include "quantization.h"
+#include "half_network.h"
+#include "binarized_network.h"
+#include "rng.h"
 
 // A struct to hold a network and its fitness score
 typedef struct {
@@ -12,8 +16,71 @@ typedef struct {
 // --- Evolution Functions ---
 
 NeuralNetwork* crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2);
+// Writes the average of two parents of the child's architecture into child
+void crossover_into(NeuralNetwork* child, const NeuralNetwork* parent1, const NeuralNetwork* parent2);
 NeuralNetwork** create_initial_population(int population_size, int num_layers, const int* architecture);
 NetworkFitness* select_fittest(NetworkFitness* population_with_fitness, int population_size, int* num_fittest);
 NeuralNetwork** reproduce(const NetworkFitness* fittest_networks, int num_fittest, int new_population_size, float mutation_rate, float mutation_chance);
 
+// --- Explicit-Stream Operators ---
+//
+// rand() shares one state behind a lock, so populations evolving on
+// separate threads draw parents and mutations from their own Rng instead.
+// Otherwise these match create_initial_population, mutate_network and
+// reproduce, and none of them calls rand().
+
+// Draws the initial weights as initialize_network does, but from rng
+NeuralNetwork** create_initial_population_rng(int population_size, int num_layers, const int* architecture, Rng* rng);
+void mutate_network_rng(NeuralNetwork* net, float mutation_rate, float mutation_chance, Rng* rng);
+NeuralNetwork** reproduce_rng(const NetworkFitness* fittest_networks, int num_fittest, int new_population_size, float mutation_rate, float mutation_chance, Rng* rng);
+
+// --- Genome Evolution ---
+//
+// The same algorithm on compact genome types. A GenomeOps table supplies a
+// type's operators and the generic functions below select and reproduce
+// through it, so every genome type shares one generational loop.
+
+typedef struct {
+    void* (*create)(int num_layers, const int* architecture);
+    void* (*crossover)(const void* parent1, const void* parent2);
+    void* (*clone)(const void* genome);
+    void (*mutate)(void* genome, float mutation_rate, float mutation_chance);
+    void (*free_genome)(void* genome);
+    // Writes the accuracy of each genome on the first num_samples records
+    void (*score)(void** population, int population_size, const void* dataset, int num_samples, double* fitness);
+} GenomeOps;
+
+typedef struct {
+    void* genome;
+    double fitness;
+} GenomeFitness;
+
+// Fails, freeing whatever was created, if any genome cannot be allocated
+void** create_initial_genome_population(const GenomeOps* ops, int population_size, int num_layers, const int* architecture);
+GenomeFitness* select_fittest_genomes(GenomeFitness* population_with_fitness, int population_size, int* num_fittest);
+void** reproduce_genomes(const GenomeOps* ops, const GenomeFitness* fittest_genomes, int num_fittest, int new_population_size, float mutation_rate, float mutation_chance);
+void free_genome_population(const GenomeOps* ops, void** population, int population_size);
+
+// int8 genomes (see create_quantized_genome), scored on a Dataset. Crossover
+// takes rounded averages, mutation adds whole steps and fitness is scored
+// with the integer kernels, so parameters never leave fixed point.
+extern const GenomeOps quantized_genome_ops;
+
+QuantizedNetwork* crossover_quantized(const QuantizedNetwork* parent1, const QuantizedNetwork* parent2);
+
+// Adds a uniform step of up to mutation_rate / 2 (rounded to whole steps of
+// the layer scale, at least one) to each parameter with mutation_chance
+void mutate_quantized_network(QuantizedNetwork* qnet, float mutation_rate, float mutation_chance);
+
+// fp16 and bf16 genomes (see half_network.h), which take a quarter of the
+// memory of double genomes. Operators compute in float32 and round on store;
+// crossover and mutation are crossover_half and mutate_half_network.
+extern const GenomeOps fp16_genome_ops;
+extern const GenomeOps bf16_genome_ops;
+
+// One-bit genomes (see binarized_network.h), scored on a BitDataset.
+// Crossover mixes parents through random bit masks and mutation flips bits;
+// the operators are crossover_binarized and mutate_binarized_network.
+extern const GenomeOps binarized_genome_ops;
+
 #endif // EVOLUTION_H
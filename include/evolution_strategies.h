@@ -0,0 +1,83 @@
+#ifndef EVOLUTION_STRATEGIES_H
+#define EVOLUTION_STRATEGIES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "neural_network.h"
+#include "data_loader.h"
+#include "rng.h"
+
+// Evolution strategies search around a single mean genome instead of a
+// population of networks. Every candidate is the mean plus Gaussian noise
+// drawn from its own RNG stream, so a candidate is fully described by one
+// 64-bit seed: workers only need the mean, the seed and the step size, and
+// send back a scalar fitness.
+
+typedef enum {
+    // OpenAI-ES: antithetic pairs (mean + sigma e, mean - sigma e) share a
+    // seed; centered ranks weight the noise in a gradient step on the mean
+    ES_OPENAI,
+    // Separable CMA-ES: a diagonal covariance and the step size adapt
+    // through evolution paths; the better half recombines into the mean
+    ES_SEPARABLE_CMA
+} EsKind;
+
+typedef struct {
+    EsKind kind;
+    int population;        // Candidates per generation; even for ES_OPENAI
+    double sigma;          // Noise scale, or CMA's initial step size
+    double learning_rate;  // ES_OPENAI only
+    double momentum;       // ES_OPENAI only
+    double weight_decay;   // ES_OPENAI only: pulls the mean toward zero
+    uint64_t seed;
+} EsConfig;
+
+// Defaults: 50 candidates and sigma 0.05; for ES_OPENAI a learning rate of
+// 0.002, momentum 0.9 and weight decay 0.005
+void default_es_config(EsConfig* config, EsKind kind);
+
+typedef struct {
+    EsConfig config;
+    size_t num_params;
+    double* mean;
+    double* velocity;      // ES_OPENAI: momentum of the mean
+    double* variances;     // ES_SEPARABLE_CMA: diagonal of C
+    double* path_sigma;    // ES_SEPARABLE_CMA
+    double* path_c;        // ES_SEPARABLE_CMA
+    double sigma;          // Current step size
+    uint64_t* seeds;       // Noise seed of each candidate this generation
+    int generation;
+    Rng rng;               // Draws the seeds
+    // CMA constants, fixed by the dimension and population
+    int parents;
+    double* weights;
+    double mu_eff, c_sigma, d_sigma, c_c, c_1, c_mu, chi_n;
+} EvolutionStrategy;
+
+// Starts the search at the given network's parameters
+EvolutionStrategy* create_evolution_strategy(const NeuralNetwork* start, const EsConfig* config);
+void free_evolution_strategy(EvolutionStrategy* es);
+
+// Draws a fresh seed for every candidate of the next generation
+void es_ask(EvolutionStrategy* es);
+
+// Rebuilds candidate `index` of the current generation from its seed
+void es_candidate(const EvolutionStrategy* es, int index, double* params);
+
+// Scores every candidate of the current generation on the first num_samples
+// records. Threads each rebuild their candidates from the seeds. Fitness is
+// the accuracy plus the mean output for the true class divided by
+// num_samples: less than one correct sample, so it only orders candidates
+// whose accuracy ties, which is common near a fresh network.
+void es_evaluate(const EvolutionStrategy* es, const NeuralNetwork* shape, const Dataset* dataset,
+                 int num_samples, double* fitness);
+
+// Moves the mean (and for CMA the step size and covariance) using the
+// fitness of every candidate; higher is better. Regenerates the noise from
+// the seeds rather than keeping it.
+void es_tell(EvolutionStrategy* es, const double* fitness);
+
+// Writes the current mean into a network of the starting shape
+void es_mean_network(const EvolutionStrategy* es, NeuralNetwork* net);
+
+#endif // EVOLUTION_STRATEGIES_H
@@ -0,0 +1,71 @@
+#ifndef HALF_NETWORK_H
+#define HALF_NETWORK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "neural_network.h"
+#include "data_loader.h"
+
+// Storage formats for compact genomes
+typedef enum {
+    HALF_FP16 = 1, // IEEE binary16: 10-bit mantissa, range +-65504
+    HALF_BF16 = 2  // bfloat16: float32 truncated to an 8-bit mantissa, full float range
+} HalfFormat;
+
+// A network whose parameters are stored as 16-bit floats, a quarter of the
+// memory of the double-precision NeuralNetwork. Weights are kept output by
+// output ([outputs][inputs]) so each neuron is one contiguous dot product.
+// All arithmetic happens in float32; values are only rounded when stored.
+typedef struct {
+    HalfFormat format;
+    int num_layers;
+    int* architecture;
+    uint16_t** weights; // Per layer: outputs rows of inputs values
+    uint16_t** biases;  // Per layer: outputs values
+} HalfNetwork;
+
+// --- Conversion ---
+
+// Round-to-nearest-even conversions, identical to the F16C instructions
+float half_to_float(uint16_t value, HalfFormat format);
+uint16_t float_to_half(float value, HalfFormat format);
+
+// --- Half Network Functions ---
+
+// Initializes like initialize_network: weights uniform in
+// [0, sqrt(2 / fan_in)], zero biases
+HalfNetwork* create_half_network(int num_layers, const int* architecture, HalfFormat format);
+HalfNetwork* clone_half_network(const HalfNetwork* src);
+void free_half_network(HalfNetwork* net);
+
+// Converts between storage formats. to_network is exact; from_network rounds.
+HalfNetwork* half_network_from_network(const NeuralNetwork* net, HalfFormat format);
+NeuralNetwork* half_network_to_network(const HalfNetwork* net);
+
+// Bytes of parameters held by the network
+size_t half_network_size(const HalfNetwork* net);
+
+// Floats of scratch space half_predict needs
+int half_network_scratch_size(const HalfNetwork* net);
+
+// Returns the class with the largest output logit. `scratch` must hold
+// half_network_scratch_size floats; it lets callers on different threads
+// share one network.
+int half_predict(const HalfNetwork* net, const double* input, float* scratch);
+
+// Accuracy of each network over the first num_samples records, written to
+// fitness. Networks are scored in parallel.
+void half_population_fitness(HalfNetwork** population, int population_size, const Dataset* dataset,
+                             int num_samples, double* fitness);
+
+// --- Genome Operators ---
+
+// Same operators as crossover and mutate_network, computed in float32
+HalfNetwork* crossover_half(const HalfNetwork* parent1, const HalfNetwork* parent2);
+void mutate_half_network(HalfNetwork* net, float mutation_rate, float mutation_chance);
+
+// Name of the kernels in use: "f16c" for fp16 with F16C, "avx2" for bf16,
+// otherwise "scalar". GENNET_HALF_KERNEL=scalar forces the portable path.
+const char* half_kernel_name(HalfFormat format);
+
+#endif // HALF_NETWORK_H
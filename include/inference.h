@@ -0,0 +1,50 @@
+#ifndef INFERENCE_H
+#define INFERENCE_H
+
+#include "neural_network.h"
+#include "data_loader.h"
+
+// Number of outputs computed together; each panel holds this many weights per input
+#define PACKED_PANEL_WIDTH 8
+
+// A network repacked for single-sample latency. Each layer's weights are
+// split into panels of PACKED_PANEL_WIDTH outputs stored input-major, so
+// one input value updates a whole panel of accumulators from one contiguous
+// cache line. Scratch activations are allocated once, which makes a packed
+// network allocation-free to evaluate but not shareable between threads.
+typedef struct {
+    int num_layers;
+    int* architecture;
+    double** panels;     // Per layer: ceil(outputs / width) panels of inputs * width values
+    double** biases;     // Per layer: outputs padded to a whole panel
+    double* scratch[2];  // Ping-pong activations, sized for the widest layer
+    int prefetch_distance; // Inputs ahead to prefetch within a panel, 0 disables
+} PackedNetwork;
+
+// --- Packed Inference ---
+
+PackedNetwork* pack_network(const NeuralNetwork* net);
+void free_packed_network(PackedNetwork* packed);
+
+// Writes the output activations for one input row. Results are identical
+// to forward_pass.
+void packed_forward(PackedNetwork* packed, const double* input, double* output);
+
+// --- Prediction ---
+
+// Returns the class with the largest output-layer logit. The final sigmoid
+// is skipped because it is monotonic and cannot change the argmax.
+int predict_class(PackedNetwork* packed, const double* input);
+
+// Writes the `k` most likely classes, best first, into `classes`, and
+// their sigmoid activations into `scores` (which may be NULL). Only the
+// selected logits go through the activation. Returns how many classes
+// were written, which is less than `k` for networks with fewer outputs.
+int predict_top_k(PackedNetwork* packed, const double* input, int k, int* classes, double* scores);
+
+// Fraction of the first num_samples records (at most all of them) that the
+// network classifies correctly, predicted through a packed copy. Returns 0
+// if the copy cannot be allocated.
+double network_accuracy(const NeuralNetwork* net, const Dataset* dataset, int num_samples);
+
+#endif // INFERENCE_H
@@ -0,0 +1,81 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "evolution.h"
+#include "data_loader.h"
+
+// The island model splits evolution into independent populations, each
+// running the usual select/reproduce loop on its own thread. Every few
+// generations an island sends copies of its best networks to its
+// neighbours. Islands never wait for each other: migrants travel through
+// lock-free queues and are picked up whenever the receiver next looks.
+
+typedef enum {
+    MIGRATION_RING,       // Island i sends to island i + 1
+    MIGRATION_ALL_TO_ALL  // Every island sends to every other island
+} MigrationTopology;
+
+typedef struct {
+    int num_islands;
+    int population;          // Networks per island
+    int generations;
+    int migration_interval;  // Generations between emigrations
+    int migrants;            // Best networks sent to each neighbour
+    MigrationTopology topology;
+    float mutation_rate;
+    float mutation_chance;
+    int num_samples;         // Records each network is scored on
+    uint64_t seed;           // Island i draws from stream i of this seed
+    int report_every;        // Print each island's progress every N generations; 0 is quiet
+} IslandConfig;
+
+// Defaults: 4 islands of 50 networks, ring migration of 2 networks every
+// 5 generations, main's mutation settings and no progress output
+void default_island_config(IslandConfig* config);
+
+// --- Migration Queues ---
+
+// Bounded single-producer, single-consumer queue of scored networks. Each
+// directed edge of the topology owns one, so the sender only ever moves
+// the tail and the receiver only ever moves the head.
+typedef struct {
+    NetworkFitness* slots;
+    size_t capacity;         // Power of two
+    _Atomic size_t head;     // Next slot to pop
+    _Atomic size_t tail;     // Next slot to push
+} MigrationQueue;
+
+// Rounds the capacity up to a power of two. Returns 1 on success.
+int init_migration_queue(MigrationQueue* queue, size_t capacity);
+
+// Frees the queue and any networks still in it
+void destroy_migration_queue(MigrationQueue* queue);
+
+// Returns 0 if the queue is full; the caller keeps the network
+int migration_queue_push(MigrationQueue* queue, NetworkFitness migrant);
+
+// Returns 0 if the queue is empty
+int migration_queue_pop(MigrationQueue* queue, NetworkFitness* migrant);
+
+// --- Island Evolution ---
+
+typedef struct {
+    double best_fitness;
+    long evaluations;        // Networks scored
+    double seconds;          // Wall time of this island's loop
+    long migrants_sent;
+    long migrants_received;  // Immigrants that displaced a worse network
+    long migrants_dropped;   // Sent into a full queue, or no better than the worst
+} IslandStats;
+
+// Evolves config->num_islands populations of the given architecture, each
+// scored on the first config->num_samples records. Returns a copy of the
+// best network any island found, or NULL on failure. If stats is not NULL
+// it receives one entry per island.
+NeuralNetwork* run_islands(const IslandConfig* config, int num_layers, const int* architecture,
+                           const Dataset* dataset, IslandStats* stats, double* best_fitness);
+
+#endif // ISLAND_H
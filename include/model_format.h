@@ -0,0 +1,114 @@
+#ifndef MODEL_FORMAT_H
+#define MODEL_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "neural_network.h"
+
+// --- Binary Model Format ---
+//
+// A 64-byte header, the architecture as int32 values, then one weight block
+// (rows * cols values) and one bias block (cols values) per layer. Every
+// block starts on a MODEL_ALIGNMENT boundary so the file can be mapped and
+// used in place. The CRC covers every byte after the header.
+
+#define MODEL_MAGIC 0x424E4E47 // "GNNB" little-endian
+#define MODEL_VERSION 1
+#define MODEL_ENDIAN_MARKER 0x01020304
+// Storage type codes; the dense ones happen to match their element size
+#define MODEL_DTYPE_FLOAT64 8
+#define MODEL_DTYPE_INT8 1
+#define MODEL_DTYPE_BIT 0 // One bit per weight, see binarized_network.h
+#define MODEL_DTYPE_CODEBOOK 0xCB // Per-layer index width, see codebook.h
+#define QUANTIZED_MODEL_MAGIC 0x38514E47 // "GNQ8" little-endian, see quantization.h
+#define BINARIZED_MODEL_MAGIC 0x31424E47 // "GNB1" little-endian
+#define SPARSE_MODEL_MAGIC 0x31534E47 // "GNS1" little-endian, see sparse_network.h
+#define CODEBOOK_MODEL_MAGIC 0x31434E47 // "GNC1" little-endian
+#define MODEL_ALIGNMENT 64
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t dtype;         // Storage type code (MODEL_DTYPE_*), not always a byte width
+    uint8_t reserved0;
+    uint32_t endian_marker; // Reads back byte-swapped on a foreign-endian host
+    uint32_t num_layers;
+    uint64_t file_size;
+    uint32_t crc32;
+    uint8_t reserved[MODEL_ALIGNMENT - 28];
+} ModelHeader;
+
+// A read-only network whose weight and bias matrices are views into a
+// memory-mapped binary model file. Processes mapping the same file share
+// one page-cache copy of the parameters.
+typedef struct {
+    NeuralNetwork* net; // Must not be modified or passed to free_neural_network
+    void* mapping;
+    size_t mapping_size;
+} MappedNetwork;
+
+typedef enum {
+    MODEL_FORMAT_UNKNOWN = 0,
+    MODEL_FORMAT_TEXT,
+    MODEL_FORMAT_BINARY,
+    MODEL_FORMAT_INT8,
+    MODEL_FORMAT_BINARIZED,
+    MODEL_FORMAT_SPARSE,
+    MODEL_FORMAT_CODEBOOK
+} ModelFormat;
+
+// --- Model Format Functions ---
+
+// Identifies a model file from its first bytes
+ModelFormat detect_model_format(const char* filepath);
+
+int save_network_binary(const NeuralNetwork* net, const char* filepath);
+NeuralNetwork* load_network_binary(const char* filepath);
+
+// Maps a binary model file without copying any parameters. With
+// verify_checksum the CRC is checked, which reads the whole file once.
+MappedNetwork* map_network(const char* filepath, int verify_checksum);
+void unmap_network(MappedNetwork* mapped);
+
+// Byte offsets of each layer's weight and bias blocks for a given
+// architecture. Returns the total file size.
+uint64_t model_layout(int num_layers, const int* architecture,
+                      uint64_t* weight_offsets, uint64_t* bias_offsets);
+
+// Standard CRC-32 (IEEE), continued from a previous value (start with 0)
+uint32_t crc32_update(uint32_t crc, const void* data, size_t size);
+
+// --- Shared File Helpers ---
+//
+// Every model file is a ModelHeader, the architecture and a run of blocks
+// covered by the header's CRC. The quantized, binarized, sparse and codebook
+// formats and the checkpoint file are all written with these.
+
+// Write or read `size` bytes and fold them into the running CRC
+int model_write_block(FILE* file, const void* data, size_t size, uint32_t* crc);
+int model_read_block(FILE* file, void* data, size_t size, uint32_t* crc);
+
+// Writes the architecture as int32 values, or reads it back. The result of
+// model_read_architecture is malloc'd and NULL unless every size is positive.
+int model_write_architecture(FILE* file, int num_layers, const int* architecture, uint32_t* crc);
+int* model_read_architecture(FILE* file, int num_layers, uint32_t* crc);
+
+// Fills in every header field except crc32
+void model_header_init(ModelHeader* header, uint32_t magic, uint8_t dtype, int num_layers, uint64_t file_size);
+
+// Writes the header at the start of the file. Formats write it once as a
+// placeholder and again when the CRC is known.
+int model_write_header(FILE* file, const ModelHeader* header);
+
+// Checks the magic, byte order, version, dtype and layer count
+int model_header_valid(const ModelHeader* header, uint32_t magic, uint8_t dtype);
+int model_read_header(FILE* file, ModelHeader* header, uint32_t magic, uint8_t dtype);
+
+// Opens `<filepath>.tmp` for writing. model_commit_file closes it and renames
+// it into place if `ok`, or removes it otherwise, so a failed or interrupted
+// save never replaces the previous file. It always frees tmp_path.
+FILE* model_create_file(const char* filepath, char** tmp_path);
+int model_commit_file(FILE* file, char* tmp_path, const char* filepath, int ok);
+
+#endif // MODEL_FORMAT_H
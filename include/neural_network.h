@@ -5,24 +5,30 @@
 
 // --- Struct Definitions ---
 
-// Represents a 2D matrix
+// Represents a 2D matrix. Rows are stored back to back in one block, so
+// data[0] points at rows * cols contiguous values.
 typedef struct {
     int rows;
     int cols;
     double** data;
+    int owns_data; // 0 for views over memory owned by someone else
 } Matrix;
 
+struct SparseWeights; // See sparse_network.h
+
 // Represents a feedforward neural network
 typedef struct {
     int num_layers;
     int* architecture; // Array of layer sizes, e.g., [3, 5, 2]
     Matrix** weights;   // Array of weight matrices
     Matrix** biases;    // Array of bias matrices (vectors)
+    struct SparseWeights* sparse; // CSR copy of pruned weights, or NULL
 } NeuralNetwork;
 
 // --- Matrix Operations ---
 
 Matrix* create_matrix(int rows, int cols);
+Matrix* create_matrix_view(int rows, int cols, double* buffer);
 void free_matrix(Matrix* m);
 void print_matrix(const Matrix* m);
 Matrix* dot_product(const Matrix* m1, const Matrix* m2);
@@ -32,13 +38,27 @@ void apply_sigmoid(Matrix* m);
 // --- Neural Network Operations ---
 
 NeuralNetwork* create_neural_network(int num_layers, const int* architecture);
+// Skips initialize_network and its rand() calls, for callers that fill in
+// every parameter themselves
+NeuralNetwork* create_zeroed_network(int num_layers, const int* architecture);
 void free_neural_network(NeuralNetwork* net);
 void initialize_network(NeuralNetwork* net);
 Matrix* forward_pass(const NeuralNetwork* net, const Matrix* input);
 void mutate_network(NeuralNetwork* net, float mutation_rate, float mutation_chance);
 NeuralNetwork* clone_network(const NeuralNetwork* src_net);
 
+// Flat parameter vectors: each layer's weights ([in][out]) followed by its
+// biases, layer by layer
+size_t network_num_params(const NeuralNetwork* net);
+void flatten_network(const NeuralNetwork* net, double* params);
+void unflatten_network(NeuralNetwork* net, const double* params);
+
+// Saves in the binary model format (see model_format.h). load_network
+// detects the format, so older text files and pruned sparse models
+// (see sparse_network.h) still load.
 int save_network(const NeuralNetwork* net, const char* filepath);
 NeuralNetwork* load_network(const char* filepath);
+int save_network_text(const NeuralNetwork* net, const char* filepath);
+NeuralNetwork* load_network_text(const char* filepath);
 
 #endif // NEURAL_NETWORK_H
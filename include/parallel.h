@@ -0,0 +1,18 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Body of a parallel loop: processes items [begin, end) with the shared context
+typedef void (*ParallelBody)(int begin, int end, void* context);
+
+// --- Parallel Helpers ---
+
+// Number of worker threads to use. Defaults to the number of online cores and
+// can be overridden with the GENNET_THREADS environment variable.
+int parallel_num_threads(void);
+
+// Splits [0, count) into contiguous slices, one per thread, and runs body on
+// each slice. Slices smaller than min_chunk are merged, so small loops run on
+// the calling thread. Returns once every slice has finished.
+void parallel_for(int count, int min_chunk, ParallelBody body, void* context);
+
+#endif // PARALLEL_H
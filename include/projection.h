@@ -0,0 +1,44 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <stdint.h>
+#include "data_loader.h"
+
+#define PROJECTION_MAGIC 0x4A525047 // "GPRJ" little-endian
+#define PROJECTION_VERSION 1
+
+typedef enum {
+    PROJECTION_PCA = 1,
+    PROJECTION_RANDOM = 2
+} ProjectionKind;
+
+// A linear input reduction y = (x - mean) * basis, fitted once and applied to
+// every sample before it reaches the network
+typedef struct {
+    int kind;
+    int input_size;
+    int output_size;
+    double* mean;  // input_size values; all zero for random projections
+    Matrix* basis; // input_size x output_size
+} Projection;
+
+// --- Projection Functions ---
+
+// Fits the top `components` principal components on the first max_samples
+// items of a dataset (all items if max_samples <= 0)
+Projection* fit_pca(const Dataset* dataset, int components, int max_samples);
+
+// Seeded Gaussian random projection scaled by 1/sqrt(output_size)
+Projection* create_random_projection(int input_size, int output_size, uint64_t seed);
+
+// Projects one input row into output_size values
+void project_row(const Projection* projection, const double* input, double* output);
+
+// Returns a new dataset holding the projected images and copied labels
+Dataset* project_dataset(const Projection* projection, const Dataset* dataset);
+
+int save_projection(const Projection* projection, const char* filepath);
+Projection* load_projection(const char* filepath);
+void free_projection(Projection* projection);
+
+#endif // PROJECTION_H
@@ -0,0 +1,78 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <stdint.h>
+#include "neural_network.h"
+
+// Rows of quantized weights are padded with zeros to a multiple of this
+// many inputs so every SIMD kernel runs whole vectors
+#define QUANT_ROW_ALIGNMENT 64
+
+// Activations are quantized to 0..QUANT_ACTIVATION_MAX. Keeping them to 7
+// bits means a pmaddubsw pair sum (2 * 127 * 127) can never saturate, so
+// all kernels produce identical int32 accumulators.
+#define QUANT_ACTIVATION_MAX 127
+
+// A network with per-output-channel symmetric int8 weights. Each layer
+// accumulates uint8 activations times int8 weights in int32, rescales the
+// sum to float, adds the bias and requantizes the sigmoid output for the
+// next layer. The first layer's inputs are quantized per sample from their
+// observed range; hidden activations use the fixed sigmoid range [0, 1].
+typedef struct {
+    int num_layers;
+    int* architecture;
+    int* padded_inputs;  // Per layer: inputs rounded up to QUANT_ROW_ALIGNMENT
+    int8_t** weights;    // Per layer: outputs rows of padded_inputs values
+    float** scales;      // Per layer and output channel: weight = q * scale
+    float** biases;
+    float** row_sums;    // Per layer and output channel: sum of dequantized weights
+    uint8_t* quantized;  // Scratch: quantized activations of the current layer
+    float* scratch[2];   // Scratch: float activations, ping-pong
+} QuantizedNetwork;
+
+// --- Quantization ---
+
+QuantizedNetwork* quantize_network(const NeuralNetwork* net);
+void free_quantized_network(QuantizedNetwork* qnet);
+
+// Quantized models use the binary model header with their own magic and a
+// dtype of MODEL_DTYPE_INT8. The CRC covers everything after the header.
+int save_quantized_network(const QuantizedNetwork* qnet, const char* filepath);
+QuantizedNetwork* load_quantized_network(const char* filepath);
+
+// Bytes of parameters held by the quantized network, excluding scratch
+size_t quantized_network_size(const QuantizedNetwork* qnet);
+
+// --- Integer Genomes ---
+
+// Weights of an evolved int8 genome span this many times the largest
+// initial weight of their layer
+#define GENOME_RANGE_FACTOR 4.0
+
+// Largest bias of an integer genome, in units of its layer's weight scale
+#define GENOME_BIAS_LIMIT 32767
+
+// Creates a randomly initialized network for integer-genome evolution.
+// Every output channel of a layer shares one fixed scale, so weights are
+// plain int8 steps and biases int16 steps of that scale.
+QuantizedNetwork* create_quantized_genome(int num_layers, const int* architecture);
+QuantizedNetwork* clone_quantized_network(const QuantizedNetwork* src);
+
+// Recomputes the cached per-channel weight sums after weights change
+void update_quantized_row_sums(QuantizedNetwork* qnet);
+
+// --- Quantized Inference ---
+
+// Writes the output activations for one input row. Scratch buffers make
+// this allocation-free but not shareable between threads.
+void quantized_forward(QuantizedNetwork* qnet, const double* input, double* output);
+
+// Returns the class with the largest output logit
+int quantized_predict(QuantizedNetwork* qnet, const double* input);
+
+// Name of the dot-product kernel in use: "vnni", "avx2" or "scalar". The
+// fastest supported one is picked on first use unless GENNET_INT8_KERNEL
+// names another.
+const char* quantized_kernel_name(void);
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,32 @@
+#ifndef RIDGE_H
+#define RIDGE_H
+
+#include "neural_network.h"
+#include "data_loader.h"
+
+// Default ridge penalty. Activations of a hidden layer drawn by
+// initialize_network are strongly correlated, so the normal equations are
+// badly conditioned and larger penalties cost accuracy.
+#define RIDGE_DEFAULT_LAMBDA 0.01
+
+// --- Linear Algebra ---
+
+// Solves A X = B for symmetric positive definite A (n x n, row-major) and
+// nrhs right-hand sides (B is n x nrhs, row-major). A is overwritten with
+// its Cholesky factor and B with the solution. Returns 0 if A is not
+// positive definite.
+int cholesky_solve(double* a, int n, double* b, int nrhs);
+
+// --- Closed-Form Output Layer ---
+
+// Extreme-learning-machine fit: keeps every layer but the last as it is,
+// computes the last hidden layer's activations H for the first num_samples
+// records, and sets the output layer to the ridge regression of the one-hot
+// labels on [H, 1]:
+//     W = (H^T H + lambda I)^-1 H^T T
+// The bias column is not penalised. The outputs are fitted before the
+// sigmoid, which leaves the predicted class unchanged. Returns 1 on
+// success, 0 on failure.
+int fit_output_layer(NeuralNetwork* net, const Dataset* dataset, int num_samples, double lambda);
+
+#endif // RIDGE_H
@@ -0,0 +1,26 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small explicit-state random number generator (SplitMix64). Unlike rand()
+// its state can be copied, saved and split into independent streams, which
+// makes seeded results reproducible across threads.
+typedef struct {
+    uint64_t state;
+} Rng;
+
+// --- RNG Functions ---
+
+void rng_seed(Rng* rng, uint64_t seed);
+
+// Seeds an independent stream: the same (seed, stream) pair always produces
+// the same sequence, whichever thread draws from it.
+void rng_seed_stream(Rng* rng, uint64_t seed, uint64_t stream);
+
+uint64_t rng_next(Rng* rng);
+double rng_uniform(Rng* rng);        // Uniform in [0, 1)
+double rng_gaussian(Rng* rng);       // Standard normal
+uint32_t rng_below(Rng* rng, uint32_t bound); // Uniform in [0, bound)
+
+#endif // RNG_H
@@ -0,0 +1,76 @@
+#ifndef SPARSE_NETWORK_H
+#define SPARSE_NETWORK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "neural_network.h"
+
+// One layer's nonzero weights in compressed sparse row form. Rows are output
+// neurons, so each row is the short list of inputs that neuron still reads.
+typedef struct {
+    int rows;          // Outputs
+    int cols;          // Inputs
+    int nnz;
+    int32_t* row_ptr;  // rows + 1 offsets into col_idx and values
+    int32_t* col_idx;
+    double* values;
+} CsrMatrix;
+
+// CSR copies of every weight matrix of a pruned network. Biases stay in the
+// dense network.
+typedef struct SparseWeights {
+    int num_layers;
+    CsrMatrix* layers; // num_layers - 1 entries
+} SparseWeights;
+
+typedef enum {
+    PRUNE_GLOBAL = 0,   // One magnitude threshold across all layers
+    PRUNE_PER_LAYER = 1 // Every layer pruned to the target sparsity
+} PruneScope;
+
+// --- Pruning ---
+
+// Zeroes the smallest-magnitude weights until `sparsity` (0..1) of them are
+// zero. Biases are kept. Drops any stale sparse copy. Returns the fraction
+// of weights that are zero afterwards.
+double prune_network(NeuralNetwork* net, double sparsity, PruneScope scope);
+
+// Fraction of weights that are exactly zero
+double network_sparsity(const NeuralNetwork* net);
+
+// --- Sparse Weights ---
+
+SparseWeights* build_sparse_weights(const NeuralNetwork* net);
+void free_sparse_weights(SparseWeights* sparse);
+size_t sparse_weights_nnz(const SparseWeights* sparse);
+
+// Builds a CSR copy of the current weights and attaches it as net->sparse,
+// after which forward_pass only visits nonzero weights. Returns 1 on success.
+// mutate_network detaches the copy, since it would no longer match.
+int attach_sparse_weights(NeuralNetwork* net);
+void detach_sparse_weights(NeuralNetwork* net);
+
+// --- Sparse Inference ---
+
+// Doubles of scratch space the single-sample functions need
+int sparse_scratch_size(const NeuralNetwork* net);
+
+// One sample through the CSR kernels: sigmoid outputs like forward_pass.
+// Requires net->sparse.
+void sparse_forward(const NeuralNetwork* net, const double* input, double* output, double* scratch);
+
+// Class with the largest output logit, like predict_class
+int sparse_predict(const NeuralNetwork* net, const double* input, double* scratch);
+
+// --- Sparse Model Files ---
+//
+// The binary model header with SPARSE_MODEL_MAGIC, the architecture, then
+// per layer: nnz, row_ptr, col_idx and values of the CSR weights followed by
+// the dense biases. The CRC covers everything after the header.
+
+int save_network_sparse(const NeuralNetwork* net, const char* filepath);
+
+// Returns a dense network with the CSR weights attached
+NeuralNetwork* load_network_sparse(const char* filepath);
+
+#endif // SPARSE_NETWORK_H
@@ -0,0 +1,24 @@
+#ifndef SPECIALIZED_FORWARD_H
+#define SPECIALIZED_FORWARD_H
+
+#include "neural_network.h"
+
+// Architectures that get a forward kernel with every layer size fixed at
+// compile time, as X(inputs, hidden, outputs). Add an entry to compile in
+// another specialization; networks of any other shape use the generic path.
+#define SPECIALIZED_ARCHITECTURES(X) \
+    X(784, 128, 10)                  \
+    X(784, 64, 10)                   \
+    X(784, 256, 10)                  \
+    X(50, 128, 10)                   \
+    X(100, 128, 10)
+
+// Computes `rows` output rows of `net` from row-major inputs into `output`
+typedef void (*ForwardKernel)(const NeuralNetwork* net, const double* input, double* output, int rows);
+
+// --- Registry ---
+
+// Returns the kernel compiled for this architecture, or NULL if there is none
+ForwardKernel find_forward_kernel(int num_layers, const int* architecture);
+
+#endif // SPECIALIZED_FORWARD_H
@@ -0,0 +1,49 @@
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <stdint.h>
+#include "evolution.h"
+#include "data_loader.h"
+
+// Steady-state evolution replaces generations with a single population that
+// changes one network at a time. Every worker thread repeatedly picks two
+// parents by tournament, breeds and scores a child, and puts it in place of
+// the current worst network if it is at least as fit. Workers never wait for
+// each other to finish scoring: the population sits behind a read-write
+// lock that is held only to pick parents and to insert a child.
+
+typedef struct {
+    int population;
+    long evaluations;        // Children to breed and score in total
+    int tournament_size;     // Contestants drawn for each parent
+    float mutation_rate;
+    float mutation_chance;
+    int num_samples;         // Records each network is scored on
+    int threads;             // Worker threads
+    uint64_t seed;           // Thread t draws from stream t of this seed
+    long report_every;       // Print progress every N children; 0 is quiet
+} SteadyStateConfig;
+
+// Defaults: 50 networks, 5000 children (the generational loop's budget),
+// tournaments of 3, main's mutation settings, parallel_num_threads()
+// workers and no progress output
+void default_steady_state_config(SteadyStateConfig* config);
+
+typedef struct {
+    double initial_best_fitness;
+    double best_fitness;
+    long evaluations;        // Children scored
+    long insertions;         // Children that replaced a network
+    double seconds;          // Wall time after the initial population was scored
+    double lock_wait_seconds; // Summed over workers: time spent waiting for the lock
+} SteadyStateStats;
+
+// Scores a fresh population of the given architecture on the first
+// config->num_samples records, then runs the workers until the budget is
+// spent. Returns a copy of the fittest network, or NULL on failure. Only
+// the worst network is ever replaced, so the best fitness never drops and
+// the returned network is the best one seen.
+NeuralNetwork* run_steady_state(const SteadyStateConfig* config, int num_layers, const int* architecture,
+                                const Dataset* dataset, SteadyStateStats* stats, double* best_fitness);
+
+#endif // STEADY_STATE_H
@@ -0,0 +1,27 @@
+#ifndef SYNTHETIC_DATASET_H
+#define SYNTHETIC_DATASET_H
+
+#include <stdint.h>
+#include "data_loader.h"
+
+// Parameters of a generated dataset
+typedef struct {
+    int num_items;
+    int input_size;        // Values per sample
+    int num_classes;       // At most 256
+    double sparsity;       // Fraction of input values forced to zero, in [0, 1)
+    int clustered;         // 1: Gaussian clusters around per-class centers; 0: uniform noise
+    double cluster_spread; // Standard deviation around the class center
+    uint64_t seed;
+} SyntheticConfig;
+
+// --- Synthetic Dataset Functions ---
+
+// Returns a config matching MNIST's shape with learnable clusters
+SyntheticConfig default_synthetic_config(int num_items, uint64_t seed);
+
+// Generates a dataset in parallel. Every sample is drawn from its own RNG
+// stream, so the result depends only on the config, not on the thread count.
+Dataset* create_synthetic_dataset(const SyntheticConfig* config);
+
+#endif // SYNTHETIC_DATASET_H
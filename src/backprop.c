@@ -0,0 +1,347 @@
+#include "backprop.h"
+#include "parallel.h"
+#include "sparse_network.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Shards smaller than this are not worth a thread of their own
+#define MIN_SHARD_ROWS 16
+
+// Keeps log() finite when a sigmoid output saturates
+#define LOSS_CLAMP 1e-12
+
+// Per-thread workspace for one slice of a mini-batch
+struct TrainerShard {
+    double** activations; // Per layer: rows x width; layer 0 points into the gathered batch
+    double* delta;        // rows x widest layer
+    double* delta_next;
+    double* gradients;    // Summed (not averaged) over the shard's rows
+    double loss;
+};
+
+// --- Activations ---
+
+double activate(Activation activation, double x) {
+    switch (activation) {
+    case ACTIVATION_TANH: return tanh(x);
+    case ACTIVATION_RELU: return x > 0.0 ? x : 0.0;
+    default: return 1.0 / (1.0 + exp(-x));
+    }
+}
+
+double activation_derivative(Activation activation, double y) {
+    switch (activation) {
+    case ACTIVATION_TANH: return 1.0 - y * y;
+    case ACTIVATION_RELU: return y > 0.0 ? 1.0 : 0.0;
+    default: return y * (1.0 - y);
+    }
+}
+
+// --- Setup ---
+
+void default_trainer_config(TrainerConfig* config, OptimizerKind optimizer) {
+    memset(config, 0, sizeof(*config));
+    config->optimizer = optimizer;
+    config->learning_rate = optimizer == OPTIMIZER_ADAM ? 0.001 : optimizer == OPTIMIZER_MOMENTUM ? 0.1 : 0.5;
+    config->momentum = 0.9;
+    config->beta1 = 0.9;
+    config->beta2 = 0.999;
+    config->epsilon = 1e-8;
+    config->batch_size = 64;
+    config->hidden_activation = ACTIVATION_SIGMOID;
+}
+
+void initialize_network_for_training(NeuralNetwork* net, Rng* rng) {
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        Matrix* weights = net->weights[l];
+        double limit = sqrt(6.0 / (net->architecture[l] + net->architecture[l + 1]));
+        for (int k = 0; k < weights->rows; k++) {
+            for (int j = 0; j < weights->cols; j++) {
+                weights->data[k][j] = (2.0 * rng_uniform(rng) - 1.0) * limit;
+            }
+        }
+        memset(net->biases[l]->data[0], 0, net->architecture[l + 1] * sizeof(double));
+    }
+    detach_sparse_weights(net);
+}
+
+// Offset of layer l's weights in the flat parameter order; its biases follow
+static size_t layer_offset(const NeuralNetwork* net, int l) {
+    size_t offset = 0;
+    for (int i = 0; i < l; i++) {
+        offset += ((size_t)net->architecture[i] + 1) * net->architecture[i + 1];
+    }
+    return offset;
+}
+
+static void free_shards(Trainer* trainer) {
+    if (!trainer->shards) return;
+    for (int s = 0; s < trainer->num_shards; s++) {
+        struct TrainerShard* shard = &trainer->shards[s];
+        if (shard->activations) {
+            for (int l = 1; l < trainer->net->num_layers; l++) free(shard->activations[l]);
+        }
+        free(shard->activations);
+        free(shard->delta);
+        free(shard->delta_next);
+        free(shard->gradients);
+    }
+    free(trainer->shards);
+    trainer->shards = NULL;
+}
+
+Trainer* create_trainer(NeuralNetwork* net, const TrainerConfig* config) {
+    if (config->batch_size < 1 || config->learning_rate <= 0.0) {
+        fprintf(stderr, "Training needs a positive batch size and learning rate.\n");
+        return NULL;
+    }
+    Trainer* trainer = (Trainer*)calloc(1, sizeof(Trainer));
+    if (!trainer) return NULL;
+    trainer->net = net;
+    trainer->config = *config;
+    trainer->num_params = layer_offset(net, net->num_layers - 1);
+
+    // Rows per shard are at most ceil(batch / shards)
+    int batch_size = config->batch_size;
+    int shards = parallel_num_threads();
+    if (shards > batch_size / MIN_SHARD_ROWS) shards = batch_size / MIN_SHARD_ROWS;
+    if (shards < 1) shards = 1;
+    int shard_rows = (batch_size + shards - 1) / shards;
+    int widest = 0;
+    for (int l = 0; l < net->num_layers; l++) {
+        if (net->architecture[l] > widest) widest = net->architecture[l];
+    }
+
+    trainer->num_shards = shards;
+    trainer->gradients = (double*)calloc(trainer->num_params, sizeof(double));
+    trainer->velocity = (double*)calloc(trainer->num_params, sizeof(double));
+    if (config->optimizer == OPTIMIZER_ADAM) {
+        trainer->second_moment = (double*)calloc(trainer->num_params, sizeof(double));
+    }
+    trainer->batch = (double*)malloc((size_t)batch_size * net->architecture[0] * sizeof(double));
+    trainer->labels = (unsigned char*)malloc(batch_size);
+    trainer->shards = (struct TrainerShard*)calloc(shards, sizeof(struct TrainerShard));
+    int ok = trainer->gradients && trainer->velocity && trainer->batch && trainer->labels && trainer->shards &&
+             (config->optimizer != OPTIMIZER_ADAM || trainer->second_moment);
+    for (int s = 0; ok && s < shards; s++) {
+        struct TrainerShard* shard = &trainer->shards[s];
+        shard->activations = (double**)calloc(net->num_layers, sizeof(double*));
+        shard->delta = (double*)malloc((size_t)shard_rows * widest * sizeof(double));
+        shard->delta_next = (double*)malloc((size_t)shard_rows * widest * sizeof(double));
+        shard->gradients = (double*)malloc(trainer->num_params * sizeof(double));
+        ok = shard->activations && shard->delta && shard->delta_next && shard->gradients;
+        for (int l = 1; ok && l < net->num_layers; l++) {
+            shard->activations[l] = (double*)malloc((size_t)shard_rows * net->architecture[l] * sizeof(double));
+            ok = shard->activations[l] != NULL;
+        }
+    }
+    if (!ok) {
+        free_trainer(trainer);
+        return NULL;
+    }
+
+    // Pruned zeros are not preserved once training moves the weights
+    detach_sparse_weights(net);
+    return trainer;
+}
+
+void free_trainer(Trainer* trainer) {
+    if (!trainer) return;
+    free_shards(trainer);
+    free(trainer->gradients);
+    free(trainer->velocity);
+    free(trainer->second_moment);
+    free(trainer->batch);
+    free(trainer->labels);
+    free(trainer);
+}
+
+// --- Backward Pass ---
+
+typedef struct {
+    Trainer* trainer;
+    int count;
+} BatchContext;
+
+// Forward and backward pass over rows [begin, end) of the gathered batch.
+// Each product is written row by row so the inner loop runs over contiguous
+// outputs, and zero activations (most MNIST pixels) are skipped.
+static void run_shard(Trainer* trainer, struct TrainerShard* shard, int begin, int end) {
+    const NeuralNetwork* net = trainer->net;
+    int rows = end - begin;
+    int last = net->num_layers - 2;
+    Activation hidden = trainer->config.hidden_activation;
+    memset(shard->gradients, 0, trainer->num_params * sizeof(double));
+    shard->loss = 0.0;
+    if (rows <= 0) return;
+    shard->activations[0] = trainer->batch + (size_t)begin * net->architecture[0];
+
+    for (int l = 0; l <= last; l++) {
+        int inputs = net->architecture[l], outputs = net->architecture[l + 1];
+        const double* weights = net->weights[l]->data[0];
+        const double* biases = net->biases[l]->data[0];
+        Activation activation = l == last ? ACTIVATION_SIGMOID : hidden;
+        for (int i = 0; i < rows; i++) {
+            const double* a = shard->activations[l] + (size_t)i * inputs;
+            double* z = shard->activations[l + 1] + (size_t)i * outputs;
+            memcpy(z, biases, outputs * sizeof(double));
+            for (int k = 0; k < inputs; k++) {
+                double value = a[k];
+                if (value == 0.0) continue;
+                const double* w = weights + (size_t)k * outputs;
+                for (int j = 0; j < outputs; j++) z[j] += value * w[j];
+            }
+            for (int j = 0; j < outputs; j++) z[j] = activate(activation, z[j]);
+        }
+    }
+
+    // Sigmoid outputs with binary cross-entropy: the output delta is y - t
+    int classes = net->architecture[last + 1];
+    double* delta = shard->delta;
+    for (int i = 0; i < rows; i++) {
+        const double* y = shard->activations[last + 1] + (size_t)i * classes;
+        int label = trainer->labels[begin + i];
+        for (int j = 0; j < classes; j++) {
+            double target = j == label ? 1.0 : 0.0;
+            double p = fmin(fmax(y[j], LOSS_CLAMP), 1.0 - LOSS_CLAMP);
+            shard->loss -= target * log(p) + (1.0 - target) * log(1.0 - p);
+            delta[(size_t)i * classes + j] = y[j] - target;
+        }
+    }
+
+    for (int l = last; l >= 0; l--) {
+        int inputs = net->architecture[l], outputs = net->architecture[l + 1];
+        const double* weights = net->weights[l]->data[0];
+        double* weight_gradients = shard->gradients + layer_offset(net, l);
+        double* bias_gradients = weight_gradients + (size_t)inputs * outputs;
+        for (int i = 0; i < rows; i++) {
+            const double* a = shard->activations[l] + (size_t)i * inputs;
+            const double* d = delta + (size_t)i * outputs;
+            for (int k = 0; k < inputs; k++) {
+                double value = a[k];
+                if (value == 0.0) continue;
+                double* g = weight_gradients + (size_t)k * outputs;
+                for (int j = 0; j < outputs; j++) g[j] += value * d[j];
+            }
+            for (int j = 0; j < outputs; j++) bias_gradients[j] += d[j];
+        }
+        if (l == 0) break;
+
+        // Propagate through W^T and the hidden activation
+        double* previous = shard->delta_next;
+        for (int i = 0; i < rows; i++) {
+            const double* a = shard->activations[l] + (size_t)i * inputs;
+            const double* d = delta + (size_t)i * outputs;
+            double* p = previous + (size_t)i * inputs;
+            for (int k = 0; k < inputs; k++) {
+                const double* w = weights + (size_t)k * outputs;
+                double sum = 0.0;
+                for (int j = 0; j < outputs; j++) sum += d[j] * w[j];
+                p[k] = sum * activation_derivative(hidden, a[k]);
+            }
+        }
+        shard->delta_next = delta;
+        shard->delta = previous;
+        delta = previous;
+    }
+}
+
+static void batch_body(int begin, int end, void* context) {
+    BatchContext* batch = (BatchContext*)context;
+    Trainer* trainer = batch->trainer;
+    for (int s = begin; s < end; s++) {
+        int first = (int)((long)batch->count * s / trainer->num_shards);
+        int last = (int)((long)batch->count * (s + 1) / trainer->num_shards);
+        run_shard(trainer, &trainer->shards[s], first, last);
+    }
+}
+
+double compute_batch_gradients(Trainer* trainer, const Dataset* dataset, const int* indices, int count) {
+    if (count > trainer->config.batch_size) count = trainer->config.batch_size;
+    if (count <= 0) return 0.0;
+    int width = trainer->net->architecture[0];
+    for (int i = 0; i < count; i++) {
+        memcpy(trainer->batch + (size_t)i * width, dataset->images->data[indices[i]], width * sizeof(double));
+        trainer->labels[i] = dataset->label_indices[indices[i]];
+    }
+
+    BatchContext context = {trainer, count};
+    parallel_for(trainer->num_shards, 1, batch_body, &context);
+
+    double loss = 0.0;
+    double scale = 1.0 / count;
+    memcpy(trainer->gradients, trainer->shards[0].gradients, trainer->num_params * sizeof(double));
+    for (int s = 1; s < trainer->num_shards; s++) {
+        const double* gradients = trainer->shards[s].gradients;
+        for (size_t p = 0; p < trainer->num_params; p++) trainer->gradients[p] += gradients[p];
+    }
+    for (size_t p = 0; p < trainer->num_params; p++) trainer->gradients[p] *= scale;
+    for (int s = 0; s < trainer->num_shards; s++) loss += trainer->shards[s].loss;
+    return loss * scale;
+}
+
+// --- Optimizer Step ---
+
+// Updates one contiguous block of parameters whose state starts at offset
+static void update_block(Trainer* trainer, double* params, size_t count, size_t offset) {
+    const TrainerConfig* config = &trainer->config;
+    const double* gradients = trainer->gradients + offset;
+    double* velocity = trainer->velocity + offset;
+    double rate = config->learning_rate;
+    if (config->optimizer == OPTIMIZER_SGD) {
+        for (size_t p = 0; p < count; p++) params[p] -= rate * gradients[p];
+    } else if (config->optimizer == OPTIMIZER_MOMENTUM) {
+        for (size_t p = 0; p < count; p++) {
+            velocity[p] = config->momentum * velocity[p] + gradients[p];
+            params[p] -= rate * velocity[p];
+        }
+    } else {
+        // Bias correction folded into the step size
+        double* second = trainer->second_moment + offset;
+        double correction1 = 1.0 - pow(config->beta1, (double)trainer->step);
+        double correction2 = 1.0 - pow(config->beta2, (double)trainer->step);
+        double step = rate * sqrt(correction2) / correction1;
+        for (size_t p = 0; p < count; p++) {
+            double g = gradients[p];
+            velocity[p] = config->beta1 * velocity[p] + (1.0 - config->beta1) * g;
+            second[p] = config->beta2 * second[p] + (1.0 - config->beta2) * g * g;
+            params[p] -= step * velocity[p] / (sqrt(second[p]) + config->epsilon);
+        }
+    }
+}
+
+void apply_optimizer_step(Trainer* trainer) {
+    NeuralNetwork* net = trainer->net;
+    trainer->step++;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        size_t offset = layer_offset(net, l);
+        size_t weights = (size_t)net->architecture[l] * net->architecture[l + 1];
+        update_block(trainer, net->weights[l]->data[0], weights, offset);
+        update_block(trainer, net->biases[l]->data[0], net->architecture[l + 1], offset + weights);
+    }
+}
+
+double train_epoch(Trainer* trainer, const Dataset* dataset, int num_samples, Rng* rng) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    int* order = (int*)malloc(num_samples * sizeof(int));
+    if (!order) return 0.0;
+    for (int i = 0; i < num_samples; i++) order[i] = i;
+    for (int i = num_samples - 1; i > 0; i--) {
+        int j = (int)rng_below(rng, (uint32_t)(i + 1));
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    double total_loss = 0.0;
+    int batch_size = trainer->config.batch_size;
+    for (int start = 0; start < num_samples; start += batch_size) {
+        int count = num_samples - start < batch_size ? num_samples - start : batch_size;
+        total_loss += compute_batch_gradients(trainer, dataset, order + start, count) * count;
+        apply_optimizer_step(trainer);
+    }
+    free(order);
+    return num_samples > 0 ? total_loss / num_samples : 0.0;
+}
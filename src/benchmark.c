@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "neural_network.h"
+#include "data_loader.h"
+#include "synthetic_dataset.h"
+#include "parallel.h"
+#include "inference.h"
+#include "quantization.h"
+#include "half_network.h"
+#include "binarized_network.h"
+#include "codebook.h"
+#include "sparse_network.h"
+
+// --- Helpers ---
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Order-sensitive checksum of a dataset, used to confirm runs are reproducible
+static unsigned long long dataset_checksum(const Dataset* dataset) {
+    unsigned long long hash = 1469598103934665603ULL;
+    size_t num_values = (size_t)dataset->num_items * dataset->images->cols;
+    const double* values = dataset->num_items > 0 ? dataset->images->data[0] : NULL;
+    for (size_t i = 0; i < num_values; i++) {
+        unsigned long long bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ULL;
+    }
+    for (int i = 0; i < dataset->num_items; i++) {
+        hash = (hash ^ dataset->label_indices[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// --- Benchmarks ---
+
+// Generates a synthetic dataset and times generation and batched forward passes
+static int bench_dataset(int argc, char* argv[]) {
+    SyntheticConfig config = default_synthetic_config(100000, 42);
+    int hidden = 128;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--items") == 0 && i + 1 < argc) config.num_items = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--inputs") == 0 && i + 1 < argc) config.input_size = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--classes") == 0 && i + 1 < argc) config.num_classes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hidden") == 0 && i + 1 < argc) hidden = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sparsity") == 0 && i + 1 < argc) config.sparsity = atof(argv[++i]);
+        else if (strcmp(argv[i], "--spread") == 0 && i + 1 < argc) config.cluster_spread = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) config.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--uniform") == 0) config.clustered = 0;
+        else {
+            fprintf(stderr, "Unknown dataset option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    printf("Synthetic dataset: %d items x %d inputs, %d classes, sparsity %.2f, %s, seed %llu\n",
+           config.num_items, config.input_size, config.num_classes, config.sparsity,
+           config.clustered ? "clustered" : "uniform", (unsigned long long)config.seed);
+    printf("Threads: %d\n", parallel_num_threads());
+
+    double start = now_seconds();
+    Dataset* dataset = create_synthetic_dataset(&config);
+    double elapsed = now_seconds() - start;
+    if (!dataset) return 1;
+    printf("Generation: %.3f s (%.0f samples/s)\n", elapsed, config.num_items / elapsed);
+    printf("Checksum: %016llx\n", dataset_checksum(dataset));
+
+    // Time batched forward passes of a random network over the whole set
+    int architecture[] = {config.input_size, hidden, config.num_classes};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    const int batch_size = 1024;
+    start = now_seconds();
+    for (int first = 0; first < dataset->num_items; first += batch_size) {
+        int rows = dataset->num_items - first < batch_size ? dataset->num_items - first : batch_size;
+        Matrix* batch = create_matrix_view(rows, config.input_size, dataset->images->data[first]);
+        Matrix* output = forward_pass(net, batch);
+        free_matrix(output);
+        free_matrix(batch);
+    }
+    elapsed = now_seconds() - start;
+    printf("Forward [%d, %d, %d]: %.3f s (%.0f samples/s)\n",
+           config.input_size, hidden, config.num_classes, elapsed, dataset->num_items / elapsed);
+
+    free_neural_network(net);
+    free_dataset(dataset);
+    return 0;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts per-call timings and prints their median, tail and mean in microseconds
+static void report_latency(const char* label, double* samples, int count) {
+    double total = 0.0;
+    for (int i = 0; i < count; i++) total += samples[i];
+    qsort(samples, count, sizeof(double), compare_doubles);
+    printf("%-26s p50 %8.2f us  p99 %8.2f us  mean %8.2f us\n", label,
+           samples[count / 2] * 1e6, samples[(int)(count * 0.99)] * 1e6, total / count * 1e6);
+}
+
+// Times single-sample predictions, one call at a time, through forward_pass
+// and through the packed GEMV path
+static int bench_latency(int argc, char* argv[]) {
+    const char* network_filepath = NULL;
+    int iterations = 10000;
+    int prefetch_distance = 8;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) network_filepath = argv[++i];
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc) prefetch_distance = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "Unknown latency option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (iterations <= 0) iterations = 1;
+
+    NeuralNetwork* net = NULL;
+    if (network_filepath) {
+        net = load_network(network_filepath);
+    } else {
+        int architecture[] = {MNIST_IMAGE_SIZE, 128, MNIST_NUM_CLASSES};
+        net = create_neural_network(3, architecture);
+    }
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", network_filepath);
+        return 1;
+    }
+    PackedNetwork* packed = pack_network(net);
+    if (!packed) {
+        free_neural_network(net);
+        return 1;
+    }
+
+    // Cycle through a small pool of inputs so every call sees a different row
+    const int pool_size = 256;
+    SyntheticConfig config = default_synthetic_config(pool_size, 7);
+    config.input_size = net->architecture[0];
+    config.num_classes = net->architecture[net->num_layers - 1];
+    Dataset* inputs = create_synthetic_dataset(&config);
+    double* samples = (double*)malloc(iterations * sizeof(double));
+    if (!inputs || !samples) {
+        free_dataset(inputs);
+        free(samples);
+        free_packed_network(packed);
+        free_neural_network(net);
+        return 1;
+    }
+
+    printf("Network: [");
+    for (int i = 0; i < net->num_layers; i++) {
+        printf("%d%s", net->architecture[i], i == net->num_layers - 1 ? "" : ", ");
+    }
+    printf("], %d single-sample calls\n", iterations);
+
+    int mismatches = 0;
+    for (int i = 0; i < iterations; i++) {
+        Matrix* input = create_matrix_view(1, config.input_size, inputs->images->data[i % pool_size]);
+        double start = now_seconds();
+        Matrix* output = forward_pass(net, input);
+        samples[i] = now_seconds() - start;
+        int expected = 0;
+        for (int j = 1; j < output->cols; j++) {
+            if (output->data[0][j] > output->data[0][expected]) expected = j;
+        }
+        if (predict_class(packed, input->data[0]) != expected) mismatches++;
+        free_matrix(output);
+        free_matrix(input);
+    }
+    report_latency("forward_pass", samples, iterations);
+
+    packed->prefetch_distance = 0;
+    for (int i = 0; i < iterations; i++) {
+        const double* row = inputs->images->data[i % pool_size];
+        double start = now_seconds();
+        volatile int predicted = predict_class(packed, row);
+        samples[i] = now_seconds() - start;
+        (void)predicted;
+    }
+    report_latency("predict_class", samples, iterations);
+
+    if (prefetch_distance > 0) {
+        packed->prefetch_distance = prefetch_distance;
+        for (int i = 0; i < iterations; i++) {
+            const double* row = inputs->images->data[i % pool_size];
+            double start = now_seconds();
+            volatile int predicted = predict_class(packed, row);
+            samples[i] = now_seconds() - start;
+            (void)predicted;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "packed + prefetch %d", prefetch_distance);
+        report_latency(label, samples, iterations);
+    }
+    printf("Prediction mismatches: %d\n", mismatches);
+
+    // The int8 path trades a little accuracy, so report agreement instead of mismatches
+    QuantizedNetwork* qnet = quantize_network(net);
+    if (qnet) {
+        int agreement = 0;
+        for (int i = 0; i < iterations; i++) {
+            const double* row = inputs->images->data[i % pool_size];
+            double start = now_seconds();
+            int predicted = quantized_predict(qnet, row);
+            samples[i] = now_seconds() - start;
+            if (predicted == predict_class(packed, row)) agreement++;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "quantized_predict %s", quantized_kernel_name());
+        report_latency(label, samples, iterations);
+        printf("int8 agreement with float: %.2f%%\n", 100.0 * agreement / iterations);
+        free_quantized_network(qnet);
+    }
+
+    const HalfFormat half_formats[] = {HALF_FP16, HALF_BF16};
+    for (int f = 0; f < 2; f++) {
+        HalfNetwork* half = half_network_from_network(net, half_formats[f]);
+        float* scratch = half ? (float*)malloc(half_network_scratch_size(half) * sizeof(float)) : NULL;
+        if (!scratch) {
+            free_half_network(half);
+            continue;
+        }
+        int agreement = 0;
+        for (int i = 0; i < iterations; i++) {
+            const double* row = inputs->images->data[i % pool_size];
+            double start = now_seconds();
+            int predicted = half_predict(half, row, scratch);
+            samples[i] = now_seconds() - start;
+            if (predicted == predict_class(packed, row)) agreement++;
+        }
+        const char* name = half_formats[f] == HALF_BF16 ? "bf16" : "fp16";
+        char label[64];
+        snprintf(label, sizeof(label), "half_predict %s %s", name, half_kernel_name(half_formats[f]));
+        report_latency(label, samples, iterations);
+        printf("%s agreement with float: %.2f%%\n", name, 100.0 * agreement / iterations);
+        free(scratch);
+        free_half_network(half);
+    }
+
+    // Smallest and largest codebooks, with 4-bit and 8-bit indices
+    const int codebook_sizes[] = {CODEBOOK_MIN_CENTROIDS, CODEBOOK_MAX_CENTROIDS};
+    for (int c = 0; c < 2; c++) {
+        CodebookNetwork* cnet = compress_network(net, codebook_sizes[c]);
+        if (!cnet) continue;
+        int agreement = 0;
+        for (int i = 0; i < iterations; i++) {
+            const double* row = inputs->images->data[i % pool_size];
+            double start = now_seconds();
+            int predicted = codebook_predict(cnet, row);
+            samples[i] = now_seconds() - start;
+            if (predicted == predict_class(packed, row)) agreement++;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "codebook K=%d %s", codebook_sizes[c], codebook_kernel_name());
+        report_latency(label, samples, iterations);
+        printf("K=%d codebook agreement with float: %.2f%%\n", codebook_sizes[c], 100.0 * agreement / iterations);
+        free_codebook_network(cnet);
+    }
+
+    // A binarized network of the same shape; its cost does not depend on the
+    // weight values, so a random genome over thresholded inputs is timed
+    BinarizedNetwork* bnet = create_binarized_genome(net->num_layers, net->architecture);
+    BitDataset* bits = bnet ? binarize_dataset(inputs, MNIST_BINARIZE_THRESHOLD) : NULL;
+    uint64_t* bit_scratch = bits ? (uint64_t*)malloc(binarized_scratch_words(bnet) * sizeof(uint64_t)) : NULL;
+    if (bit_scratch) {
+        for (int i = 0; i < iterations; i++) {
+            const uint64_t* row = bits->bits + (size_t)(i % pool_size) * bits->words_per_item;
+            double start = now_seconds();
+            volatile int predicted = binarized_predict(bnet, row, bit_scratch);
+            samples[i] = now_seconds() - start;
+            (void)predicted;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "binarized_predict %s", binarized_kernel_name());
+        report_latency(label, samples, iterations);
+    }
+    free(bit_scratch);
+    free_bit_dataset(bits);
+    free_binarized_network(bnet);
+
+    free(samples);
+    free_dataset(inputs);
+    free_packed_network(packed);
+    free_neural_network(net);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Prunes copies of one network to increasing sparsity and reports how
+// accuracy on the MNIST test set and CSR prediction latency change
+static int bench_sparsity(int argc, char* argv[]) {
+    const char* network_filepath = "trained_network.dat";
+    int num_samples = 2000;
+    PruneScope scope = PRUNE_GLOBAL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) network_filepath = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) num_samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--per-layer") == 0) scope = PRUNE_PER_LAYER;
+        else {
+            fprintf(stderr, "Unknown sparsity option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    NeuralNetwork* net = load_network(network_filepath);
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", network_filepath);
+        return 1;
+    }
+    if (net->architecture[0] != MNIST_IMAGE_SIZE) {
+        fprintf(stderr, "The sparsity sweep needs a network on raw MNIST pixels.\n");
+        free_neural_network(net);
+        return 1;
+    }
+    // More samples than the test files hold uses all of them
+    int available = count_idx_records("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    if (num_samples > available) num_samples = available;
+    Dataset* test = available > 0 ? load_mnist_range("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte",
+                                                     0, num_samples > 0 ? num_samples : 1)
+                                  : NULL;
+    PackedNetwork* packed = pack_network(net);
+    double* samples = (double*)malloc(test ? test->num_items * sizeof(double) : 1);
+    double* scratch = (double*)malloc(sparse_scratch_size(net) * sizeof(double));
+    if (!test || !packed || !samples || !scratch) {
+        fprintf(stderr, "Failed to set up the sparsity sweep.\n");
+        free(scratch);
+        free(samples);
+        free_packed_network(packed);
+        free_dataset(test);
+        free_neural_network(net);
+        return 1;
+    }
+
+    // The dense packed path is the baseline every row is compared against
+    int dense_correct = 0;
+    for (int i = 0; i < test->num_items; i++) {
+        const double* row = test->images->data[i];
+        double start = now_seconds();
+        int predicted = predict_class(packed, row);
+        samples[i] = now_seconds() - start;
+        dense_correct += predicted == test->label_indices[i];
+    }
+    printf("Network: %s, %d test samples, %s pruning\n", network_filepath, test->num_items,
+           scope == PRUNE_PER_LAYER ? "per-layer" : "global");
+    printf("%-9s %9s %9s  ", "sparsity", "nonzero", "accuracy");
+    report_latency("dense predict_class", samples, test->num_items);
+
+    static const double levels[] = {0.0, 0.5, 0.7, 0.8, 0.9, 0.95, 0.98, 0.99};
+    for (size_t s = 0; s < sizeof(levels) / sizeof(levels[0]); s++) {
+        NeuralNetwork* pruned = clone_network(net);
+        prune_network(pruned, levels[s], scope);
+        if (!attach_sparse_weights(pruned)) {
+            free_neural_network(pruned);
+            continue;
+        }
+        int correct = 0;
+        for (int i = 0; i < test->num_items; i++) {
+            const double* row = test->images->data[i];
+            double start = now_seconds();
+            int predicted = sparse_predict(pruned, row, scratch);
+            samples[i] = now_seconds() - start;
+            correct += predicted == test->label_indices[i];
+        }
+        printf("%8.0f%% %9zu %8.2f%%  ", 100.0 * levels[s], sparse_weights_nnz(pruned->sparse),
+               100.0 * correct / test->num_items);
+        report_latency("sparse_predict", samples, test->num_items);
+        free_neural_network(pruned);
+    }
+    printf("Dense accuracy: %.2f%%\n", 100.0 * dense_correct / test->num_items);
+
+    free(scratch);
+    free(samples);
+    free_packed_network(packed);
+    free_dataset(test);
+    free_neural_network(net);
+    return 0;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s <benchmark> [options]\n"
+            "Benchmarks:\n"
+            "  dataset [--items N] [--inputs D] [--classes C] [--hidden H]\n"
+            "          [--sparsity S] [--spread X] [--seed N] [--uniform]\n"
+            "  latency [--model FILE] [--iterations N] [--prefetch D]\n"
+            "  sparsity [--model FILE] [--samples N] [--per-layer]\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "dataset") == 0) return bench_dataset(argc - 2, argv + 2);
+    if (strcmp(argv[1], "latency") == 0) return bench_latency(argc - 2, argv + 2);
+    if (strcmp(argv[1], "sparsity") == 0) return bench_sparsity(argc - 2, argv + 2);
+
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,363 @@
+#include "binarized_network.h"
+#include "model_format.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+// --- Binarized Network Functions ---
+
+// Bits of the last word of a row that hold real inputs
+static uint64_t last_word_mask(int bits) {
+    return bits % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (bits % 64)) - 1;
+}
+
+// 64 random bits from rand(), which only guarantees 15 bits per call
+static uint64_t random_word(void) {
+    uint64_t word = 0;
+    for (int i = 0; i < 5; i++) word = (word << 15) ^ (uint64_t)(rand() & 0x7FFF);
+    return word;
+}
+
+BinarizedNetwork* create_binarized_network(int num_layers, const int* architecture) {
+    BinarizedNetwork* net = (BinarizedNetwork*)calloc(1, sizeof(BinarizedNetwork));
+    if (!net) return NULL;
+    net->num_layers = num_layers;
+    net->architecture = (int*)malloc(num_layers * sizeof(int));
+    net->words = (int*)malloc(num_layers * sizeof(int));
+    net->weights = (uint64_t**)calloc(num_layers - 1, sizeof(uint64_t*));
+    net->thresholds = (int32_t**)calloc(num_layers - 1, sizeof(int32_t*));
+    if (!net->architecture || !net->words || !net->weights || !net->thresholds) {
+        free_binarized_network(net);
+        return NULL;
+    }
+    for (int l = 0; l < num_layers; l++) {
+        net->architecture[l] = architecture[l];
+        net->words[l] = words_for_bits(architecture[l]);
+    }
+    for (int l = 0; l < num_layers - 1; l++) {
+        net->weights[l] = (uint64_t*)calloc((size_t)architecture[l + 1] * net->words[l], sizeof(uint64_t));
+        net->thresholds[l] = (int32_t*)calloc(architecture[l + 1], sizeof(int32_t));
+        if (!net->weights[l] || !net->thresholds[l]) {
+            free_binarized_network(net);
+            return NULL;
+        }
+    }
+    return net;
+}
+
+BinarizedNetwork* create_binarized_genome(int num_layers, const int* architecture) {
+    BinarizedNetwork* net = create_binarized_network(num_layers, architecture);
+    if (!net) return NULL;
+    for (int l = 0; l < num_layers - 1; l++) {
+        int words = net->words[l];
+        uint64_t mask = last_word_mask(architecture[l]);
+        for (int j = 0; j < architecture[l + 1]; j++) {
+            uint64_t* row = net->weights[l] + (size_t)j * words;
+            for (int w = 0; w < words; w++) row[w] = random_word();
+            row[words - 1] &= mask;
+        }
+    }
+    return net;
+}
+
+BinarizedNetwork* clone_binarized_network(const BinarizedNetwork* src) {
+    BinarizedNetwork* net = create_binarized_network(src->num_layers, src->architecture);
+    if (!net) return NULL;
+    for (int l = 0; l < src->num_layers - 1; l++) {
+        memcpy(net->weights[l], src->weights[l],
+               (size_t)src->architecture[l + 1] * src->words[l] * sizeof(uint64_t));
+        memcpy(net->thresholds[l], src->thresholds[l], src->architecture[l + 1] * sizeof(int32_t));
+    }
+    return net;
+}
+
+void free_binarized_network(BinarizedNetwork* net) {
+    if (!net) return;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        if (net->weights) free(net->weights[l]);
+        if (net->thresholds) free(net->thresholds[l]);
+    }
+    free(net->weights);
+    free(net->thresholds);
+    free(net->words);
+    free(net->architecture);
+    free(net);
+}
+
+size_t binarized_network_size(const BinarizedNetwork* net) {
+    size_t size = 0;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        size += (size_t)net->architecture[l + 1] * (net->words[l] * sizeof(uint64_t) + sizeof(int32_t));
+    }
+    return size;
+}
+
+int binarized_scratch_words(const BinarizedNetwork* net) {
+    int widest = 0;
+    for (int l = 1; l < net->num_layers; l++) {
+        if (net->words[l] > widest) widest = net->words[l];
+    }
+    return 2 * widest;
+}
+
+// --- XNOR-Popcount Inference ---
+
+// Shared body of the kernels below; inlining it into a function compiled for
+// POPCNT turns every __builtin_popcountll into a single instruction
+static inline __attribute__((always_inline)) int binarized_forward_body(const BinarizedNetwork* net,
+                                                                        const uint64_t* input,
+                                                                        uint64_t* scratch, int32_t* scores) {
+    const uint64_t* current = input;
+    int half = binarized_scratch_words(net) / 2;
+    int last = net->num_layers - 2;
+    for (int l = 0; l < last; l++) {
+        uint64_t* out = scratch + (l & 1) * half;
+        int inputs = net->architecture[l];
+        int words = net->words[l];
+        memset(out, 0, net->words[l + 1] * sizeof(uint64_t));
+        for (int j = 0; j < net->architecture[l + 1]; j++) {
+            const uint64_t* row = net->weights[l] + (size_t)j * words;
+            int mismatches = 0;
+            for (int w = 0; w < words; w++) mismatches += __builtin_popcountll(current[w] ^ row[w]);
+            if (inputs - 2 * mismatches >= net->thresholds[l][j]) out[j / 64] |= (uint64_t)1 << (j % 64);
+        }
+        current = out;
+    }
+
+    int inputs = net->architecture[last];
+    int words = net->words[last];
+    int best = 0;
+    int32_t best_score = 0;
+    for (int j = 0; j < net->architecture[last + 1]; j++) {
+        const uint64_t* row = net->weights[last] + (size_t)j * words;
+        int mismatches = 0;
+        for (int w = 0; w < words; w++) mismatches += __builtin_popcountll(current[w] ^ row[w]);
+        int32_t score = inputs - 2 * mismatches - net->thresholds[last][j];
+        if (scores) scores[j] = score;
+        if (j == 0 || score > best_score) {
+            best = j;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+typedef int (*BinarizedKernel)(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch,
+                               int32_t* scores);
+
+static int binarized_forward_scalar(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch,
+                                    int32_t* scores) {
+    return binarized_forward_body(net, input, scratch, scores);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("popcnt")))
+static int binarized_forward_popcnt(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch,
+                                    int32_t* scores) {
+    return binarized_forward_body(net, input, scratch, scores);
+}
+#endif
+
+static BinarizedKernel binarized_kernel = binarized_forward_scalar;
+static const char* binarized_kernel_label = "scalar";
+static pthread_once_t binarized_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_binarized_kernel(void) {
+    const char* requested = getenv("GENNET_BINARIZED_KERNEL");
+    if (requested && strcmp(requested, "scalar") == 0) return;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt")) {
+        binarized_kernel = binarized_forward_popcnt;
+        binarized_kernel_label = "popcnt";
+    }
+#endif
+}
+
+const char* binarized_kernel_name(void) {
+    pthread_once(&binarized_kernel_once, select_binarized_kernel);
+    return binarized_kernel_label;
+}
+
+int binarized_forward(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch, int32_t* scores) {
+    pthread_once(&binarized_kernel_once, select_binarized_kernel);
+    return binarized_kernel(net, input, scratch, scores);
+}
+
+int binarized_predict(const BinarizedNetwork* net, const uint64_t* input, uint64_t* scratch) {
+    return binarized_forward(net, input, scratch, NULL);
+}
+
+typedef struct {
+    BinarizedNetwork** population;
+    const BitDataset* dataset;
+    int num_samples;
+    double* fitness;
+} BinarizedFitnessJob;
+
+// Scores a slice of the population with its own scratch buffer
+static void binarized_fitness_slice(int begin, int end, void* context) {
+    BinarizedFitnessJob* job = (BinarizedFitnessJob*)context;
+    const BitDataset* dataset = job->dataset;
+    uint64_t* scratch = (uint64_t*)malloc(binarized_scratch_words(job->population[begin]) * sizeof(uint64_t));
+    for (int n = begin; n < end; n++) {
+        const BinarizedNetwork* net = job->population[n];
+        int correct = 0;
+        for (int i = 0; scratch && i < job->num_samples; i++) {
+            const uint64_t* input = dataset->bits + (size_t)i * dataset->words_per_item;
+            if (binarized_predict(net, input, scratch) == dataset->label_indices[i]) correct++;
+        }
+        job->fitness[n] = (double)correct / job->num_samples;
+    }
+    free(scratch);
+}
+
+void binarized_population_fitness(BinarizedNetwork** population, int population_size, const BitDataset* dataset,
+                                  int num_samples, double* fitness) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    BinarizedFitnessJob job = {population, dataset, num_samples, fitness};
+    parallel_for(population_size, 1, binarized_fitness_slice, &job);
+}
+
+// --- Persistence ---
+
+// Header, architecture as int32 values, then each layer's weight rows
+// followed by its thresholds. The CRC covers everything after the header.
+int save_binarized_network(const BinarizedNetwork* net, const char* filepath) {
+    char* tmp_path = NULL;
+    FILE* file = model_create_file(filepath, &tmp_path);
+    if (!file) return 0;
+
+    ModelHeader header;
+    model_header_init(&header, BINARIZED_MODEL_MAGIC, MODEL_DTYPE_BIT, net->num_layers,
+                      sizeof(header) + net->num_layers * sizeof(int32_t) + binarized_network_size(net));
+
+    uint32_t crc = 0;
+    int ok = model_write_header(file, &header) &&
+             model_write_architecture(file, net->num_layers, net->architecture, &crc);
+    for (int l = 0; ok && l < net->num_layers - 1; l++) {
+        int outputs = net->architecture[l + 1];
+        ok = model_write_block(file, net->weights[l], (size_t)outputs * net->words[l] * sizeof(uint64_t), &crc) &&
+             model_write_block(file, net->thresholds[l], outputs * sizeof(int32_t), &crc);
+    }
+
+    header.crc32 = crc;
+    ok = ok && model_write_header(file, &header);
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+BinarizedNetwork* load_binarized_network(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    ModelHeader header;
+    if (!model_read_header(file, &header, BINARIZED_MODEL_MAGIC, MODEL_DTYPE_BIT)) {
+        fprintf(stderr, "%s is not a supported binarized model file.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = (int)header.num_layers;
+    uint32_t crc = 0;
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    BinarizedNetwork* net = NULL;
+    int ok = architecture != NULL;
+    if (ok) {
+        net = create_binarized_network(num_layers, architecture);
+        ok = net != NULL &&
+             sizeof(header) + num_layers * sizeof(int32_t) + binarized_network_size(net) == header.file_size;
+    }
+
+    for (int l = 0; ok && l < num_layers - 1; l++) {
+        int outputs = architecture[l + 1];
+        ok = model_read_block(file, net->weights[l], (size_t)outputs * net->words[l] * sizeof(uint64_t), &crc) &&
+             model_read_block(file, net->thresholds[l], outputs * sizeof(int32_t), &crc);
+    }
+    if (ok && crc != header.crc32) {
+        fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+        ok = 0;
+    }
+    // Padding bits must be clear or they would count as mismatches
+    for (int l = 0; ok && l < num_layers - 1; l++) {
+        uint64_t mask = last_word_mask(architecture[l]);
+        for (int j = 0; ok && j < architecture[l + 1]; j++) {
+            if (net->weights[l][(size_t)(j + 1) * net->words[l] - 1] & ~mask) ok = 0;
+        }
+        if (!ok) fprintf(stderr, "%s has weight bits outside the network.\n", filepath);
+    }
+
+    fclose(file);
+    free(architecture);
+    if (!ok) {
+        free_binarized_network(net);
+        return NULL;
+    }
+    return net;
+}
+
+// --- Genome Operators ---
+
+BinarizedNetwork* crossover_binarized(const BinarizedNetwork* parent1, const BinarizedNetwork* parent2) {
+    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
+        return NULL;
+    }
+    BinarizedNetwork* child = create_binarized_network(parent1->num_layers, parent1->architecture);
+    if (!child) return NULL;
+
+    for (int l = 0; l < parent1->num_layers - 1; l++) {
+        size_t count = (size_t)parent1->architecture[l + 1] * parent1->words[l];
+        const uint64_t* a = parent1->weights[l];
+        const uint64_t* b = parent2->weights[l];
+        for (size_t i = 0; i < count; i++) {
+            uint64_t mask = random_word();
+            child->weights[l][i] = (a[i] & mask) | (b[i] & ~mask);
+        }
+        for (int j = 0; j < parent1->architecture[l + 1]; j++) {
+            child->thresholds[l][j] = (rand() & 1) ? parent1->thresholds[l][j] : parent2->thresholds[l][j];
+        }
+    }
+    return child;
+}
+
+// Distance to the next flipped bit when each bit flips with probability p,
+// so the cost of mutation scales with the number of flips, not of bits
+static size_t next_flip_gap(double log_keep) {
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 1.0);
+    double gap = floor(log(u) / log_keep);
+    return gap > (double)SIZE_MAX / 2 ? SIZE_MAX / 2 : (size_t)gap;
+}
+
+void mutate_binarized_network(BinarizedNetwork* net, float mutation_rate, float mutation_chance) {
+    if (mutation_chance <= 0.0f) return;
+    double log_keep = mutation_chance < 1.0f ? log(1.0 - mutation_chance) : -INFINITY;
+
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        int inputs = net->architecture[l];
+        int row_bits = net->words[l] * 64;
+        size_t total = (size_t)net->architecture[l + 1] * inputs;
+        // Walk the real weight bits only; padding bits are skipped
+        for (size_t bit = next_flip_gap(log_keep); bit < total; bit += 1 + next_flip_gap(log_keep)) {
+            size_t j = bit / inputs;
+            size_t k = bit % inputs;
+            size_t position = j * row_bits + k;
+            net->weights[l][position / 64] ^= (uint64_t)1 << (position % 64);
+        }
+
+        long max_step = lrint(mutation_rate * 0.5 * inputs);
+        if (max_step < 1) max_step = 1;
+        for (int j = 0; j < net->architecture[l + 1]; j++) {
+            if (((double)rand() / RAND_MAX) < mutation_chance) {
+                long value = net->thresholds[l][j] + rand() % (2 * max_step + 1) - max_step;
+                if (value > inputs) value = inputs;
+                if (value < -inputs) value = -inputs;
+                net->thresholds[l][j] = (int32_t)value;
+            }
+        }
+    }
+}
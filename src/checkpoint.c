@@ -0,0 +1,252 @@
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "model_format.h"
+
+// Fixed-size part of a checkpoint file. It is followed by the architecture
+// (int32 per layer), the fitness values, every network's weight and bias
+// blocks in order, and finally a CRC-32 of everything after this header.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t generation;
+    int32_t num_generations;
+    int32_t population_size;
+    int32_t num_layers;
+    float mutation_rate;
+    float mutation_chance;
+    int32_t fitness_samples;
+    int32_t projection_kind;
+    int32_t projection_size;
+    uint32_t rng_seed;
+} CheckpointHeader;
+
+struct CheckpointWriter {
+    char* filepath;
+    EvolutionState* pending;
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+// --- Snapshots ---
+
+EvolutionState* snapshot_evolution_state(NeuralNetwork** population, const double* fitness, int population_size) {
+    EvolutionState* state = (EvolutionState*)calloc(1, sizeof(EvolutionState));
+    if (!state) return NULL;
+    state->population_size = population_size;
+    state->population = (NeuralNetwork**)calloc(population_size, sizeof(NeuralNetwork*));
+    state->fitness = (double*)malloc(population_size * sizeof(double));
+    if (!state->population || !state->fitness) {
+        free_evolution_state(state);
+        return NULL;
+    }
+    for (int i = 0; i < population_size; i++) {
+        state->population[i] = clone_network(population[i]);
+        if (!state->population[i]) {
+            free_evolution_state(state);
+            return NULL;
+        }
+        state->fitness[i] = fitness[i];
+    }
+    return state;
+}
+
+void free_evolution_state(EvolutionState* state) {
+    if (!state) return;
+    if (state->population) {
+        for (int i = 0; i < state->population_size; i++) free_neural_network(state->population[i]);
+    }
+    free(state->population);
+    free(state->fitness);
+    free(state);
+}
+
+// --- Writing ---
+
+// Writes a checkpoint under a temporary name and renames it into place, so
+// a crash mid-write never destroys the previous checkpoint
+int save_checkpoint(const EvolutionState* state, const char* filepath) {
+    if (!state || state->population_size <= 0) return 0;
+    const NeuralNetwork* first = state->population[0];
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.generation = state->generation;
+    header.num_generations = state->num_generations;
+    header.population_size = state->population_size;
+    header.num_layers = first->num_layers;
+    header.mutation_rate = state->mutation_rate;
+    header.mutation_chance = state->mutation_chance;
+    header.fitness_samples = state->fitness_samples;
+    header.projection_kind = state->projection_kind;
+    header.projection_size = state->projection_size;
+    header.rng_seed = state->rng_seed;
+
+    char* tmp_path = NULL;
+    FILE* file = model_create_file(filepath, &tmp_path);
+    if (!file) return 0;
+
+    uint32_t crc = 0;
+    int ok = model_write_block(file, &header, sizeof(header), &crc) &&
+             model_write_architecture(file, first->num_layers, first->architecture, &crc);
+    ok = ok && model_write_block(file, state->fitness, state->population_size * sizeof(double), &crc);
+
+    // Each matrix is contiguous, so every block is a single write
+    for (int n = 0; ok && n < state->population_size; n++) {
+        const NeuralNetwork* net = state->population[n];
+        for (int i = 0; ok && i < net->num_layers - 1; i++) {
+            ok = model_write_block(file, net->weights[i]->data[0],
+                                   (size_t)net->weights[i]->rows * net->weights[i]->cols * sizeof(double), &crc) &&
+                 model_write_block(file, net->biases[i]->data[0], (size_t)net->biases[i]->cols * sizeof(double), &crc);
+        }
+    }
+    ok = ok && fwrite(&crc, sizeof(crc), 1, file) == 1;
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+// --- Reading ---
+
+EvolutionState* load_checkpoint(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open checkpoint");
+        return NULL;
+    }
+
+    uint32_t crc = 0;
+    CheckpointHeader header;
+    if (!model_read_block(file, &header, sizeof(header), &crc) ||
+        header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION ||
+        header.population_size <= 0 || header.num_layers < 2 || header.num_layers > 1024) {
+        fprintf(stderr, "%s is not a valid checkpoint.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = header.num_layers;
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    EvolutionState* state = (EvolutionState*)calloc(1, sizeof(EvolutionState));
+    int ok = architecture && state;
+
+    if (ok) {
+        state->generation = header.generation;
+        state->num_generations = header.num_generations;
+        state->population_size = header.population_size;
+        state->mutation_rate = header.mutation_rate;
+        state->mutation_chance = header.mutation_chance;
+        state->fitness_samples = header.fitness_samples;
+        state->projection_kind = header.projection_kind;
+        state->projection_size = header.projection_size;
+        state->rng_seed = header.rng_seed;
+        state->population = (NeuralNetwork**)calloc(header.population_size, sizeof(NeuralNetwork*));
+        state->fitness = (double*)malloc(header.population_size * sizeof(double));
+        ok = state->population && state->fitness &&
+             model_read_block(file, state->fitness, header.population_size * sizeof(double), &crc);
+    }
+
+    for (int n = 0; ok && n < header.population_size; n++) {
+        NeuralNetwork* net = create_zeroed_network(num_layers, architecture);
+        state->population[n] = net;
+        ok = net != NULL;
+        for (int i = 0; ok && i < num_layers - 1; i++) {
+            ok = model_read_block(file, net->weights[i]->data[0],
+                                  (size_t)net->weights[i]->rows * net->weights[i]->cols * sizeof(double), &crc) &&
+                 model_read_block(file, net->biases[i]->data[0], (size_t)net->biases[i]->cols * sizeof(double), &crc);
+        }
+    }
+
+    uint32_t stored_crc;
+    if (ok && (fread(&stored_crc, sizeof(stored_crc), 1, file) != 1 || stored_crc != crc)) {
+        fprintf(stderr, "Checksum mismatch in checkpoint %s.\n", filepath);
+        ok = 0;
+    }
+
+    fclose(file);
+    free(architecture);
+    if (!ok) {
+        if (state && !state->population) state->population_size = 0;
+        free_evolution_state(state);
+        return NULL;
+    }
+    return state;
+}
+
+// --- Background Writer ---
+
+// Writes whichever snapshot is pending, outside the lock, until told to stop
+static void* checkpoint_writer_main(void* arg) {
+    CheckpointWriter* writer = (CheckpointWriter*)arg;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->pending && !writer->stop) {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        if (!writer->pending) break; // Stopping with nothing left to write
+
+        EvolutionState* snapshot = writer->pending;
+        writer->pending = NULL;
+        pthread_mutex_unlock(&writer->lock);
+
+        if (!save_checkpoint(snapshot, writer->filepath)) {
+            fprintf(stderr, "Failed to write checkpoint %s.\n", writer->filepath);
+        }
+        free_evolution_state(snapshot);
+
+        pthread_mutex_lock(&writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+CheckpointWriter* start_checkpoint_writer(const char* filepath) {
+    CheckpointWriter* writer = (CheckpointWriter*)calloc(1, sizeof(CheckpointWriter));
+    if (!writer) return NULL;
+    writer->filepath = (char*)malloc(strlen(filepath) + 1);
+    if (!writer->filepath) {
+        free(writer);
+        return NULL;
+    }
+    strcpy(writer->filepath, filepath);
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->changed, NULL);
+    if (pthread_create(&writer->thread, NULL, checkpoint_writer_main, writer) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->changed);
+        free(writer->filepath);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void checkpoint_writer_submit(CheckpointWriter* writer, EvolutionState* snapshot) {
+    pthread_mutex_lock(&writer->lock);
+    EvolutionState* superseded = writer->pending;
+    writer->pending = snapshot;
+    pthread_cond_signal(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    free_evolution_state(superseded);
+}
+
+void stop_checkpoint_writer(CheckpointWriter* writer) {
+    if (!writer) return;
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = 1;
+    pthread_cond_signal(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->changed);
+    free(writer->filepath);
+    free(writer);
+}
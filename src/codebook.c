@@ -0,0 +1,486 @@
+#include "codebook.h"
+#include "model_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CODEBOOK_X86 1
+#endif
+
+// Lloyd iterations stop early once no centroid moves
+#define CODEBOOK_KMEANS_ITERATIONS 100
+
+static size_t row_bytes(const CodebookNetwork* cnet, int l) {
+    return (size_t)cnet->padded_inputs[l] * cnet->index_bits[l] / 8;
+}
+
+static int round_up(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Allocates a network with zeroed codebooks and indices
+static CodebookNetwork* create_codebook_network(int num_layers, const int* architecture, int num_centroids) {
+    CodebookNetwork* cnet = (CodebookNetwork*)calloc(1, sizeof(CodebookNetwork));
+    if (!cnet) return NULL;
+    int layers = num_layers - 1;
+    cnet->num_layers = num_layers;
+    cnet->architecture = (int*)malloc(num_layers * sizeof(int));
+    cnet->padded_inputs = (int*)malloc(layers * sizeof(int));
+    cnet->num_centroids = (int*)malloc(layers * sizeof(int));
+    cnet->index_bits = (int*)malloc(layers * sizeof(int));
+    cnet->centroids = (float**)calloc(layers, sizeof(float*));
+    cnet->indices = (uint8_t**)calloc(layers, sizeof(uint8_t*));
+    cnet->biases = (float**)calloc(layers, sizeof(float*));
+    cnet->sums = (float*)calloc(2 * CODEBOOK_MAX_CENTROIDS, sizeof(float));
+    if (!cnet->architecture || !cnet->padded_inputs || !cnet->num_centroids || !cnet->index_bits ||
+        !cnet->centroids || !cnet->indices || !cnet->biases || !cnet->sums) {
+        free_codebook_network(cnet);
+        return NULL;
+    }
+    memcpy(cnet->architecture, architecture, num_layers * sizeof(int));
+
+    int widest = 0;
+    for (int l = 0; l < layers; l++) {
+        cnet->padded_inputs[l] = round_up(architecture[l], CODEBOOK_ROW_ALIGNMENT);
+        cnet->num_centroids[l] = num_centroids;
+        cnet->index_bits[l] = num_centroids <= 16 ? 4 : 8;
+        cnet->centroids[l] = (float*)calloc(CODEBOOK_MAX_CENTROIDS, sizeof(float));
+        cnet->indices[l] = (uint8_t*)calloc((size_t)architecture[l + 1] * row_bytes(cnet, l), 1);
+        cnet->biases[l] = (float*)calloc(architecture[l + 1], sizeof(float));
+        if (!cnet->centroids[l] || !cnet->indices[l] || !cnet->biases[l]) {
+            free_codebook_network(cnet);
+            return NULL;
+        }
+        if (cnet->padded_inputs[l] > widest) widest = cnet->padded_inputs[l];
+    }
+    if (architecture[num_layers - 1] > widest) widest = architecture[num_layers - 1];
+    cnet->scratch[0] = (float*)calloc(widest, sizeof(float));
+    cnet->scratch[1] = (float*)calloc(widest, sizeof(float));
+    if (!cnet->scratch[0] || !cnet->scratch[1]) {
+        free_codebook_network(cnet);
+        return NULL;
+    }
+    return cnet;
+}
+
+void free_codebook_network(CodebookNetwork* cnet) {
+    if (!cnet) return;
+    for (int l = 0; l < cnet->num_layers - 1; l++) {
+        if (cnet->centroids) free(cnet->centroids[l]);
+        if (cnet->indices) free(cnet->indices[l]);
+        if (cnet->biases) free(cnet->biases[l]);
+    }
+    free(cnet->centroids);
+    free(cnet->indices);
+    free(cnet->biases);
+    free(cnet->sums);
+    free(cnet->scratch[0]);
+    free(cnet->scratch[1]);
+    free(cnet->index_bits);
+    free(cnet->num_centroids);
+    free(cnet->padded_inputs);
+    free(cnet->architecture);
+    free(cnet);
+}
+
+static uint8_t get_index(const CodebookNetwork* cnet, int l, int j, int k) {
+    const uint8_t* row = cnet->indices[l] + (size_t)j * row_bytes(cnet, l);
+    if (cnet->index_bits[l] == 8) return row[k];
+    return (row[k / 2] >> ((k % 2) * 4)) & 0xF;
+}
+
+static void set_index(CodebookNetwork* cnet, int l, int j, int k, uint8_t index) {
+    uint8_t* row = cnet->indices[l] + (size_t)j * row_bytes(cnet, l);
+    if (cnet->index_bits[l] == 8) {
+        row[k] = index;
+    } else {
+        int shift = (k % 2) * 4;
+        row[k / 2] = (uint8_t)((row[k / 2] & ~(0xF << shift)) | (index << shift));
+    }
+}
+
+// --- Compression ---
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 1-D k-means over sorted values, starting from centroids spread linearly
+// between the extremes. Clusters of sorted data are contiguous runs, so each
+// Lloyd step is a single sweep, and the centroids stay in ascending order.
+static void kmeans_1d(const double* sorted, size_t n, int k, float* centroids) {
+    double* means = (double*)malloc(2 * k * sizeof(double));
+    if (!means) return;
+    double* updated = means + k;
+    double low = sorted[0], high = sorted[n - 1];
+    for (int c = 0; c < k; c++) means[c] = low + (high - low) * c / (k - 1);
+
+    for (int iteration = 0; iteration < CODEBOOK_KMEANS_ITERATIONS; iteration++) {
+        int moved = 0;
+        size_t position = 0;
+        for (int c = 0; c < k; c++) {
+            double upper = c + 1 < k ? 0.5 * (means[c] + means[c + 1]) : INFINITY;
+            double sum = 0.0;
+            size_t count = 0;
+            while (position < n && sorted[position] < upper) {
+                sum += sorted[position++];
+                count++;
+            }
+            // Empty clusters keep their centroid
+            updated[c] = count > 0 ? sum / count : means[c];
+            if (updated[c] != means[c]) moved = 1;
+        }
+        memcpy(means, updated, k * sizeof(double));
+        if (!moved) break;
+    }
+    for (int c = 0; c < k; c++) centroids[c] = (float)means[c];
+    free(means);
+}
+
+// Index of the centroid closest to value; centroids are ascending
+static int nearest_centroid(const float* centroids, int k, double value) {
+    int low = 0, high = k - 1;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (centroids[mid] < value) low = mid + 1;
+        else high = mid;
+    }
+    if (low > 0 && value - centroids[low - 1] <= centroids[low] - value) low--;
+    return low;
+}
+
+CodebookNetwork* compress_network(const NeuralNetwork* net, int num_centroids) {
+    if (num_centroids < CODEBOOK_MIN_CENTROIDS || num_centroids > CODEBOOK_MAX_CENTROIDS) {
+        fprintf(stderr, "Codebooks need %d to %d centroids.\n", CODEBOOK_MIN_CENTROIDS, CODEBOOK_MAX_CENTROIDS);
+        return NULL;
+    }
+    CodebookNetwork* cnet = create_codebook_network(net->num_layers, net->architecture, num_centroids);
+    if (!cnet) return NULL;
+
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        const Matrix* weights = net->weights[l];
+        size_t n = (size_t)weights->rows * weights->cols;
+        double* sorted = (double*)malloc(n * sizeof(double));
+        if (!sorted) {
+            free_codebook_network(cnet);
+            return NULL;
+        }
+        memcpy(sorted, weights->data[0], n * sizeof(double));
+        qsort(sorted, n, sizeof(double), compare_doubles);
+        kmeans_1d(sorted, n, num_centroids, cnet->centroids[l]);
+        free(sorted);
+
+        for (int j = 0; j < weights->cols; j++) {
+            for (int k = 0; k < weights->rows; k++) {
+                set_index(cnet, l, j, k, (uint8_t)nearest_centroid(cnet->centroids[l], num_centroids, weights->data[k][j]));
+            }
+            cnet->biases[l][j] = (float)net->biases[l]->data[0][j];
+        }
+    }
+    return cnet;
+}
+
+double codebook_weight_error(const CodebookNetwork* cnet, const NeuralNetwork* net) {
+    double squared = 0.0;
+    size_t count = 0;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        for (int k = 0; k < net->architecture[l]; k++) {
+            for (int j = 0; j < net->architecture[l + 1]; j++) {
+                double diff = cnet->centroids[l][get_index(cnet, l, j, k)] - net->weights[l]->data[k][j];
+                squared += diff * diff;
+                count++;
+            }
+        }
+    }
+    return count > 0 ? sqrt(squared / count) : 0.0;
+}
+
+size_t codebook_network_size(const CodebookNetwork* cnet) {
+    size_t size = 0;
+    for (int l = 0; l < cnet->num_layers - 1; l++) {
+        int outputs = cnet->architecture[l + 1];
+        size += cnet->num_centroids[l] * sizeof(float) + outputs * row_bytes(cnet, l) + outputs * sizeof(float);
+    }
+    return size;
+}
+
+// --- Persistence ---
+
+// Per layer: centroid count and index width as int32, the centroids, the
+// index rows and the biases. The header's CRC and size are filled in once
+// the body has been written.
+int save_codebook_network(const CodebookNetwork* cnet, const char* filepath) {
+    char* tmp_path = NULL;
+    FILE* file = model_create_file(filepath, &tmp_path);
+    if (!file) return 0;
+
+    ModelHeader header;
+    model_header_init(&header, CODEBOOK_MODEL_MAGIC, MODEL_DTYPE_CODEBOOK, cnet->num_layers,
+                      sizeof(header) + cnet->num_layers * sizeof(int32_t) +
+                          (cnet->num_layers - 1) * 2 * sizeof(int32_t) + codebook_network_size(cnet));
+
+    uint32_t crc = 0;
+    int ok = model_write_header(file, &header) &&
+             model_write_architecture(file, cnet->num_layers, cnet->architecture, &crc);
+    for (int l = 0; ok && l < cnet->num_layers - 1; l++) {
+        int32_t layout[2] = {cnet->num_centroids[l], cnet->index_bits[l]};
+        int outputs = cnet->architecture[l + 1];
+        ok = model_write_block(file, layout, sizeof(layout), &crc) &&
+             model_write_block(file, cnet->centroids[l], cnet->num_centroids[l] * sizeof(float), &crc) &&
+             model_write_block(file, cnet->indices[l], outputs * row_bytes(cnet, l), &crc) &&
+             model_write_block(file, cnet->biases[l], outputs * sizeof(float), &crc);
+    }
+
+    header.crc32 = crc;
+    ok = ok && model_write_header(file, &header);
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+CodebookNetwork* load_codebook_network(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    ModelHeader header;
+    if (!model_read_header(file, &header, CODEBOOK_MODEL_MAGIC, MODEL_DTYPE_CODEBOOK)) {
+        fprintf(stderr, "%s is not a supported codebook model file.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = (int)header.num_layers;
+    uint32_t crc = 0;
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    CodebookNetwork* cnet = NULL;
+    int ok = architecture != NULL;
+    if (ok) {
+        cnet = create_codebook_network(num_layers, architecture, CODEBOOK_MAX_CENTROIDS);
+        ok = cnet != NULL;
+    }
+
+    // Layers may use different codebook sizes, so each is sized as it is read
+    for (int l = 0; ok && l < num_layers - 1; l++) {
+        int32_t layout[2];
+        ok = model_read_block(file, layout, sizeof(layout), &crc) && layout[0] >= 2 &&
+             layout[0] <= CODEBOOK_MAX_CENTROIDS && layout[1] == (layout[0] <= 16 ? 4 : 8);
+        if (!ok) break;
+        cnet->num_centroids[l] = layout[0];
+        cnet->index_bits[l] = layout[1];
+        int outputs = architecture[l + 1];
+        ok = model_read_block(file, cnet->centroids[l], layout[0] * sizeof(float), &crc) &&
+             model_read_block(file, cnet->indices[l], outputs * row_bytes(cnet, l), &crc) &&
+             model_read_block(file, cnet->biases[l], outputs * sizeof(float), &crc);
+        // Out-of-range indices would read past the codebook
+        for (int j = 0; ok && j < outputs; j++) {
+            for (int k = 0; ok && k < cnet->padded_inputs[l]; k++) {
+                if (get_index(cnet, l, j, k) >= layout[0]) ok = 0;
+            }
+        }
+    }
+    if (ok) {
+        ok = sizeof(header) + num_layers * sizeof(int32_t) + (num_layers - 1) * 2 * sizeof(int32_t) +
+             codebook_network_size(cnet) == header.file_size;
+    }
+    if (ok && crc != header.crc32) {
+        fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+        ok = 0;
+    }
+
+    fclose(file);
+    free(architecture);
+    if (!ok) {
+        free_codebook_network(cnet);
+        return NULL;
+    }
+    return cnet;
+}
+
+// --- Codebook Inference ---
+//
+// A layer kernel writes the pre-activations of layer l for activations x,
+// which are zero beyond the layer's real inputs.
+
+typedef void (*CodebookLayerKernel)(const CodebookNetwork* cnet, int l, const float* x, float* out);
+
+// Adds each input to the running sum of its centroid, then multiplies once
+// per centroid. Even and odd inputs go to separate sums so runs of the same
+// index do not wait on each other.
+static void codebook_layer_sums(const CodebookNetwork* cnet, int l, const float* x, float* out) {
+    int k_count = cnet->num_centroids[l];
+    int padded = cnet->padded_inputs[l];
+    size_t stride = row_bytes(cnet, l);
+    const float* centroids = cnet->centroids[l];
+    float* even = cnet->sums;
+    float* odd = cnet->sums + CODEBOOK_MAX_CENTROIDS;
+    for (int j = 0; j < cnet->architecture[l + 1]; j++) {
+        const uint8_t* row = cnet->indices[l] + (size_t)j * stride;
+        memset(even, 0, k_count * sizeof(float));
+        memset(odd, 0, k_count * sizeof(float));
+        if (cnet->index_bits[l] == 4) {
+            for (int k = 0; k < padded; k += 2) {
+                even[row[k / 2] & 0xF] += x[k];
+                odd[row[k / 2] >> 4] += x[k + 1];
+            }
+        } else {
+            for (int k = 0; k < padded; k += 2) {
+                even[row[k]] += x[k];
+                odd[row[k + 1]] += x[k + 1];
+            }
+        }
+        float y = cnet->biases[l][j];
+        for (int c = 0; c < k_count; c++) y += centroids[c] * (even[c] + odd[c]);
+        out[j] = y;
+    }
+}
+
+#ifdef CODEBOOK_X86
+// 4-bit layers: the 16 centroids live in two registers and each group of
+// eight indices is expanded and looked up with two permutes, so decoding
+// never touches memory
+__attribute__((target("avx2,fma")))
+static void codebook_layer_lut16_avx2(const CodebookNetwork* cnet, int l, const float* x, float* out) {
+    int padded = cnet->padded_inputs[l];
+    size_t stride = row_bytes(cnet, l);
+    const __m256 low = _mm256_loadu_ps(cnet->centroids[l]);
+    const __m256 high = _mm256_loadu_ps(cnet->centroids[l] + 8);
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i nibble = _mm256_set1_epi32(0xF);
+    for (int j = 0; j < cnet->architecture[l + 1]; j++) {
+        const uint8_t* row = cnet->indices[l] + (size_t)j * stride;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        int k = 0;
+        for (; k + 16 <= padded; k += 16) {
+            uint32_t packed0, packed1;
+            memcpy(&packed0, row + k / 2, sizeof(packed0));
+            memcpy(&packed1, row + k / 2 + 4, sizeof(packed1));
+            __m256i idx0 = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)packed0), shifts), nibble);
+            __m256i idx1 = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)packed1), shifts), nibble);
+            // Bit 3 of the index, moved into the sign bit, picks the high half
+            __m256 w0 = _mm256_blendv_ps(_mm256_permutevar8x32_ps(low, idx0), _mm256_permutevar8x32_ps(high, idx0),
+                                         _mm256_castsi256_ps(_mm256_slli_epi32(idx0, 28)));
+            __m256 w1 = _mm256_blendv_ps(_mm256_permutevar8x32_ps(low, idx1), _mm256_permutevar8x32_ps(high, idx1),
+                                         _mm256_castsi256_ps(_mm256_slli_epi32(idx1, 28)));
+            acc0 = _mm256_fmadd_ps(w0, _mm256_loadu_ps(x + k), acc0);
+            acc1 = _mm256_fmadd_ps(w1, _mm256_loadu_ps(x + k + 8), acc1);
+        }
+        if (k < padded) {
+            uint32_t packed;
+            memcpy(&packed, row + k / 2, sizeof(packed));
+            __m256i idx = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)packed), shifts), nibble);
+            __m256 w = _mm256_blendv_ps(_mm256_permutevar8x32_ps(low, idx), _mm256_permutevar8x32_ps(high, idx),
+                                        _mm256_castsi256_ps(_mm256_slli_epi32(idx, 28)));
+            acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x + k), acc0);
+        }
+        __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+        out[j] = _mm_cvtss_f32(sum) + cnet->biases[l][j];
+    }
+}
+
+// 8-bit layers: eight indices are widened and gathered from the codebook,
+// which stays in L1 at 1 KB
+__attribute__((target("avx2,fma")))
+static void codebook_layer_gather_avx2(const CodebookNetwork* cnet, int l, const float* x, float* out) {
+    int padded = cnet->padded_inputs[l];
+    size_t stride = row_bytes(cnet, l);
+    const float* centroids = cnet->centroids[l];
+    for (int j = 0; j < cnet->architecture[l + 1]; j++) {
+        const uint8_t* row = cnet->indices[l] + (size_t)j * stride;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        int k = 0;
+        for (; k + 16 <= padded; k += 16) {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(row + k));
+            __m256 w0 = _mm256_i32gather_ps(centroids, _mm256_cvtepu8_epi32(bytes), 4);
+            __m256 w1 = _mm256_i32gather_ps(centroids, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)), 4);
+            acc0 = _mm256_fmadd_ps(w0, _mm256_loadu_ps(x + k), acc0);
+            acc1 = _mm256_fmadd_ps(w1, _mm256_loadu_ps(x + k + 8), acc1);
+        }
+        if (k < padded) {
+            __m128i bytes = _mm_loadl_epi64((const __m128i*)(row + k));
+            __m256 w = _mm256_i32gather_ps(centroids, _mm256_cvtepu8_epi32(bytes), 4);
+            acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x + k), acc0);
+        }
+        __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+        out[j] = _mm_cvtss_f32(sum) + cnet->biases[l][j];
+    }
+}
+#endif
+
+static CodebookLayerKernel lut16_kernel = NULL;
+static CodebookLayerKernel gather_kernel = NULL;
+static pthread_once_t codebook_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_codebook_kernel(void) {
+    const char* requested = getenv("GENNET_CODEBOOK_KERNEL");
+    if (requested && strcmp(requested, "sums") == 0) return;
+#ifdef CODEBOOK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        lut16_kernel = codebook_layer_lut16_avx2;
+        gather_kernel = codebook_layer_gather_avx2;
+    }
+#endif
+}
+
+const char* codebook_kernel_name(void) {
+    pthread_once(&codebook_kernel_once, select_codebook_kernel);
+    return lut16_kernel ? "avx2" : "sums";
+}
+
+// Runs every layer; the last one is left as logits unless activate_last
+static const float* run_layers(CodebookNetwork* cnet, const double* input, int activate_last) {
+    pthread_once(&codebook_kernel_once, select_codebook_kernel);
+    float* current = cnet->scratch[0];
+    for (int k = 0; k < cnet->padded_inputs[0]; k++) {
+        current[k] = k < cnet->architecture[0] ? (float)input[k] : 0.0f;
+    }
+
+    int last = cnet->num_layers - 2;
+    for (int l = 0; l <= last; l++) {
+        float* out = cnet->scratch[(l + 1) & 1];
+        int outputs = cnet->architecture[l + 1];
+        // Registers hold 16 centroids; smaller 4-bit codebooks are zero-padded
+        if (lut16_kernel && cnet->index_bits[l] == 4) {
+            lut16_kernel(cnet, l, current, out);
+        } else if (gather_kernel && cnet->index_bits[l] == 8) {
+            gather_kernel(cnet, l, current, out);
+        } else {
+            codebook_layer_sums(cnet, l, current, out);
+        }
+        if (l < last || activate_last) {
+            for (int j = 0; j < outputs; j++) out[j] = 1.0f / (1.0f + expf(-out[j]));
+        }
+        if (l < last) {
+            for (int j = outputs; j < cnet->padded_inputs[l + 1]; j++) out[j] = 0.0f;
+        }
+        current = out;
+    }
+    return current;
+}
+
+void codebook_forward(CodebookNetwork* cnet, const double* input, double* output) {
+    const float* result = run_layers(cnet, input, 1);
+    for (int j = 0; j < cnet->architecture[cnet->num_layers - 1]; j++) output[j] = result[j];
+}
+
+int codebook_predict(CodebookNetwork* cnet, const double* input) {
+    const float* logits = run_layers(cnet, input, 0);
+    int best = 0;
+    for (int j = 1; j < cnet->architecture[cnet->num_layers - 1]; j++) {
+        if (logits[j] > logits[best]) best = j;
+    }
+    return best;
+}
@@ -0,0 +1,140 @@
+#include "codegen.h"
+#include <stdio.h>
+#include <ctype.h>
+#include <string.h>
+
+// --- Helpers ---
+
+static int is_identifier(const char* name) {
+    if (!name[0] || isdigit((unsigned char)name[0])) return 0;
+    for (const char* c = name; *c; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '_') return 0;
+    }
+    return 1;
+}
+
+// Emits values as hexadecimal floats so the compiled weights are bit-exact
+static void write_values(FILE* file, const double* values, int count) {
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%s%a,", i % 4 == 0 ? "\n    " : " ", values[i]);
+    }
+    fprintf(file, "\n");
+}
+
+static int write_header(const NeuralNetwork* net, const char* name, const char* header_path) {
+    FILE* file = fopen(header_path, "w");
+    if (!file) {
+        perror("Failed to open header for writing");
+        return 0;
+    }
+
+    char guard[256];
+    snprintf(guard, sizeof(guard), "%s_H", name);
+    for (char* c = guard; *c; c++) *c = (char)toupper((unsigned char)*c);
+
+    fprintf(file, "// Generated by nettool compile. Do not edit.\n");
+    fprintf(file, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(file, "// Architecture: [");
+    for (int i = 0; i < net->num_layers; i++) {
+        fprintf(file, "%d%s", net->architecture[i], i == net->num_layers - 1 ? "" : ", ");
+    }
+    fprintf(file, "]\n");
+    fprintf(file, "#define %s_INPUT_SIZE %d\n", name, net->architecture[0]);
+    fprintf(file, "#define %s_OUTPUT_SIZE %d\n\n", name, net->architecture[net->num_layers - 1]);
+    fprintf(file, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+    fprintf(file, "// Writes the output activations for one input row\n");
+    fprintf(file, "void %s_forward(const double* input, double* output);\n\n", name);
+    fprintf(file, "// Returns the index of the strongest output\n");
+    fprintf(file, "int %s_predict(const double* input);\n\n", name);
+    fprintf(file, "#ifdef __cplusplus\n}\n#endif\n\n");
+    fprintf(file, "#endif // %s\n", guard);
+
+    return fclose(file) == 0;
+}
+
+// --- Code Generation ---
+
+int compile_network_source(const NeuralNetwork* net, const char* name,
+                           const char* source_path, const char* header_path) {
+    if (!net || net->num_layers < 2 || !is_identifier(name)) {
+        fprintf(stderr, "Cannot compile network: invalid network or name '%s'.\n", name);
+        return 0;
+    }
+
+    FILE* file = fopen(source_path, "w");
+    if (!file) {
+        perror("Failed to open source for writing");
+        return 0;
+    }
+
+    const char* header_name = strrchr(header_path, '/');
+    header_name = header_name ? header_name + 1 : header_path;
+
+    fprintf(file, "// Generated by nettool compile. Do not edit.\n");
+    fprintf(file, "#include \"%s\"\n#include <math.h>\n\n", header_name);
+    fprintf(file, "#ifdef __cplusplus\n#define NET_ALIGN alignas(64)\n#else\n#define NET_ALIGN _Alignas(64)\n#endif\n");
+
+    // Weights keep the [inputs][outputs] layout of Matrix, so the inner loop
+    // of each layer walks one contiguous row
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        int rows = net->architecture[l];
+        int cols = net->architecture[l + 1];
+        fprintf(file, "\nNET_ALIGN static const double %s_w%d[%d][%d] = {", name, l, rows, cols);
+        for (int r = 0; r < rows; r++) {
+            fprintf(file, "\n  {");
+            write_values(file, net->weights[l]->data[r], cols);
+            fprintf(file, "  },");
+        }
+        fprintf(file, "\n};\n");
+        fprintf(file, "\nNET_ALIGN static const double %s_b%d[%d] = {", name, l, cols);
+        write_values(file, net->biases[l]->data[0], cols);
+        fprintf(file, "};\n");
+    }
+
+    // Accumulating input by input adds the terms of every output in the same
+    // order as dot_product, so results match forward_pass exactly
+    fprintf(file, "\nvoid %s_forward(const double* input, double* output) {\n", name);
+    for (int l = 1; l < net->num_layers - 1; l++) {
+        fprintf(file, "    NET_ALIGN double a%d[%d];\n", l, net->architecture[l]);
+    }
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        int rows = net->architecture[l];
+        int cols = net->architecture[l + 1];
+        const char* in = "input";
+        char in_buf[16], out_buf[16];
+        if (l > 0) {
+            snprintf(in_buf, sizeof(in_buf), "a%d", l);
+            in = in_buf;
+        }
+        const char* out = "output";
+        if (l < net->num_layers - 2) {
+            snprintf(out_buf, sizeof(out_buf), "a%d", l + 1);
+            out = out_buf;
+        }
+        fprintf(file, "\n    // Layer %d: %d -> %d\n", l + 1, rows, cols);
+        fprintf(file, "    {\n");
+        fprintf(file, "        NET_ALIGN double acc[%d] = {0};\n", cols);
+        fprintf(file, "        for (int i = 0; i < %d; i++) {\n", rows);
+        fprintf(file, "            const double x = %s[i];\n", in);
+        fprintf(file, "            for (int j = 0; j < %d; j++) acc[j] += x * %s_w%d[i][j];\n", cols, name, l);
+        fprintf(file, "        }\n");
+        fprintf(file, "        for (int j = 0; j < %d; j++) %s[j] = 1.0 / (1.0 + exp(-(acc[j] + %s_b%d[j])));\n",
+                cols, out, name, l);
+        fprintf(file, "    }\n");
+    }
+    fprintf(file, "}\n");
+
+    int outputs = net->architecture[net->num_layers - 1];
+    fprintf(file, "\nint %s_predict(const double* input) {\n", name);
+    fprintf(file, "    double output[%d];\n", outputs);
+    fprintf(file, "    %s_forward(input, output);\n", name);
+    fprintf(file, "    int best = 0;\n");
+    fprintf(file, "    for (int j = 1; j < %d; j++) {\n", outputs);
+    fprintf(file, "        if (output[j] > output[best]) best = j;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return best;\n");
+    fprintf(file, "}\n");
+
+    if (fclose(file) != 0) return 0;
+    return write_header(net, name, header_path);
+}
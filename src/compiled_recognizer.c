@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neural_network.h"
+#include "data_loader.h"
+#include "projection.h"
+#include "compiled_network.h"
+
+// Evaluates the network compiled into the binary on the MNIST test set and
+// checks every prediction against the network file it was generated from
+int main(int argc, char* argv[]) {
+    printf("--- MNIST Number Recognizer (compiled network) ---\n");
+
+    const char* network_filepath = argc > 1 ? argv[1] : "trained_network.dat";
+    NeuralNetwork* net = load_network(network_filepath);
+    if (!net) {
+        fprintf(stderr, "Failed to load reference network from %s.\n", network_filepath);
+        return 1;
+    }
+    if (net->architecture[0] != compiled_network_INPUT_SIZE ||
+        net->architecture[net->num_layers - 1] != compiled_network_OUTPUT_SIZE) {
+        fprintf(stderr, "%s does not match the compiled network.\n", network_filepath);
+        free_neural_network(net);
+        return 1;
+    }
+
+    Dataset* test_dataset = load_mnist_dataset_cached("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte", "data/t10k.cache");
+    if (!test_dataset) {
+        fprintf(stderr, "Failed to load the MNIST test dataset.\n");
+        free_neural_network(net);
+        return 1;
+    }
+
+    // Networks trained on reduced inputs need the projection saved next to them
+    if (compiled_network_INPUT_SIZE != MNIST_IMAGE_SIZE) {
+        char projection_filepath[1024];
+        snprintf(projection_filepath, sizeof(projection_filepath), "%s.proj", network_filepath);
+        Projection* projection = load_projection(projection_filepath);
+        Dataset* projected = NULL;
+        if (projection && projection->output_size == compiled_network_INPUT_SIZE) {
+            projected = project_dataset(projection, test_dataset);
+        }
+        free_projection(projection);
+        free_dataset(test_dataset);
+        if (!projected) {
+            fprintf(stderr, "No matching projection found at %s.\n", projection_filepath);
+            free_neural_network(net);
+            return 1;
+        }
+        test_dataset = projected;
+    }
+
+    int correct_predictions = 0;
+    int mismatches = 0;
+    double max_difference = 0.0;
+    double output[compiled_network_OUTPUT_SIZE];
+    for (int i = 0; i < test_dataset->num_items; i++) {
+        const double* image = test_dataset->images->data[i];
+        compiled_network_forward(image, output);
+        int predicted_class = compiled_network_predict(image);
+        if (predicted_class == test_dataset->label_indices[i]) correct_predictions++;
+
+        Matrix* input = create_matrix_view(1, compiled_network_INPUT_SIZE, (double*)image);
+        Matrix* reference = forward_pass(net, input);
+        for (int j = 0; j < compiled_network_OUTPUT_SIZE; j++) {
+            double difference = output[j] - reference->data[0][j];
+            if (difference < 0) difference = -difference;
+            if (difference > max_difference) max_difference = difference;
+            if (difference != 0.0) {
+                mismatches++;
+                break;
+            }
+        }
+        free_matrix(reference);
+        free_matrix(input);
+    }
+
+    double accuracy = (double)correct_predictions / test_dataset->num_items;
+    printf("----------------------------------\n");
+    printf("Final Accuracy on Test Set: %.2f%% (%d/%d correct)\n",
+           accuracy * 100.0, correct_predictions, test_dataset->num_items);
+    printf("Outputs differing from %s: %d (max difference %g)\n",
+           network_filepath, mismatches, max_difference);
+    printf("----------------------------------\n");
+
+    free_dataset(test_dataset);
+    free_neural_network(net);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -1,8 +1,40 @@
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE 200809L
 #include "data_loader.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdatomic.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "parallel.h"
+
+// Sizes of the IDX file headers preceding the first record
+#define IDX_IMAGE_HEADER_SIZE 16
+#define IDX_LABEL_HEADER_SIZE 8
+
+// On-disk header of a dataset cache. The image block starts at images_offset
+// and holds num_items * image_size values of dtype_size bytes; the label block
+// holds one class index byte per item.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dtype_size;
+    uint32_t num_items;
+    uint32_t image_size;
+    uint32_t num_classes;
+    uint64_t images_offset;
+    uint64_t labels_offset;
+    uint64_t file_size;
+    uint8_t reserved[DATASET_CACHE_ALIGNMENT - 48];
+} DatasetCacheHeader;
 
 // Helper function to swap endianness (from big-endian to little-endian)
 static int swap_endian(int val) {
@@ -12,8 +44,32 @@ static int swap_endian(int val) {
            ((val << 24) & 0xff000000);
 }
 
-// Loads the MNIST dataset from the specified files
-Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
+// Rounds an offset up to the cache alignment
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + DATASET_CACHE_ALIGNMENT - 1) & ~(uint64_t)(DATASET_CACHE_ALIGNMENT - 1);
+}
+
+// Allocates an empty dataset with zeroed images, labels and label indices
+Dataset* create_dataset(int num_items, int image_size, int num_classes) {
+    Dataset* dataset = (Dataset*)calloc(1, sizeof(Dataset));
+    if (!dataset) return NULL;
+
+    dataset->num_items = num_items;
+    dataset->images = create_matrix(num_items, image_size);
+    dataset->labels = create_matrix(num_items, num_classes);
+    dataset->label_indices = (unsigned char*)calloc(num_items > 0 ? num_items : 1, sizeof(unsigned char));
+    if (!dataset->images || !dataset->labels || !dataset->label_indices) {
+        free_dataset(dataset);
+        return NULL;
+    }
+    return dataset;
+}
+
+// Opens a pair of IDX image/label files and validates their headers. On
+// success both files are left open and positioned just past their headers.
+int open_idx_files(const char* image_path, const char* label_path,
+                          FILE** image_file_out, FILE** label_file_out,
+                          int* num_items_out, int* image_size_out) {
     // --- Open Files ---
     FILE* image_file = fopen(image_path, "rb");
     FILE* label_file = fopen(label_path, "rb");
@@ -21,7 +77,7 @@ Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
         fprintf(stderr, "Error opening dataset files.\n");
         if (image_file) fclose(image_file);
         if (label_file) fclose(label_file);
-        return NULL;
+        return 0;
     }
 
     // --- Read Image File Header ---
@@ -39,7 +95,7 @@ Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
         fprintf(stderr, "Invalid image file magic number.\n");
         fclose(image_file);
         fclose(label_file);
-        return NULL;
+        return 0;
     }
 
     // --- Read Label File Header ---
@@ -53,79 +109,342 @@ Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
         fprintf(stderr, "Invalid label file magic number.\n");
         fclose(image_file);
         fclose(label_file);
-        return NULL;
+        return 0;
     }
 
     if (num_images != num_labels) {
         fprintf(stderr, "Number of images and labels do not match.\n");
         fclose(image_file);
         fclose(label_file);
+        return 0;
+    }
+
+    *image_file_out = image_file;
+    *label_file_out = label_file;
+    *num_items_out = num_images;
+    *image_size_out = rows * cols;
+    return 1;
+}
+
+int count_idx_records(const char* image_path, const char* label_path) {
+    FILE* image_file;
+    FILE* label_file;
+    int num_items, image_size;
+    if (!open_idx_files(image_path, label_path, &image_file, &label_file, &num_items, &image_size)) return -1;
+    fclose(image_file);
+    fclose(label_file);
+    return num_items;
+}
+
+void truncate_dataset(Dataset* dataset, int count) {
+    if (count < 1 || count >= dataset->num_items) return;
+    dataset->num_items = count;
+    dataset->images->rows = count;
+    dataset->labels->rows = count;
+}
+
+// Converts raw pixels to doubles in [0, 1]. The SSE2 path widens 16 pixels
+// at a time and divides two lanes per instruction; results are bit-identical
+// to the scalar loop.
+static void decode_pixels(const unsigned char* src, double* dst, size_t n) {
+    size_t j = 0;
+#ifdef __SSE2__
+    const __m128d scale = _mm_set1_pd(255.0);
+    const __m128i zero = _mm_setzero_si128();
+    for (; j + 16 <= n; j += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(src + j));
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+        __m128i words[4] = {
+            _mm_unpacklo_epi16(lo16, zero), _mm_unpackhi_epi16(lo16, zero),
+            _mm_unpacklo_epi16(hi16, zero), _mm_unpackhi_epi16(hi16, zero)
+        };
+        for (int w = 0; w < 4; w++) {
+            __m128d first = _mm_cvtepi32_pd(words[w]);
+            __m128d second = _mm_cvtepi32_pd(_mm_shuffle_epi32(words[w], _MM_SHUFFLE(1, 0, 3, 2)));
+            _mm_storeu_pd(dst + j + w * 4, _mm_div_pd(first, scale));
+            _mm_storeu_pd(dst + j + w * 4 + 2, _mm_div_pd(second, scale));
+        }
+    }
+#endif
+    for (; j < n; j++) {
+        dst[j] = (double)src[j] / 255.0;
+    }
+}
+
+// Shared state of a parallel image decode
+typedef struct {
+    int fd;
+    off_t base_offset; // File offset of the first requested record
+    int image_size;
+    double* images;
+    atomic_int failed;
+} DecodeJob;
+
+// Reads and decodes records [begin, end) of a DecodeJob straight into their
+// slice of the destination buffer
+static void decode_record_slice(int begin, int end, void* context) {
+    DecodeJob* job = (DecodeJob*)context;
+
+    // Read in chunks so each thread's staging buffer stays small
+    const int chunk_records = 256;
+    unsigned char* buffer = (unsigned char*)malloc((size_t)chunk_records * job->image_size);
+    if (!buffer) {
+        atomic_store(&job->failed, 1);
+        return;
+    }
+    for (int record = begin; record < end && !atomic_load(&job->failed); record += chunk_records) {
+        int n = end - record < chunk_records ? end - record : chunk_records;
+        size_t bytes = (size_t)n * job->image_size;
+        off_t offset = job->base_offset + (off_t)record * job->image_size;
+        size_t got = 0;
+        while (got < bytes) {
+            ssize_t r = pread(job->fd, buffer + got, bytes - got, offset + (off_t)got);
+            if (r <= 0) break;
+            got += (size_t)r;
+        }
+        if (got != bytes) {
+            atomic_store(&job->failed, 1);
+            break;
+        }
+        decode_pixels(buffer, job->images + (size_t)record * job->image_size, bytes);
+    }
+    free(buffer);
+}
+
+// Seeks to record `first` and reads `count` consecutive records, normalizing
+// pixels into `images` (count * image_size values) and class indices into
+// `labels`. Large reads are split across threads, each decoding its own slice.
+int read_idx_records(FILE* image_file, FILE* label_file, int image_size,
+                     long first, int count, double* images, unsigned char* labels) {
+    if (fseeko(label_file, (off_t)IDX_LABEL_HEADER_SIZE + (off_t)first, SEEK_SET) != 0) {
+        return 0;
+    }
+    if (fread(labels, sizeof(unsigned char), count, label_file) != (size_t)count) return 0;
+    for (int i = 0; i < count; i++) {
+        if (labels[i] >= MNIST_NUM_CLASSES) return 0;
+    }
+
+    // Images are read with pread on the underlying descriptor, which is safe
+    // to share between threads and leaves the stream position alone
+    DecodeJob job;
+    job.fd = fileno(image_file);
+    job.base_offset = (off_t)IDX_IMAGE_HEADER_SIZE + (off_t)first * image_size;
+    job.image_size = image_size;
+    job.images = images;
+    atomic_init(&job.failed, 0);
+    parallel_for(count, DECODE_MIN_RECORDS_PER_THREAD, decode_record_slice, &job);
+    return !atomic_load(&job.failed);
+}
+
+// Builds the one-hot label matrix from the label indices
+void fill_one_hot_labels(Dataset* dataset) {
+    for (int i = 0; i < dataset->num_items; i++) {
+        for (int k = 0; k < dataset->labels->cols; k++) {
+            dataset->labels->data[i][k] = 0.0;
+        }
+        dataset->labels->data[i][dataset->label_indices[i]] = 1.0;
+    }
+}
+
+// Loads the MNIST dataset from the specified files
+Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
+    FILE* image_file;
+    FILE* label_file;
+    int num_images, image_size;
+    if (!open_idx_files(image_path, label_path, &image_file, &label_file, &num_images, &image_size)) {
         return NULL;
     }
 
     // --- Create Dataset Struct ---
-    Dataset* dataset = (Dataset*)malloc(sizeof(Dataset));
+    Dataset* dataset = create_dataset(num_images, image_size, MNIST_NUM_CLASSES);
     if (!dataset) {
         fclose(image_file);
         fclose(label_file);
         return NULL;
     }
-    dataset->num_items = num_images;
-    dataset->images = create_matrix(num_images, rows * cols);
-    dataset->labels = create_matrix(num_images, MNIST_NUM_CLASSES);
 
-    if (!dataset->images || !dataset->labels) {
-        free_dataset(dataset); // free_dataset handles partial allocation
+    // --- Read Data ---
+    double* images = num_images > 0 ? dataset->images->data[0] : NULL;
+    if (!read_idx_records(image_file, label_file, image_size, 0, num_images, images, dataset->label_indices)) {
+        fprintf(stderr, "Failed to read dataset records.\n");
+        free_dataset(dataset);
         fclose(image_file);
         fclose(label_file);
         return NULL;
     }
+    fill_one_hot_labels(dataset);
 
-    // --- Read Data ---
-    int image_size = rows * cols;
-    unsigned char* image_buffer = (unsigned char*)malloc(image_size * sizeof(unsigned char));
-    unsigned char label_buffer;
-
-    for (int i = 0; i < num_images; i++) {
-        // Read image
-        fread(image_buffer, sizeof(unsigned char), image_size, image_file);
-        for (int j = 0; j < image_size; j++) {
-            dataset->images->data[i][j] = (double)image_buffer[j] / 255.0;
-        }
+    // --- Cleanup ---
+    fclose(image_file);
+    fclose(label_file);
 
-        // Read label and one-hot encode
-        fread(&label_buffer, sizeof(unsigned char), 1, label_file);
-        for(int k=0; k < MNIST_NUM_CLASSES; k++) {
-            dataset->labels->data[i][k] = 0.0;
-        }
-        dataset->labels->data[i][label_buffer] = 1.0;
+    printf("Successfully loaded %d items from the MNIST dataset.\n", num_images);
+
+    return dataset;
+}
+
+// Loads `count` consecutive records starting at `start`, reading only those records
+Dataset* load_mnist_range(const char* image_path, const char* label_path, int start, int count) {
+    FILE* image_file;
+    FILE* label_file;
+    int num_images, image_size;
+    if (!open_idx_files(image_path, label_path, &image_file, &label_file, &num_images, &image_size)) {
+        return NULL;
+    }
+
+    if (start < 0 || count < 0 || start > num_images - count) {
+        fprintf(stderr, "Requested range [%d, %d) is outside the dataset (%d items).\n", start, start + count, num_images);
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
+
+    Dataset* dataset = create_dataset(count, image_size, MNIST_NUM_CLASSES);
+    if (!dataset) {
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
+
+    double* images = count > 0 ? dataset->images->data[0] : NULL;
+    if (!read_idx_records(image_file, label_file, image_size, start, count, images, dataset->label_indices)) {
+        fprintf(stderr, "Failed to read dataset records.\n");
+        free_dataset(dataset);
+        dataset = NULL;
+    } else {
+        fill_one_hot_labels(dataset);
     }
 
-    // --- Cleanup ---
-    free(image_buffer);
     fclose(image_file);
     fclose(label_file);
+    return dataset;
+}
 
-    printf("Successfully loaded %d items from the MNIST dataset.\n", num_images);
+// Loads the records listed in `indices`, in that order. Runs of consecutive
+// indices are read with a single seek.
+Dataset* load_mnist_subset(const char* image_path, const char* label_path, const int* indices, int count) {
+    FILE* image_file;
+    FILE* label_file;
+    int num_images, image_size;
+    if (!open_idx_files(image_path, label_path, &image_file, &label_file, &num_images, &image_size)) {
+        return NULL;
+    }
+
+    Dataset* dataset = create_dataset(count, image_size, MNIST_NUM_CLASSES);
+    if (!dataset) {
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
 
+    int i = 0;
+    while (i < count) {
+        if (indices[i] < 0 || indices[i] >= num_images) {
+            fprintf(stderr, "Requested index %d is outside the dataset (%d items).\n", indices[i], num_images);
+            free_dataset(dataset);
+            dataset = NULL;
+            break;
+        }
+        int run = 1;
+        while (i + run < count && indices[i + run] == indices[i] + run && indices[i + run] < num_images) {
+            run++;
+        }
+        if (!read_idx_records(image_file, label_file, image_size, indices[i], run,
+                              dataset->images->data[i], dataset->label_indices + i)) {
+            fprintf(stderr, "Failed to read dataset records.\n");
+            free_dataset(dataset);
+            dataset = NULL;
+            break;
+        }
+        i += run;
+    }
+    if (dataset) fill_one_hot_labels(dataset);
+
+    fclose(image_file);
+    fclose(label_file);
     return dataset;
 }
 
-// Creates a dummy dataset with random values
-Dataset* create_dummy_dataset(int num_items) {
-    Dataset* dataset = (Dataset*)malloc(sizeof(Dataset));
-    if (!dataset) return NULL;
+// --- Paged Dataset ---
 
-    dataset->num_items = num_items;
-    dataset->images = create_matrix(num_items, MNIST_IMAGE_SIZE);
-    dataset->labels = create_matrix(num_items, MNIST_NUM_CLASSES);
+// Opens a dataset whose records are read from disk a page at a time on first access
+PagedDataset* open_paged_dataset(const char* image_path, const char* label_path, int page_size) {
+    if (page_size <= 0) return NULL;
 
-    if (!dataset->images || !dataset->labels) {
-        free_matrix(dataset->images);
-        free_matrix(dataset->labels);
-        free(dataset);
+    PagedDataset* paged = (PagedDataset*)calloc(1, sizeof(PagedDataset));
+    if (!paged) return NULL;
+
+    if (!open_idx_files(image_path, label_path, &paged->image_file, &paged->label_file,
+                        &paged->num_items, &paged->image_size)) {
+        free(paged);
+        return NULL;
+    }
+    paged->page_size = page_size;
+    paged->num_pages = (paged->num_items + page_size - 1) / page_size;
+    paged->image_pages = (double**)calloc(paged->num_pages > 0 ? paged->num_pages : 1, sizeof(double*));
+    paged->label_pages = (unsigned char**)calloc(paged->num_pages > 0 ? paged->num_pages : 1, sizeof(unsigned char*));
+    if (!paged->image_pages || !paged->label_pages) {
+        close_paged_dataset(paged);
         return NULL;
     }
+    return paged;
+}
+
+// Reads the page holding `index` into memory if it is not resident yet
+static int fault_in_page(PagedDataset* paged, int page) {
+    if (paged->image_pages[page]) return 1;
+
+    int first = page * paged->page_size;
+    int count = paged->num_items - first < paged->page_size ? paged->num_items - first : paged->page_size;
+    double* images = (double*)malloc((size_t)count * paged->image_size * sizeof(double));
+    unsigned char* labels = (unsigned char*)malloc(count);
+    if (!images || !labels ||
+        !read_idx_records(paged->image_file, paged->label_file, paged->image_size, first, count, images, labels)) {
+        free(images);
+        free(labels);
+        return 0;
+    }
+    paged->image_pages[page] = images;
+    paged->label_pages[page] = labels;
+    paged->resident_pages++;
+    return 1;
+}
+
+// Returns the normalized pixels of record `index`, or NULL on error
+const double* paged_dataset_image(PagedDataset* paged, int index) {
+    if (index < 0 || index >= paged->num_items) return NULL;
+    int page = index / paged->page_size;
+    if (!fault_in_page(paged, page)) return NULL;
+    return paged->image_pages[page] + (size_t)(index % paged->page_size) * paged->image_size;
+}
+
+// Returns the class index of record `index`, or -1 on error
+int paged_dataset_label(PagedDataset* paged, int index) {
+    if (index < 0 || index >= paged->num_items) return -1;
+    int page = index / paged->page_size;
+    if (!fault_in_page(paged, page)) return -1;
+    return paged->label_pages[page][index % paged->page_size];
+}
+
+// Closes the underlying files and frees all resident pages
+void close_paged_dataset(PagedDataset* paged) {
+    if (!paged) return;
+    for (int p = 0; p < paged->num_pages; p++) {
+        if (paged->image_pages) free(paged->image_pages[p]);
+        if (paged->label_pages) free(paged->label_pages[p]);
+    }
+    free(paged->image_pages);
+    free(paged->label_pages);
+    if (paged->image_file) fclose(paged->image_file);
+    if (paged->label_file) fclose(paged->label_file);
+    free(paged);
+}
+
+// Creates a dummy dataset with random values
+Dataset* create_dummy_dataset(int num_items) {
+    Dataset* dataset = create_dataset(num_items, MNIST_IMAGE_SIZE, MNIST_NUM_CLASSES);
+    if (!dataset) return NULL;
 
     // Seed random number generator if not already seeded
     static int seeded = 0;
@@ -145,6 +464,7 @@ Dataset* create_dummy_dataset(int num_items) {
     for (int i = 0; i < num_items; i++) {
         int random_class = rand() % MNIST_NUM_CLASSES;
         dataset->labels->data[i][random_class] = 1.0;
+        dataset->label_indices[i] = (unsigned char)random_class;
     }
 
     return dataset;
@@ -155,5 +475,281 @@ void free_dataset(Dataset* dataset) {
     if (!dataset) return;
     free_matrix(dataset->images);
     free_matrix(dataset->labels);
+    if (dataset->mapping) {
+        munmap(dataset->mapping, dataset->mapping_size);
+    } else {
+        free(dataset->label_indices);
+    }
     free(dataset);
 }
+
+// --- Bit-Packed Datasets ---
+
+#define BIT_DATASET_CHUNK 4096 // Records decoded per read while packing
+
+int words_for_bits(int bits) {
+    return (bits + 63) / 64;
+}
+
+void pack_threshold_bits(const double* values, int n, double threshold, uint64_t* out) {
+    memset(out, 0, words_for_bits(n) * sizeof(uint64_t));
+    for (int k = 0; k < n; k++) {
+        if (values[k] >= threshold) out[k / 64] |= (uint64_t)1 << (k % 64);
+    }
+}
+
+static BitDataset* create_bit_dataset(int num_items, int num_inputs) {
+    BitDataset* dataset = (BitDataset*)calloc(1, sizeof(BitDataset));
+    if (!dataset) return NULL;
+    dataset->num_items = num_items;
+    dataset->num_inputs = num_inputs;
+    dataset->words_per_item = words_for_bits(num_inputs);
+    dataset->bits = (uint64_t*)calloc((size_t)num_items * dataset->words_per_item + 1, sizeof(uint64_t));
+    dataset->label_indices = (unsigned char*)malloc(num_items + 1);
+    if (!dataset->bits || !dataset->label_indices) {
+        free_bit_dataset(dataset);
+        return NULL;
+    }
+    return dataset;
+}
+
+BitDataset* load_mnist_binarized(const char* image_path, const char* label_path, int start, int count, double threshold) {
+    FILE* image_file;
+    FILE* label_file;
+    int num_images, image_size;
+    if (!open_idx_files(image_path, label_path, &image_file, &label_file, &num_images, &image_size)) {
+        return NULL;
+    }
+    if (start < 0 || start > num_images) {
+        fprintf(stderr, "Requested start %d is outside the dataset (%d items).\n", start, num_images);
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
+    if (count < 0 || count > num_images - start) count = num_images - start;
+
+    BitDataset* dataset = create_bit_dataset(count, image_size);
+    int chunk = count < BIT_DATASET_CHUNK ? count : BIT_DATASET_CHUNK;
+    double* images = dataset && chunk > 0 ? (double*)malloc((size_t)chunk * image_size * sizeof(double)) : NULL;
+    int ok = dataset != NULL && (count == 0 || images != NULL);
+    for (int first = 0; ok && first < count; first += chunk) {
+        int n = count - first < chunk ? count - first : chunk;
+        ok = read_idx_records(image_file, label_file, image_size, (long)start + first, n, images,
+                              dataset->label_indices + first);
+        for (int i = 0; ok && i < n; i++) {
+            pack_threshold_bits(images + (size_t)i * image_size, image_size, threshold,
+                                dataset->bits + (size_t)(first + i) * dataset->words_per_item);
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to read dataset records.\n");
+        free_bit_dataset(dataset);
+        dataset = NULL;
+    }
+
+    free(images);
+    fclose(image_file);
+    fclose(label_file);
+    return dataset;
+}
+
+BitDataset* binarize_dataset(const Dataset* source, double threshold) {
+    BitDataset* dataset = create_bit_dataset(source->num_items, source->images->cols);
+    if (!dataset) return NULL;
+    for (int i = 0; i < source->num_items; i++) {
+        pack_threshold_bits(source->images->data[i], source->images->cols, threshold,
+                            dataset->bits + (size_t)i * dataset->words_per_item);
+        dataset->label_indices[i] = source->label_indices[i];
+    }
+    return dataset;
+}
+
+void free_bit_dataset(BitDataset* dataset) {
+    if (!dataset) return;
+    free(dataset->bits);
+    free(dataset->label_indices);
+    free(dataset);
+}
+
+// --- Dataset Cache ---
+
+// Writes a dataset to a binary cache file. The file is written under a
+// temporary name and renamed into place so readers never see a partial cache.
+int save_dataset_cache(const Dataset* dataset, const char* cache_path, int dtype_size) {
+    if (!dataset || !dataset->images || !dataset->labels) return 0;
+    if (dtype_size != sizeof(double) && dtype_size != sizeof(float)) return 0;
+
+    int num_items = dataset->num_items;
+    int image_size = dataset->images->cols;
+
+    DatasetCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DATASET_CACHE_MAGIC;
+    header.version = DATASET_CACHE_VERSION;
+    header.dtype_size = (uint32_t)dtype_size;
+    header.num_items = (uint32_t)num_items;
+    header.image_size = (uint32_t)image_size;
+    header.num_classes = (uint32_t)dataset->labels->cols;
+    header.images_offset = align_offset(sizeof(DatasetCacheHeader));
+    header.labels_offset = align_offset(header.images_offset + (uint64_t)num_items * image_size * dtype_size);
+    header.file_size = header.labels_offset + (uint64_t)num_items;
+
+    size_t path_len = strlen(cache_path);
+    char* tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return 0;
+    memcpy(tmp_path, cache_path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) {
+        perror("Failed to open dataset cache for writing");
+        free(tmp_path);
+        return 0;
+    }
+
+    static const unsigned char padding[DATASET_CACHE_ALIGNMENT] = {0};
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Float64 images are written as one block since matrix rows are
+    // contiguous; float32 images are narrowed one record at a time
+    size_t num_values = (size_t)num_items * image_size;
+    if (ok && num_values > 0 && dtype_size == sizeof(double)) {
+        ok = fwrite(dataset->images->data[0], sizeof(double), num_values, file) == num_values;
+    } else if (ok && num_values > 0) {
+        float* record = (float*)malloc((size_t)image_size * sizeof(float));
+        ok = record != NULL;
+        for (int i = 0; ok && i < num_items; i++) {
+            for (int j = 0; j < image_size; j++) record[j] = (float)dataset->images->data[i][j];
+            ok = fwrite(record, sizeof(float), image_size, file) == (size_t)image_size;
+        }
+        free(record);
+    }
+    size_t gap = header.labels_offset - (header.images_offset + num_values * dtype_size);
+    if (ok && gap > 0) {
+        ok = fwrite(padding, 1, gap, file) == gap;
+    }
+    if (ok && num_items > 0) {
+        ok = fwrite(dataset->label_indices, 1, num_items, file) == (size_t)num_items;
+    }
+
+    if (fclose(file) != 0) ok = 0;
+    if (ok) ok = rename(tmp_path, cache_path) == 0;
+    if (!ok) remove(tmp_path);
+    free(tmp_path);
+    return ok;
+}
+
+// Maps a cache whose pixels are dtype_size bytes wide, or either width when
+// dtype_size is 0. Float64 images point straight into the mapping; float32
+// images and the one-hot label matrix are materialized.
+static Dataset* map_cache_with_dtype(const char* cache_path, uint32_t dtype_size) {
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DatasetCacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (mapping == MAP_FAILED) return NULL;
+
+    const DatasetCacheHeader* header = (const DatasetCacheHeader*)mapping;
+    if (header->magic != DATASET_CACHE_MAGIC ||
+        header->version != DATASET_CACHE_VERSION ||
+        (header->dtype_size != sizeof(double) && header->dtype_size != sizeof(float)) ||
+        (dtype_size != 0 && header->dtype_size != dtype_size) ||
+        header->file_size != size ||
+        header->num_classes == 0 || header->num_classes > 256 ||
+        header->images_offset % DATASET_CACHE_ALIGNMENT != 0 ||
+        header->labels_offset + header->num_items > size ||
+        header->images_offset + (uint64_t)header->num_items * header->image_size * header->dtype_size >
+            header->labels_offset) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    Dataset* dataset = (Dataset*)calloc(1, sizeof(Dataset));
+    if (!dataset) {
+        munmap(mapping, size);
+        return NULL;
+    }
+    int num_items = (int)header->num_items;
+    dataset->num_items = num_items;
+    dataset->mapping = mapping;
+    dataset->mapping_size = size;
+    dataset->label_indices = (unsigned char*)mapping + header->labels_offset;
+    const char* images = (const char*)mapping + header->images_offset;
+    if (header->dtype_size == sizeof(double)) {
+        dataset->images = create_matrix_view(num_items, (int)header->image_size, (double*)images);
+    } else {
+        dataset->images = create_matrix(num_items, (int)header->image_size);
+    }
+    dataset->labels = create_matrix(num_items, (int)header->num_classes);
+    if (!dataset->images || !dataset->labels) {
+        free_dataset(dataset);
+        return NULL;
+    }
+    if (header->dtype_size == sizeof(float)) {
+        const float* pixels = (const float*)images;
+        size_t num_values = (size_t)num_items * header->image_size;
+        double* widened = num_values > 0 ? dataset->images->data[0] : NULL;
+        for (size_t i = 0; i < num_values; i++) widened[i] = pixels[i];
+    }
+
+    for (int i = 0; i < num_items; i++) {
+        unsigned char label = dataset->label_indices[i];
+        if (label >= header->num_classes) {
+            free_dataset(dataset);
+            return NULL;
+        }
+        dataset->labels->data[i][label] = 1.0;
+    }
+
+    return dataset;
+}
+
+Dataset* map_dataset_cache(const char* cache_path) {
+    return map_cache_with_dtype(cache_path, 0);
+}
+
+// Pixel width GENNET_CACHE_DTYPE asks new caches to use
+static int requested_cache_dtype(void) {
+    const char* requested = getenv("GENNET_CACHE_DTYPE");
+    return requested && strcmp(requested, "float32") == 0 ? (int)sizeof(float) : (int)sizeof(double);
+}
+
+// Returns 1 if the cache file exists and is at least as new as both sources
+static int cache_is_fresh(const char* cache_path, const char* image_path, const char* label_path) {
+    struct stat cache_st, image_st, label_st;
+    if (stat(cache_path, &cache_st) != 0) return 0;
+    if (stat(image_path, &image_st) == 0 && image_st.st_mtime > cache_st.st_mtime) return 0;
+    if (stat(label_path, &label_st) == 0 && label_st.st_mtime > cache_st.st_mtime) return 0;
+    return 1;
+}
+
+// Loads the MNIST dataset through a binary cache, building it on first use
+Dataset* load_mnist_dataset_cached(const char* image_path, const char* label_path, const char* cache_path) {
+    int dtype_size = requested_cache_dtype();
+    if (cache_is_fresh(cache_path, image_path, label_path)) {
+        Dataset* dataset = map_cache_with_dtype(cache_path, (uint32_t)dtype_size);
+        if (dataset) {
+            printf("Mapped %d items from dataset cache %s.\n", dataset->num_items, cache_path);
+            return dataset;
+        }
+        fprintf(stderr, "Ignoring invalid or other-precision dataset cache %s.\n", cache_path);
+    }
+
+    Dataset* dataset = load_mnist_dataset(image_path, label_path);
+    if (!dataset) return NULL;
+
+    if (save_dataset_cache(dataset, cache_path, dtype_size)) {
+        printf("Wrote dataset cache %s.\n", cache_path);
+    } else {
+        fprintf(stderr, "Could not write dataset cache %s.\n", cache_path);
+    }
+    return dataset;
+}
@@ -0,0 +1,236 @@
+#include "dataset_stream.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#define STREAM_BUFFERS 2
+
+struct DatasetStream {
+    FILE* image_file;
+    FILE* label_file;
+    int num_items;
+    int image_size;
+    int batch_size;
+
+    Dataset* buffers[STREAM_BUFFERS];
+    int ready[STREAM_BUFFERS];   // 1 once the producer has filled the buffer
+    int next_record;             // First record of the next batch to read
+    int consumer_slot;           // Slot the consumer reads next
+    int held_slot;               // Slot handed out by the last next(), or -1
+    int end_of_data;
+    int stop;
+    int error;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+// Background producer: fills free buffers in ring order until the data runs out
+static void* stream_producer(void* arg) {
+    DatasetStream* stream = (DatasetStream*)arg;
+    int slot = 0;
+
+    pthread_mutex_lock(&stream->lock);
+    while (!stream->stop && !stream->end_of_data) {
+        if (stream->ready[slot] || slot == stream->held_slot) {
+            pthread_cond_wait(&stream->changed, &stream->lock);
+            continue;
+        }
+        int first = stream->next_record;
+        int count = stream->num_items - first < stream->batch_size ? stream->num_items - first : stream->batch_size;
+        stream->next_record += count;
+        pthread_mutex_unlock(&stream->lock);
+
+        // Disk reads happen outside the lock so the consumer is never blocked on I/O
+        Dataset* batch = stream->buffers[slot];
+        int ok = count == 0 || read_idx_records(stream->image_file, stream->label_file, stream->image_size,
+                                                first, count, batch->images->data[0], batch->label_indices);
+        batch->num_items = count;
+        batch->images->rows = count;
+        batch->labels->rows = count;
+        if (ok) fill_one_hot_labels(batch);
+
+        pthread_mutex_lock(&stream->lock);
+        if (!ok) stream->error = 1;
+        if (!ok || count == 0) {
+            stream->end_of_data = 1;
+        } else {
+            stream->ready[slot] = 1;
+            slot = (slot + 1) % STREAM_BUFFERS;
+            if (stream->next_record >= stream->num_items) stream->end_of_data = 1;
+        }
+        pthread_cond_broadcast(&stream->changed);
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+// Resets the ring and launches the producer thread
+static int start_producer(DatasetStream* stream) {
+    for (int i = 0; i < STREAM_BUFFERS; i++) stream->ready[i] = 0;
+    stream->next_record = 0;
+    stream->consumer_slot = 0;
+    stream->held_slot = -1;
+    stream->end_of_data = stream->num_items == 0;
+    stream->stop = 0;
+    stream->error = 0;
+    return pthread_create(&stream->thread, NULL, stream_producer, stream) == 0;
+}
+
+// Stops and joins the producer thread
+static void stop_producer(DatasetStream* stream) {
+    pthread_mutex_lock(&stream->lock);
+    stream->stop = 1;
+    pthread_cond_broadcast(&stream->changed);
+    pthread_mutex_unlock(&stream->lock);
+    pthread_join(stream->thread, NULL);
+}
+
+// Opens a stream over an IDX image/label pair, reading batch_size records at a time
+DatasetStream* open_dataset_stream(const char* image_path, const char* label_path, int batch_size) {
+    if (batch_size <= 0) return NULL;
+
+    DatasetStream* stream = (DatasetStream*)calloc(1, sizeof(DatasetStream));
+    if (!stream) return NULL;
+
+    if (!open_idx_files(image_path, label_path, &stream->image_file, &stream->label_file,
+                        &stream->num_items, &stream->image_size)) {
+        free(stream);
+        return NULL;
+    }
+    stream->batch_size = batch_size;
+
+    for (int i = 0; i < STREAM_BUFFERS; i++) {
+        stream->buffers[i] = create_dataset(batch_size, stream->image_size, MNIST_NUM_CLASSES);
+        if (!stream->buffers[i]) {
+            for (int j = 0; j < i; j++) free_dataset(stream->buffers[j]);
+            fclose(stream->image_file);
+            fclose(stream->label_file);
+            free(stream);
+            return NULL;
+        }
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->changed, NULL);
+    if (!start_producer(stream)) {
+        fprintf(stderr, "Failed to start dataset stream thread.\n");
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->changed);
+        for (int i = 0; i < STREAM_BUFFERS; i++) free_dataset(stream->buffers[i]);
+        fclose(stream->image_file);
+        fclose(stream->label_file);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+// Hands the next prefetched batch to the caller, releasing the previous one
+const Dataset* dataset_stream_next(DatasetStream* stream) {
+    pthread_mutex_lock(&stream->lock);
+    if (stream->held_slot >= 0) {
+        stream->ready[stream->held_slot] = 0;
+        stream->held_slot = -1;
+        pthread_cond_broadcast(&stream->changed);
+    }
+
+    int slot = stream->consumer_slot;
+    while (!stream->ready[slot] && !stream->end_of_data) {
+        pthread_cond_wait(&stream->changed, &stream->lock);
+    }
+    // The producer may have finished right after filling this slot
+    if (!stream->ready[slot]) {
+        if (stream->error) fprintf(stderr, "Dataset stream read failed.\n");
+        pthread_mutex_unlock(&stream->lock);
+        return NULL;
+    }
+
+    stream->held_slot = slot;
+    stream->consumer_slot = (slot + 1) % STREAM_BUFFERS;
+    pthread_mutex_unlock(&stream->lock);
+    return stream->buffers[slot];
+}
+
+// Restarts the stream from the first record
+void dataset_stream_rewind(DatasetStream* stream) {
+    stop_producer(stream);
+    if (!start_producer(stream)) {
+        fprintf(stderr, "Failed to restart dataset stream thread.\n");
+        stream->end_of_data = 1;
+    }
+}
+
+int dataset_stream_num_items(const DatasetStream* stream) {
+    return stream->num_items;
+}
+
+// Stops the producer and frees both batch buffers
+void close_dataset_stream(DatasetStream* stream) {
+    if (!stream) return;
+    stop_producer(stream);
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->changed);
+    for (int i = 0; i < STREAM_BUFFERS; i++) {
+        // Restore the full row count so the whole block is released
+        stream->buffers[i]->images->rows = stream->batch_size;
+        stream->buffers[i]->labels->rows = stream->batch_size;
+        free_dataset(stream->buffers[i]);
+    }
+    fclose(stream->image_file);
+    fclose(stream->label_file);
+    free(stream);
+}
+
+// --- Streaming Evaluation ---
+
+// Counts rows of a batch output whose largest activation matches the label
+static int count_correct(const Matrix* output, const unsigned char* labels, int rows) {
+    int correct = 0;
+    for (int i = 0; i < rows; i++) {
+        int max_index = 0;
+        for (int j = 1; j < output->cols; j++) {
+            if (output->data[i][j] > output->data[i][max_index]) max_index = j;
+        }
+        if (max_index == labels[i]) correct++;
+    }
+    return correct;
+}
+
+// Accuracy of a network over the first max_samples records of the stream
+double stream_accuracy(const NeuralNetwork* network, DatasetStream* stream, int max_samples) {
+    NetworkFitness entry = {(NeuralNetwork*)network, 0.0};
+    stream_population_fitness(&entry, 1, stream, max_samples);
+    return entry.fitness;
+}
+
+// Scores every network of a population in a single pass over the stream.
+// Each batch is pushed through every network while it is resident.
+void stream_population_fitness(NetworkFitness* population, int population_size,
+                               DatasetStream* stream, int max_samples) {
+    int* correct = (int*)calloc(population_size > 0 ? population_size : 1, sizeof(int));
+    if (!correct) return;
+
+    dataset_stream_rewind(stream);
+    int seen = 0;
+    const Dataset* batch;
+    while ((max_samples <= 0 || seen < max_samples) && (batch = dataset_stream_next(stream)) != NULL) {
+        int rows = batch->num_items;
+        if (max_samples > 0 && seen + rows > max_samples) rows = max_samples - seen;
+
+        for (int n = 0; n < population_size; n++) {
+            Matrix* output = forward_pass(population[n].network, batch->images);
+            if (!output) continue;
+            correct[n] += count_correct(output, batch->label_indices, rows);
+            free_matrix(output);
+        }
+        seen += rows;
+    }
+
+    for (int n = 0; n < population_size; n++) {
+        population[n].fitness = seen > 0 ? (double)correct[n] / seen : 0.0;
+    }
+    free(correct);
+}
@@ -0,0 +1,651 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "distributed.h"
+#include "inference.h"
+#include "model_format.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DISTRIBUTED_MAGIC 0x57444E47u // "GNDW"
+#define DISTRIBUTED_VERSION 2
+#define HEADER_SIZE 12
+#define MAX_PAYLOAD (1u << 30)
+#define MAX_LAYERS 64
+#define CONNECT_ATTEMPTS 50
+#define CONNECT_RETRY_NS 200000000L
+#define POLL_TIMEOUT_MS 1000
+#define READ_CHUNK 65536
+
+enum {
+    MSG_HELLO = 1, // Worker, in answer to SHAPE: version, records held, input width, records fingerprint
+    MSG_SHAPE,     // Master, on accept: layer count, architecture, records to score
+    MSG_JOBS,      // Master: count, then per genome its id and float32 parameters
+    MSG_RESULT,    // Worker: genome id and fitness
+    MSG_SHUTDOWN   // Master: no more work
+};
+
+// --- Byte Buffers ---
+
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+static int buffer_reserve(ByteBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) return 1;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) capacity *= 2;
+    uint8_t* data = (uint8_t*)realloc(buffer->data, capacity);
+    if (!data) return 0;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+static int buffer_append(ByteBuffer* buffer, const void* data, size_t size) {
+    if (!buffer_reserve(buffer, size)) return 0;
+    memcpy(buffer->data + buffer->length, data, size);
+    buffer->length += size;
+    return 1;
+}
+
+static int buffer_append_int(ByteBuffer* buffer, int32_t value) {
+    return buffer_append(buffer, &value, sizeof(value));
+}
+
+static int begin_message(ByteBuffer* buffer, uint32_t type, size_t payload_length) {
+    uint32_t header[3] = {DISTRIBUTED_MAGIC, type, (uint32_t)payload_length};
+    return payload_length <= MAX_PAYLOAD && buffer_reserve(buffer, HEADER_SIZE + payload_length) &&
+           buffer_append(buffer, header, HEADER_SIZE);
+}
+
+// --- Sockets ---
+
+// Resolves "unix:PATH" or "host:port"; an empty host binds every interface
+static int resolve_address(const char* address, int passive, struct sockaddr_storage* addr, socklen_t* length) {
+    memset(addr, 0, sizeof(*addr));
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un* local = (struct sockaddr_un*)addr;
+        const char* path = address + 5;
+        if (path[0] == '\0' || strlen(path) >= sizeof(local->sun_path)) return 0;
+        local->sun_family = AF_UNIX;
+        strcpy(local->sun_path, path);
+        *length = sizeof(struct sockaddr_un);
+        return 1;
+    }
+    const char* colon = strrchr(address, ':');
+    char host[256];
+    size_t host_length = colon ? (size_t)(colon - address) : 0;
+    if (!colon || colon[1] == '\0' || host_length >= sizeof(host)) return 0;
+    memcpy(host, address, host_length);
+    host[host_length] = '\0';
+
+    struct addrinfo hints, *result = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    if (getaddrinfo(host_length ? host : NULL, colon + 1, &hints, &result) != 0 || !result) return 0;
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *length = result->ai_addrlen;
+    freeaddrinfo(result);
+    return 1;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// --- Master ---
+
+typedef struct {
+    int fd;
+    int ready;        // Sent a HELLO that matches the master's shape and records
+    ByteBuffer out;   // Queued messages; out_sent bytes already written
+    size_t out_sent;
+    ByteBuffer in;    // Received bytes not yet parsed
+    int* in_flight;   // Population indices sent and not yet answered
+    int num_in_flight;
+} WorkerConnection;
+
+struct DistributedMaster {
+    int listen_fd;
+    char unix_path[108];  // Socket file to remove on stop, or empty
+    int num_layers;
+    int* architecture;
+    int num_samples;
+    int batch_size;
+    size_t num_params;
+    const Dataset* dataset;
+    int score_locally;
+    uint32_t fingerprint; // dataset_fingerprint of the records workers must hold
+    WorkerConnection* workers;
+    int num_workers;
+    int capacity;
+    struct pollfd* poll_fds;
+    double* genome;       // flatten_network scratch
+    NeuralNetwork* shape; // Unpacks genomes for local scoring
+    uint32_t next_job_id;
+    int waiting_reported;
+    DistributedStats stats;
+};
+
+// State of one distributed_evaluate call
+typedef struct {
+    NetworkFitness* population;
+    int population_size;
+    uint32_t first_id;    // Genome i of this call has id first_id + i
+    int* pending;         // Stack of population indices waiting to be sent
+    int num_pending;
+    char* done;
+    int remaining;
+} Evaluation;
+
+static int queue_shape(DistributedMaster* master, WorkerConnection* worker) {
+    size_t length = sizeof(int32_t) * (master->num_layers + 2);
+    if (!begin_message(&worker->out, MSG_SHAPE, length)) return 0;
+    buffer_append_int(&worker->out, master->num_layers);
+    for (int l = 0; l < master->num_layers; l++) buffer_append_int(&worker->out, master->architecture[l]);
+    return buffer_append_int(&worker->out, master->num_samples);
+}
+
+static void accept_workers(DistributedMaster* master) {
+    for (;;) {
+        int fd = accept(master->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        if (master->num_workers == master->capacity) {
+            int capacity = master->capacity ? master->capacity * 2 : 8;
+            WorkerConnection* workers =
+                (WorkerConnection*)realloc(master->workers, capacity * sizeof(WorkerConnection));
+            struct pollfd* poll_fds = workers ? (struct pollfd*)realloc(master->poll_fds, (capacity + 1) *
+                                                                                          sizeof(struct pollfd))
+                                              : NULL;
+            if (workers) master->workers = workers;
+            if (!poll_fds) {
+                close(fd);
+                return;
+            }
+            master->poll_fds = poll_fds;
+            master->capacity = capacity;
+        }
+        WorkerConnection* worker = &master->workers[master->num_workers];
+        memset(worker, 0, sizeof(*worker));
+        worker->fd = fd;
+        worker->in_flight = (int*)malloc(2 * master->batch_size * sizeof(int));
+        if (!worker->in_flight || !set_nonblocking(fd) || !queue_shape(master, worker)) {
+            free(worker->in_flight);
+            free(worker->out.data);
+            close(fd);
+            continue;
+        }
+        master->num_workers++;
+    }
+}
+
+// Closes a worker and puts the genomes it still held back on the queue
+static void drop_worker(DistributedMaster* master, int index, Evaluation* evaluation) {
+    WorkerConnection* worker = &master->workers[index];
+    for (int j = 0; evaluation && j < worker->num_in_flight; j++) {
+        int job = worker->in_flight[j];
+        if (!evaluation->done[job]) {
+            evaluation->pending[evaluation->num_pending++] = job;
+            master->stats.jobs_requeued++;
+        }
+    }
+    close(worker->fd);
+    free(worker->out.data);
+    free(worker->in.data);
+    free(worker->in_flight);
+    master->workers[index] = master->workers[--master->num_workers];
+}
+
+// Writes as much queued output as the socket takes. Returns 0 on error.
+static int flush_worker(WorkerConnection* worker) {
+    while (worker->out_sent < worker->out.length) {
+        ssize_t sent = send(worker->fd, worker->out.data + worker->out_sent, worker->out.length - worker->out_sent,
+                            MSG_NOSIGNAL);
+        if (sent > 0) {
+            worker->out_sent += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    worker->out.length = worker->out_sent = 0;
+    return 1;
+}
+
+// Handles one complete message from a worker. Returns 0 to drop the worker.
+static int handle_message(DistributedMaster* master, WorkerConnection* worker, uint32_t type, const uint8_t* payload,
+                          uint32_t length, Evaluation* evaluation) {
+    if (type == MSG_HELLO) {
+        uint32_t hello[4];
+        if (length != sizeof(hello)) return 0;
+        memcpy(hello, payload, sizeof(hello));
+        if (hello[0] != DISTRIBUTED_VERSION || hello[1] < (uint32_t)master->num_samples ||
+            hello[2] != (uint32_t)master->architecture[0]) {
+            fprintf(stderr, "Rejected a worker holding %u records of width %u.\n", hello[1], hello[2]);
+            return 0;
+        }
+        if (hello[3] != master->fingerprint) {
+            fprintf(stderr, "Rejected a worker whose first %d records differ from the master's "
+                            "(fingerprint %08x, expected %08x).\n",
+                    master->num_samples, hello[3], master->fingerprint);
+            return 0;
+        }
+        worker->ready = 1;
+        master->waiting_reported = 0;
+        return 1;
+    }
+    if (type != MSG_RESULT || length != sizeof(uint32_t) + sizeof(double)) return 0;
+    uint32_t id;
+    double fitness;
+    memcpy(&id, payload, sizeof(id));
+    memcpy(&fitness, payload + sizeof(id), sizeof(fitness));
+    if (!evaluation) return 1;
+    // Ids from an earlier call are stale and ignored
+    uint32_t job = id - evaluation->first_id;
+    for (int j = 0; j < worker->num_in_flight; j++) {
+        if ((uint32_t)worker->in_flight[j] != job || job >= (uint32_t)evaluation->population_size) continue;
+        worker->in_flight[j] = worker->in_flight[--worker->num_in_flight];
+        if (!evaluation->done[job]) {
+            evaluation->population[job].fitness = fitness;
+            evaluation->done[job] = 1;
+            evaluation->remaining--;
+        }
+        break;
+    }
+    return 1;
+}
+
+// Reads everything available and handles complete messages. Returns 0 if
+// the worker disconnected or broke the protocol.
+static int read_worker(DistributedMaster* master, WorkerConnection* worker, Evaluation* evaluation) {
+    // Results sent just before a worker exits arrive together with the
+    // end of the stream and still count
+    int open = 1;
+    for (;;) {
+        if (!buffer_reserve(&worker->in, READ_CHUNK)) return 0;
+        ssize_t received = recv(worker->fd, worker->in.data + worker->in.length, READ_CHUNK, 0);
+        if (received > 0) {
+            worker->in.length += (size_t)received;
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        open = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        break;
+    }
+    size_t offset = 0;
+    while (worker->in.length - offset >= HEADER_SIZE) {
+        uint32_t header[3];
+        memcpy(header, worker->in.data + offset, HEADER_SIZE);
+        if (header[0] != DISTRIBUTED_MAGIC || header[2] > MAX_PAYLOAD) return 0;
+        if (worker->in.length - offset - HEADER_SIZE < header[2]) break;
+        if (!handle_message(master, worker, header[1], worker->in.data + offset + HEADER_SIZE, header[2],
+                            evaluation)) {
+            return 0;
+        }
+        offset += HEADER_SIZE + header[2];
+    }
+    memmove(worker->in.data, worker->in.data + offset, worker->in.length - offset);
+    worker->in.length -= offset;
+    return open;
+}
+
+// Queues batches for every ready worker with room for another one
+static int dispatch_jobs(DistributedMaster* master, Evaluation* evaluation) {
+    int limit = 2 * master->batch_size;
+    for (int w = 0; w < master->num_workers && evaluation->num_pending > 0; w++) {
+        WorkerConnection* worker = &master->workers[w];
+        while (worker->ready && evaluation->num_pending > 0 && worker->num_in_flight < limit) {
+            int count = master->batch_size;
+            if (count > evaluation->num_pending) count = evaluation->num_pending;
+            if (count > limit - worker->num_in_flight) count = limit - worker->num_in_flight;
+            size_t job_size = sizeof(uint32_t) + master->num_params * sizeof(float);
+            if (!begin_message(&worker->out, MSG_JOBS, sizeof(int32_t) + count * job_size)) return 0;
+            buffer_append_int(&worker->out, count);
+            for (int j = 0; j < count; j++) {
+                int job = evaluation->pending[--evaluation->num_pending];
+                uint32_t id = evaluation->first_id + (uint32_t)job;
+                buffer_append(&worker->out, &id, sizeof(id));
+                flatten_network(evaluation->population[job].network, master->genome);
+                uint8_t* params = worker->out.data + worker->out.length;
+                for (size_t p = 0; p < master->num_params; p++) {
+                    float value = (float)master->genome[p];
+                    memcpy(params + p * sizeof(float), &value, sizeof(value));
+                }
+                worker->out.length += master->num_params * sizeof(float);
+                worker->in_flight[worker->num_in_flight++] = job;
+            }
+            master->stats.jobs_sent += count;
+        }
+    }
+    return 1;
+}
+
+// Scores one pending genome on the master itself, rounded as a worker would
+static void score_locally(DistributedMaster* master, Evaluation* evaluation) {
+    int job = evaluation->pending[--evaluation->num_pending];
+    flatten_network(evaluation->population[job].network, master->genome);
+    for (size_t p = 0; p < master->num_params; p++) master->genome[p] = (float)master->genome[p];
+    unflatten_network(master->shape, master->genome);
+    evaluation->population[job].fitness = network_accuracy(master->shape, master->dataset, master->num_samples);
+    evaluation->done[job] = 1;
+    evaluation->remaining--;
+    master->stats.jobs_local++;
+}
+
+uint32_t dataset_fingerprint(const Dataset* dataset, int num_samples) {
+    uint32_t crc = 0;
+    for (int i = 0; i < num_samples; i++) {
+        crc = crc32_update(crc, dataset->images->data[i], (size_t)dataset->images->cols * sizeof(double));
+    }
+    return crc32_update(crc, dataset->label_indices, (size_t)num_samples);
+}
+
+DistributedMaster* start_master(const char* address, int num_layers, const int* architecture, int num_samples,
+                                int batch_size, const Dataset* dataset, int score_locally) {
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (num_layers < 2 || num_layers > MAX_LAYERS || num_samples < 1 || batch_size < 1 || !dataset ||
+        dataset->num_items < num_samples || dataset->images->cols != architecture[0]) {
+        return NULL;
+    }
+    if (!resolve_address(address, 1, &addr, &length)) {
+        fprintf(stderr, "Cannot resolve master address %s.\n", address);
+        return NULL;
+    }
+    DistributedMaster* master = (DistributedMaster*)calloc(1, sizeof(DistributedMaster));
+    if (!master) return NULL;
+    master->listen_fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    master->num_layers = num_layers;
+    master->num_samples = num_samples;
+    master->batch_size = batch_size;
+    master->dataset = dataset;
+    master->score_locally = score_locally;
+    master->fingerprint = dataset_fingerprint(dataset, num_samples);
+    master->architecture = (int*)malloc(num_layers * sizeof(int));
+    master->shape = create_neural_network(num_layers, architecture);
+    master->poll_fds = (struct pollfd*)malloc(sizeof(struct pollfd));
+    int ok = master->listen_fd >= 0 && master->architecture && master->shape && master->poll_fds;
+    if (ok) {
+        memcpy(master->architecture, architecture, num_layers * sizeof(int));
+        master->num_params = network_num_params(master->shape);
+        master->genome = (double*)malloc(master->num_params * sizeof(double));
+        ok = master->genome != NULL;
+    }
+    if (ok && addr.ss_family == AF_UNIX) {
+        // A socket file left by an earlier run would make bind fail
+        strcpy(master->unix_path, ((struct sockaddr_un*)&addr)->sun_path);
+        unlink(master->unix_path);
+    } else if (ok) {
+        int reuse = 1;
+        setsockopt(master->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (ok && (bind(master->listen_fd, (struct sockaddr*)&addr, length) != 0 || listen(master->listen_fd, 64) != 0 ||
+               !set_nonblocking(master->listen_fd))) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", address, strerror(errno));
+        master->unix_path[0] = '\0';
+        ok = 0;
+    }
+    if (!ok) {
+        stop_master(master);
+        return NULL;
+    }
+    return master;
+}
+
+int distributed_evaluate(DistributedMaster* master, NetworkFitness* population, int population_size) {
+    Evaluation evaluation = {population, population_size, master->next_job_id, NULL, 0, NULL, population_size};
+    master->next_job_id += (uint32_t)population_size;
+    evaluation.pending = (int*)malloc(population_size * sizeof(int));
+    evaluation.done = (char*)calloc(population_size, 1);
+    if (!evaluation.pending || !evaluation.done) {
+        free(evaluation.pending);
+        free(evaluation.done);
+        return 0;
+    }
+    // Popped from the end, so genome 0 goes out first
+    for (int i = 0; i < population_size; i++) evaluation.pending[i] = population_size - 1 - i;
+    evaluation.num_pending = population_size;
+
+    int ok = 1;
+    while (ok && evaluation.remaining > 0) {
+        ok = dispatch_jobs(master, &evaluation);
+        int ready = 0;
+        for (int w = master->num_workers - 1; w >= 0; w--) {
+            if (!flush_worker(&master->workers[w])) {
+                drop_worker(master, w, &evaluation);
+            } else {
+                ready += master->workers[w].ready;
+            }
+        }
+        int timeout = POLL_TIMEOUT_MS;
+        if (!ready && evaluation.num_pending > 0) {
+            if (master->score_locally) {
+                score_locally(master, &evaluation);
+                timeout = 0;
+            } else if (!master->waiting_reported) {
+                printf("Waiting for a worker to connect...\n");
+                fflush(stdout);
+                master->waiting_reported = 1;
+            }
+        }
+
+        master->poll_fds[0].fd = master->listen_fd;
+        master->poll_fds[0].events = POLLIN;
+        for (int w = 0; w < master->num_workers; w++) {
+            WorkerConnection* worker = &master->workers[w];
+            master->poll_fds[w + 1].fd = worker->fd;
+            master->poll_fds[w + 1].events = POLLIN | (worker->out.length > worker->out_sent ? POLLOUT : 0);
+            master->poll_fds[w + 1].revents = 0;
+        }
+        int polled = master->num_workers;
+        if (poll(master->poll_fds, polled + 1, timeout) < 0 && errno != EINTR) {
+            ok = 0;
+            break;
+        }
+        // Descending, so a dropped worker is replaced by one already handled
+        for (int w = polled - 1; w >= 0; w--) {
+            short events = master->poll_fds[w + 1].revents;
+            WorkerConnection* worker = &master->workers[w];
+            int alive = 1;
+            if (events & (POLLIN | POLLHUP | POLLERR)) alive = read_worker(master, worker, &evaluation);
+            if (alive && (events & POLLOUT)) alive = flush_worker(worker);
+            if (!alive) drop_worker(master, w, &evaluation);
+        }
+        if (master->poll_fds[0].revents & POLLIN) accept_workers(master);
+    }
+
+    // Answers still on their way are for ids this call no longer accepts
+    for (int w = 0; w < master->num_workers; w++) master->workers[w].num_in_flight = 0;
+    free(evaluation.pending);
+    free(evaluation.done);
+    return ok && evaluation.remaining == 0;
+}
+
+void distributed_stats(const DistributedMaster* master, DistributedStats* stats) {
+    *stats = master->stats;
+    stats->workers = 0;
+    for (int w = 0; w < master->num_workers; w++) stats->workers += master->workers[w].ready;
+}
+
+void stop_master(DistributedMaster* master) {
+    if (!master) return;
+    for (int w = master->num_workers - 1; w >= 0; w--) {
+        WorkerConnection* worker = &master->workers[w];
+        // Best effort: a worker that misses the message sees the socket close
+        fcntl(worker->fd, F_SETFL, fcntl(worker->fd, F_GETFL, 0) & ~O_NONBLOCK);
+        if (begin_message(&worker->out, MSG_SHUTDOWN, 0)) flush_worker(worker);
+        drop_worker(master, w, NULL);
+    }
+    if (master->listen_fd >= 0) close(master->listen_fd);
+    if (master->unix_path[0]) unlink(master->unix_path);
+    free(master->workers);
+    free(master->poll_fds);
+    free(master->architecture);
+    free(master->genome);
+    free_neural_network(master->shape);
+    free(master);
+}
+
+// --- Worker ---
+
+static int send_all(int fd, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (length > 0) {
+        ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return 0;
+        bytes += sent;
+        length -= (size_t)sent;
+    }
+    return 1;
+}
+
+static int recv_all(int fd, void* data, size_t length) {
+    uint8_t* bytes = (uint8_t*)data;
+    while (length > 0) {
+        ssize_t received = recv(fd, bytes, length, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return 0;
+        bytes += received;
+        length -= (size_t)received;
+    }
+    return 1;
+}
+
+static int connect_to_master(const char* address) {
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (!resolve_address(address, 0, &addr, &length)) {
+        fprintf(stderr, "Cannot resolve master address %s.\n", address);
+        return -1;
+    }
+    struct timespec retry = {0, CONNECT_RETRY_NS};
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++) {
+        int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&addr, length) == 0) return fd;
+        close(fd);
+        nanosleep(&retry, NULL);
+    }
+    fprintf(stderr, "Cannot connect to master at %s.\n", address);
+    return -1;
+}
+
+long run_worker(const char* address, const Dataset* dataset, long max_jobs) {
+    int fd = connect_to_master(address);
+    if (fd < 0) return -1;
+    ByteBuffer message = {NULL, 0, 0};
+    int ok = 1;
+
+    NeuralNetwork* net = NULL;
+    double* genome = NULL;
+    size_t num_params = 0;
+    int num_samples = 0;
+    long scored = 0;
+    int finished = 0;
+    int accepted = 0; // Received work after the HELLO
+    while (ok && !finished) {
+        uint32_t header[3];
+        if (!recv_all(fd, header, HEADER_SIZE)) {
+            // A master that turns a worker away closes without a SHUTDOWN
+            if (net && !accepted) {
+                fprintf(stderr, "The master closed the connection without sending work; check that "
+                                "both hold the same records.\n");
+                scored = -1;
+            }
+            break; // Master went away
+        }
+        message.length = 0;
+        ok = header[0] == DISTRIBUTED_MAGIC && header[2] <= MAX_PAYLOAD && buffer_reserve(&message, header[2]) &&
+             recv_all(fd, message.data, header[2]);
+        if (!ok) break;
+        const uint8_t* payload = message.data;
+        if (header[1] == MSG_SHUTDOWN) {
+            finished = 1;
+        } else if (header[1] == MSG_SHAPE) {
+            int32_t num_layers = 0;
+            int architecture[MAX_LAYERS];
+            if (header[2] >= sizeof(int32_t)) memcpy(&num_layers, payload, sizeof(num_layers));
+            ok = num_layers >= 2 && num_layers <= MAX_LAYERS &&
+                 header[2] == sizeof(int32_t) * (size_t)(num_layers + 2);
+            if (!ok) break;
+            for (int l = 0; l < num_layers; l++) {
+                int32_t size;
+                memcpy(&size, payload + sizeof(int32_t) * (l + 1), sizeof(size));
+                architecture[l] = size;
+            }
+            int32_t samples;
+            memcpy(&samples, payload + sizeof(int32_t) * (num_layers + 1), sizeof(samples));
+            num_samples = samples;
+            ok = architecture[0] == dataset->images->cols && num_samples >= 1 && num_samples <= dataset->num_items;
+            if (!ok) {
+                fprintf(stderr, "The master's networks do not fit this worker's dataset.\n");
+                scored = -1;
+                break;
+            }
+            free_neural_network(net);
+            free(genome);
+            net = create_neural_network(num_layers, architecture);
+            num_params = net ? network_num_params(net) : 0;
+            genome = (double*)malloc((num_params ? num_params : 1) * sizeof(double));
+            // The fingerprint covers exactly the records the master asked for
+            uint32_t hello[4] = {DISTRIBUTED_VERSION, (uint32_t)dataset->num_items, (uint32_t)dataset->images->cols,
+                                 dataset_fingerprint(dataset, num_samples)};
+            ByteBuffer reply = {NULL, 0, 0};
+            ok = net && genome && begin_message(&reply, MSG_HELLO, sizeof(hello)) &&
+                 buffer_append(&reply, hello, sizeof(hello)) && send_all(fd, reply.data, reply.length);
+            free(reply.data);
+        } else if (header[1] == MSG_JOBS && net) {
+            accepted = 1;
+            int32_t count = 0;
+            size_t job_size = sizeof(uint32_t) + num_params * sizeof(float);
+            if (header[2] >= sizeof(int32_t)) memcpy(&count, payload, sizeof(count));
+            ok = count >= 0 && header[2] == sizeof(int32_t) + (size_t)count * job_size;
+            for (int j = 0; ok && j < count && !finished; j++) {
+                const uint8_t* job = payload + sizeof(int32_t) + j * job_size;
+                uint32_t id;
+                memcpy(&id, job, sizeof(id));
+                for (size_t p = 0; p < num_params; p++) {
+                    float value;
+                    memcpy(&value, job + sizeof(id) + p * sizeof(float), sizeof(value));
+                    genome[p] = value;
+                }
+                unflatten_network(net, genome);
+                double fitness = network_accuracy(net, dataset, num_samples);
+                // Each result goes back as soon as it is known
+                uint8_t result[HEADER_SIZE + sizeof(uint32_t) + sizeof(double)];
+                uint32_t result_header[3] = {DISTRIBUTED_MAGIC, MSG_RESULT, sizeof(uint32_t) + sizeof(double)};
+                memcpy(result, result_header, HEADER_SIZE);
+                memcpy(result + HEADER_SIZE, &id, sizeof(id));
+                memcpy(result + HEADER_SIZE + sizeof(id), &fitness, sizeof(fitness));
+                ok = send_all(fd, result, sizeof(result));
+                scored++;
+                finished = max_jobs > 0 && scored >= max_jobs;
+            }
+        } else {
+            ok = 0;
+        }
+    }
+
+    close(fd);
+    free(message.data);
+    free(genome);
+    free_neural_network(net);
+    return scored;
+}
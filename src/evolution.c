@@ -1,6 +1,8 @@
 #include "evolution.h"
+#include "sparse_network.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 // --- Evolution Functions Implementation ---
 
@@ -11,6 +13,11 @@ NeuralNetwork** create_initial_population(int population_size, int num_layers, c
 
     for (int i = 0; i < population_size; i++) {
         population[i] = create_neural_network(num_layers, architecture);
+        if (!population[i]) {
+            for (int j = 0; j < i; j++) free_neural_network(population[j]);
+            free(population);
+            return NULL;
+        }
     }
     return population;
 }
@@ -51,11 +58,17 @@ NeuralNetwork* crossover(const NeuralNetwork* parent1, const NeuralNetwork* pare
         return NULL;
     }
 
-    // Create a new network with the same architecture
-    NeuralNetwork* child = create_neural_network(parent1->num_layers, parent1->architecture);
+    // Create a new network with the same architecture; every parameter is
+    // overwritten below, so it is not initialized
+    NeuralNetwork* child = create_zeroed_network(parent1->num_layers, parent1->architecture);
     if (!child) return NULL;
+    crossover_into(child, parent1, parent2);
+    return child;
+}
 
-    // Average the weights and biases
+// Averages the parents' weights and biases into an existing child
+void crossover_into(NeuralNetwork* child, const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
+    detach_sparse_weights(child);
     for (int i = 0; i < parent1->num_layers - 1; i++) {
         // Weights
         for (int r = 0; r < parent1->weights[i]->rows; r++) {
@@ -68,8 +81,6 @@ NeuralNetwork* crossover(const NeuralNetwork* parent1, const NeuralNetwork* pare
             child->biases[i]->data[0][c] = (parent1->biases[i]->data[0][c] + parent2->biases[i]->data[0][c]) / 2.0;
         }
     }
-
-    return child;
 }
 
 // Creates a new generation using crossover and mutation
@@ -101,3 +112,303 @@ NeuralNetwork** reproduce(const NetworkFitness* fittest_networks, int num_fittes
 
     return new_population;
 }
+
+// --- Explicit-Stream Operators ---
+
+void mutate_network_rng(NeuralNetwork* net, float mutation_rate, float mutation_chance, Rng* rng) {
+    detach_sparse_weights(net);
+    for (int i = 0; i < net->num_layers - 1; i++) {
+        // Weight rows are contiguous, so each layer is one flat block
+        double* weights = net->weights[i]->data[0];
+        size_t count = (size_t)net->weights[i]->rows * net->weights[i]->cols;
+        for (size_t k = 0; k < count; k++) {
+            if (rng_uniform(rng) < mutation_chance) {
+                weights[k] += (rng_uniform(rng) - 0.5) * mutation_rate;
+            }
+        }
+        double* biases = net->biases[i]->data[0];
+        for (int c = 0; c < net->biases[i]->cols; c++) {
+            if (rng_uniform(rng) < mutation_chance) {
+                biases[c] += (rng_uniform(rng) - 0.5) * mutation_rate;
+            }
+        }
+    }
+}
+
+NeuralNetwork** create_initial_population_rng(int population_size, int num_layers, const int* architecture, Rng* rng) {
+    NeuralNetwork** population = (NeuralNetwork**)calloc(population_size, sizeof(NeuralNetwork*));
+    if (!population) return NULL;
+
+    for (int i = 0; i < population_size; i++) {
+        NeuralNetwork* net = create_zeroed_network(num_layers, architecture);
+        if (!net) {
+            for (int j = 0; j < i; j++) free_neural_network(population[j]);
+            free(population);
+            return NULL;
+        }
+        // The same He-style uniform draw as initialize_network
+        for (int l = 0; l < num_layers - 1; l++) {
+            double* weights = net->weights[l]->data[0];
+            size_t count = (size_t)architecture[l] * architecture[l + 1];
+            double scale = sqrt(2.0 / architecture[l]);
+            for (size_t k = 0; k < count; k++) weights[k] = rng_uniform(rng) * scale;
+        }
+        population[i] = net;
+    }
+    return population;
+}
+
+NeuralNetwork** reproduce_rng(const NetworkFitness* fittest_networks, int num_fittest, int new_population_size, float mutation_rate, float mutation_chance, Rng* rng) {
+    if (num_fittest == 0) return NULL;
+
+    NeuralNetwork** new_population = (NeuralNetwork**)malloc(new_population_size * sizeof(NeuralNetwork*));
+    if (!new_population) return NULL;
+
+    for (int i = 0; i < new_population_size; i++) {
+        const NeuralNetwork* parent1 = fittest_networks[rng_below(rng, num_fittest)].network;
+        const NeuralNetwork* parent2 = fittest_networks[rng_below(rng, num_fittest)].network;
+        NeuralNetwork* child = crossover(parent1, parent2);
+        if (!child) {
+            child = clone_network(parent1);
+        }
+        mutate_network_rng(child, mutation_rate, mutation_chance, rng);
+        new_population[i] = child;
+    }
+
+    return new_population;
+}
+
+// --- Genome Evolution Implementation ---
+
+void** create_initial_genome_population(const GenomeOps* ops, int population_size, int num_layers, const int* architecture) {
+    void** population = (void**)calloc(population_size, sizeof(void*));
+    if (!population) return NULL;
+
+    for (int i = 0; i < population_size; i++) {
+        population[i] = ops->create(num_layers, architecture);
+        if (!population[i]) {
+            free_genome_population(ops, population, i);
+            return NULL;
+        }
+    }
+    return population;
+}
+
+void free_genome_population(const GenomeOps* ops, void** population, int population_size) {
+    if (!population) return;
+    for (int i = 0; i < population_size; i++) ops->free_genome(population[i]);
+    free(population);
+}
+
+int compare_genome_fitness(const void* a, const void* b) {
+    const GenomeFitness* gf_a = (const GenomeFitness*)a;
+    const GenomeFitness* gf_b = (const GenomeFitness*)b;
+    if (gf_a->fitness < gf_b->fitness) return 1;
+    if (gf_a->fitness > gf_b->fitness) return -1;
+    return 0;
+}
+
+// Selects the top half, like select_fittest
+GenomeFitness* select_fittest_genomes(GenomeFitness* population_with_fitness, int population_size, int* num_fittest) {
+    qsort(population_with_fitness, population_size, sizeof(GenomeFitness), compare_genome_fitness);
+
+    *num_fittest = population_size / 2;
+    GenomeFitness* fittest = (GenomeFitness*)malloc(*num_fittest * sizeof(GenomeFitness));
+    if (!fittest) {
+        *num_fittest = 0;
+        return NULL;
+    }
+    for (int i = 0; i < *num_fittest; i++) {
+        fittest[i] = population_with_fitness[i];
+    }
+    return fittest;
+}
+
+void** reproduce_genomes(const GenomeOps* ops, const GenomeFitness* fittest_genomes, int num_fittest, int new_population_size, float mutation_rate, float mutation_chance) {
+    if (num_fittest == 0) return NULL;
+
+    void** new_population = (void**)calloc(new_population_size, sizeof(void*));
+    if (!new_population) return NULL;
+
+    for (int i = 0; i < new_population_size; i++) {
+        const void* parent1 = fittest_genomes[rand() % num_fittest].genome;
+        const void* parent2 = fittest_genomes[rand() % num_fittest].genome;
+
+        void* child = ops->crossover(parent1, parent2);
+        if (!child) child = ops->clone(parent1);
+        if (!child) {
+            free_genome_population(ops, new_population, i);
+            return NULL;
+        }
+        ops->mutate(child, mutation_rate, mutation_chance);
+        new_population[i] = child;
+    }
+    return new_population;
+}
+
+// --- Integer Genome Operators ---
+
+// The child's weights and bias steps are the parents' averages, rounded to
+// nearest. Parents of the same architecture share every layer scale.
+QuantizedNetwork* crossover_quantized(const QuantizedNetwork* parent1, const QuantizedNetwork* parent2) {
+    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
+        return NULL;
+    }
+
+    QuantizedNetwork* child = clone_quantized_network(parent1);
+    if (!child) return NULL;
+
+    for (int l = 0; l < parent1->num_layers - 1; l++) {
+        size_t count = (size_t)parent1->architecture[l + 1] * parent1->padded_inputs[l];
+        const int8_t* a = parent1->weights[l];
+        const int8_t* b = parent2->weights[l];
+        int8_t* out = child->weights[l];
+        // Halves round away from zero; the sum of two int8 values fits in int
+        for (size_t i = 0; i < count; i++) {
+            int sum = a[i] + b[i];
+            out[i] = (int8_t)((sum + (sum > 0) - (sum < 0)) / 2);
+        }
+        for (int j = 0; j < parent1->architecture[l + 1]; j++) {
+            float scale = parent1->scales[l][j];
+            long steps = lrint(parent1->biases[l][j] / scale) + lrint(parent2->biases[l][j] / scale);
+            child->biases[l][j] = (float)((steps + (steps > 0) - (steps < 0)) / 2) * scale;
+        }
+    }
+    update_quantized_row_sums(child);
+    return child;
+}
+
+void mutate_quantized_network(QuantizedNetwork* qnet, float mutation_rate, float mutation_chance) {
+    for (int l = 0; l < qnet->num_layers - 1; l++) {
+        int inputs = qnet->architecture[l];
+        int outputs = qnet->architecture[l + 1];
+        for (int j = 0; j < outputs; j++) {
+            float scale = qnet->scales[l][j];
+            long max_step = lrint(mutation_rate * 0.5 / scale);
+            if (max_step < 1) max_step = 1;
+
+            int8_t* row = qnet->weights[l] + (size_t)j * qnet->padded_inputs[l];
+            for (int k = 0; k < inputs; k++) {
+                if (((double)rand() / RAND_MAX) < mutation_chance) {
+                    long value = row[k] + rand() % (2 * max_step + 1) - max_step;
+                    if (value > 127) value = 127;
+                    if (value < -127) value = -127;
+                    row[k] = (int8_t)value;
+                }
+            }
+            if (((double)rand() / RAND_MAX) < mutation_chance) {
+                long steps = lrint(qnet->biases[l][j] / scale) + rand() % (2 * max_step + 1) - max_step;
+                if (steps > GENOME_BIAS_LIMIT) steps = GENOME_BIAS_LIMIT;
+                if (steps < -GENOME_BIAS_LIMIT) steps = -GENOME_BIAS_LIMIT;
+                qnet->biases[l][j] = (float)steps * scale;
+            }
+        }
+    }
+    update_quantized_row_sums(qnet);
+}
+
+static void* quantized_create(int num_layers, const int* architecture) {
+    return create_quantized_genome(num_layers, architecture);
+}
+
+static void* quantized_crossover(const void* parent1, const void* parent2) {
+    return crossover_quantized((const QuantizedNetwork*)parent1, (const QuantizedNetwork*)parent2);
+}
+
+static void* quantized_clone(const void* genome) {
+    return clone_quantized_network((const QuantizedNetwork*)genome);
+}
+
+static void quantized_mutate(void* genome, float mutation_rate, float mutation_chance) {
+    mutate_quantized_network((QuantizedNetwork*)genome, mutation_rate, mutation_chance);
+}
+
+static void quantized_free(void* genome) {
+    free_quantized_network((QuantizedNetwork*)genome);
+}
+
+static void quantized_score(void** population, int population_size, const void* data, int num_samples, double* fitness) {
+    const Dataset* dataset = (const Dataset*)data;
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    for (int n = 0; n < population_size; n++) {
+        QuantizedNetwork* qnet = (QuantizedNetwork*)population[n];
+        int correct = 0;
+        for (int i = 0; i < num_samples; i++) {
+            if (quantized_predict(qnet, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+        }
+        fitness[n] = (double)correct / num_samples;
+    }
+}
+
+const GenomeOps quantized_genome_ops = {
+    quantized_create, quantized_crossover, quantized_clone, quantized_mutate, quantized_free, quantized_score,
+};
+
+// --- Half-Precision Genome Operators ---
+
+static void* fp16_create(int num_layers, const int* architecture) {
+    return create_half_network(num_layers, architecture, HALF_FP16);
+}
+
+static void* bf16_create(int num_layers, const int* architecture) {
+    return create_half_network(num_layers, architecture, HALF_BF16);
+}
+
+static void* half_crossover(const void* parent1, const void* parent2) {
+    return crossover_half((const HalfNetwork*)parent1, (const HalfNetwork*)parent2);
+}
+
+static void* half_clone(const void* genome) {
+    return clone_half_network((const HalfNetwork*)genome);
+}
+
+static void half_mutate(void* genome, float mutation_rate, float mutation_chance) {
+    mutate_half_network((HalfNetwork*)genome, mutation_rate, mutation_chance);
+}
+
+static void half_free(void* genome) {
+    free_half_network((HalfNetwork*)genome);
+}
+
+static void half_score(void** population, int population_size, const void* dataset, int num_samples, double* fitness) {
+    half_population_fitness((HalfNetwork**)population, population_size, (const Dataset*)dataset, num_samples, fitness);
+}
+
+const GenomeOps fp16_genome_ops = {
+    fp16_create, half_crossover, half_clone, half_mutate, half_free, half_score,
+};
+
+const GenomeOps bf16_genome_ops = {
+    bf16_create, half_crossover, half_clone, half_mutate, half_free, half_score,
+};
+
+// --- Binarized Genome Operators ---
+
+static void* binarized_create(int num_layers, const int* architecture) {
+    return create_binarized_genome(num_layers, architecture);
+}
+
+static void* binarized_crossover(const void* parent1, const void* parent2) {
+    return crossover_binarized((const BinarizedNetwork*)parent1, (const BinarizedNetwork*)parent2);
+}
+
+static void* binarized_clone(const void* genome) {
+    return clone_binarized_network((const BinarizedNetwork*)genome);
+}
+
+static void binarized_mutate(void* genome, float mutation_rate, float mutation_chance) {
+    mutate_binarized_network((BinarizedNetwork*)genome, mutation_rate, mutation_chance);
+}
+
+static void binarized_free(void* genome) {
+    free_binarized_network((BinarizedNetwork*)genome);
+}
+
+static void binarized_score(void** population, int population_size, const void* dataset, int num_samples, double* fitness) {
+    binarized_population_fitness((BinarizedNetwork**)population, population_size, (const BitDataset*)dataset,
+                                 num_samples, fitness);
+}
+
+const GenomeOps binarized_genome_ops = {
+    binarized_create, binarized_crossover, binarized_clone, binarized_mutate, binarized_free, binarized_score,
+};
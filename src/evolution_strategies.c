@@ -0,0 +1,301 @@
+#include "evolution_strategies.h"
+#include "inference.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// --- Setup ---
+
+void default_es_config(EsConfig* config, EsKind kind) {
+    memset(config, 0, sizeof(*config));
+    config->kind = kind;
+    config->population = 50;
+    config->sigma = 0.05;
+    config->learning_rate = 0.002;
+    config->momentum = 0.9;
+    config->weight_decay = 0.005;
+    config->seed = 1;
+}
+
+// Separable CMA-ES constants (Ros and Hansen, 2008): the usual CMA rates,
+// with the covariance learning rates scaled up by (n + 2) / 3 because only
+// n variances are learned
+static int init_cma_constants(EvolutionStrategy* es) {
+    int lambda = es->config.population;
+    double n = (double)es->num_params;
+    es->parents = lambda / 2;
+    es->weights = (double*)malloc(es->parents * sizeof(double));
+    if (!es->weights) return 0;
+    double sum = 0.0, sum_squares = 0.0;
+    for (int i = 0; i < es->parents; i++) {
+        es->weights[i] = log(es->parents + 0.5) - log(i + 1.0);
+        sum += es->weights[i];
+    }
+    for (int i = 0; i < es->parents; i++) {
+        es->weights[i] /= sum;
+        sum_squares += es->weights[i] * es->weights[i];
+    }
+    es->mu_eff = 1.0 / sum_squares;
+    es->c_sigma = (es->mu_eff + 2.0) / (n + es->mu_eff + 5.0);
+    es->d_sigma = 1.0 + 2.0 * fmax(0.0, sqrt((es->mu_eff - 1.0) / (n + 1.0)) - 1.0) + es->c_sigma;
+    es->c_c = (4.0 + es->mu_eff / n) / (n + 4.0 + 2.0 * es->mu_eff / n);
+    es->c_1 = 2.0 / ((n + 1.3) * (n + 1.3) + es->mu_eff);
+    es->c_mu = fmin(1.0 - es->c_1, 2.0 * (es->mu_eff - 2.0 + 1.0 / es->mu_eff) / ((n + 2.0) * (n + 2.0) + es->mu_eff));
+    double separable = (n + 2.0) / 3.0;
+    es->c_1 = fmin(es->c_1 * separable, 0.5);
+    es->c_mu = fmin(es->c_mu * separable, 1.0 - es->c_1);
+    es->chi_n = sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+    return 1;
+}
+
+EvolutionStrategy* create_evolution_strategy(const NeuralNetwork* start, const EsConfig* config) {
+    if (config->population < 2 || config->sigma <= 0.0 ||
+        (config->kind == ES_OPENAI && (config->population % 2 != 0 || config->learning_rate <= 0.0))) {
+        fprintf(stderr, "Evolution strategies need a positive sigma and at least 2 candidates "
+                        "(an even number and a positive learning rate for OpenAI-ES).\n");
+        return NULL;
+    }
+    EvolutionStrategy* es = (EvolutionStrategy*)calloc(1, sizeof(EvolutionStrategy));
+    if (!es) return NULL;
+    es->config = *config;
+    es->num_params = network_num_params(start);
+    es->sigma = config->sigma;
+    rng_seed(&es->rng, config->seed);
+
+    size_t n = es->num_params;
+    es->mean = (double*)malloc(n * sizeof(double));
+    es->seeds = (uint64_t*)calloc(config->population, sizeof(uint64_t));
+    int ok = es->mean && es->seeds;
+    if (ok && config->kind == ES_OPENAI) {
+        es->velocity = (double*)calloc(n, sizeof(double));
+        ok = es->velocity != NULL;
+    } else if (ok) {
+        es->variances = (double*)malloc(n * sizeof(double));
+        es->path_sigma = (double*)calloc(n, sizeof(double));
+        es->path_c = (double*)calloc(n, sizeof(double));
+        ok = es->variances && es->path_sigma && es->path_c && init_cma_constants(es);
+        for (size_t p = 0; ok && p < n; p++) es->variances[p] = 1.0;
+    }
+    if (!ok) {
+        free_evolution_strategy(es);
+        return NULL;
+    }
+    flatten_network(start, es->mean);
+    return es;
+}
+
+void free_evolution_strategy(EvolutionStrategy* es) {
+    if (!es) return;
+    free(es->mean);
+    free(es->velocity);
+    free(es->variances);
+    free(es->path_sigma);
+    free(es->path_c);
+    free(es->seeds);
+    free(es->weights);
+    free(es);
+}
+
+// --- Sampling ---
+
+// The standard normal vector behind a seed
+static void draw_noise(uint64_t seed, double* noise, size_t n) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (size_t p = 0; p < n; p++) noise[p] = rng_gaussian(&rng);
+}
+
+void es_ask(EvolutionStrategy* es) {
+    for (int i = 0; i < es->config.population; i++) {
+        // Antithetic partners share their seed
+        es->seeds[i] = es->config.kind == ES_OPENAI && i % 2 == 1 ? es->seeds[i - 1] : rng_next(&es->rng);
+    }
+}
+
+void es_candidate(const EvolutionStrategy* es, int index, double* params) {
+    size_t n = es->num_params;
+    draw_noise(es->seeds[index], params, n);
+    if (es->config.kind == ES_OPENAI) {
+        double step = index % 2 == 0 ? es->sigma : -es->sigma;
+        for (size_t p = 0; p < n; p++) params[p] = es->mean[p] + step * params[p];
+    } else {
+        for (size_t p = 0; p < n; p++) params[p] = es->mean[p] + es->sigma * sqrt(es->variances[p]) * params[p];
+    }
+}
+
+typedef struct {
+    const EvolutionStrategy* es;
+    const NeuralNetwork* shape;
+    const Dataset* dataset;
+    int num_samples;
+    double* fitness;
+} EsFitnessJob;
+
+static void es_fitness_slice(int begin, int end, void* context) {
+    EsFitnessJob* job = (EsFitnessJob*)context;
+    NeuralNetwork* net = clone_network(job->shape);
+    double* params = (double*)malloc(job->es->num_params * sizeof(double));
+    int classes = job->shape->architecture[job->shape->num_layers - 1];
+    double* output = (double*)malloc(classes * sizeof(double));
+    for (int i = begin; i < end; i++) {
+        job->fitness[i] = 0.0;
+        if (!net || !params || !output) continue;
+        es_candidate(job->es, i, params);
+        unflatten_network(net, params);
+        PackedNetwork* packed = pack_network(net);
+        if (!packed) continue;
+        int correct_predictions = 0;
+        double confidence = 0.0;
+        for (int s = 0; s < job->num_samples; s++) {
+            packed_forward(packed, job->dataset->images->data[s], output);
+            int label = job->dataset->label_indices[s];
+            int best = 0;
+            for (int j = 1; j < classes; j++) {
+                if (output[j] > output[best]) best = j;
+            }
+            if (best == label) correct_predictions++;
+            confidence += output[label];
+        }
+        // The confidence term is worth less than one correct sample
+        job->fitness[i] = (correct_predictions + confidence / job->num_samples) / job->num_samples;
+        free_packed_network(packed);
+    }
+    free(output);
+    free(params);
+    free_neural_network(net);
+}
+
+void es_evaluate(const EvolutionStrategy* es, const NeuralNetwork* shape, const Dataset* dataset,
+                 int num_samples, double* fitness) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    EsFitnessJob job = {es, shape, dataset, num_samples, fitness};
+    parallel_for(es->config.population, 1, es_fitness_slice, &job);
+}
+
+// --- Update ---
+
+typedef struct {
+    double fitness;
+    int index;
+} RankedCandidate;
+
+// Sorts candidates by descending fitness
+static int compare_ranked(const void* a, const void* b) {
+    double x = ((const RankedCandidate*)a)->fitness, y = ((const RankedCandidate*)b)->fitness;
+    return (x < y) - (x > y);
+}
+
+// Candidate indices from best to worst
+static int* rank_candidates(const double* fitness, int count) {
+    RankedCandidate* ranked = (RankedCandidate*)malloc(count * sizeof(RankedCandidate));
+    int* order = (int*)malloc(count * sizeof(int));
+    if (!ranked || !order) {
+        free(ranked);
+        free(order);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        ranked[i].fitness = fitness[i];
+        ranked[i].index = i;
+    }
+    qsort(ranked, count, sizeof(RankedCandidate), compare_ranked);
+    for (int i = 0; i < count; i++) order[i] = ranked[i].index;
+    free(ranked);
+    return order;
+}
+
+// Centered ranks in [-0.5, 0.5], best highest. Tied candidates share the
+// average of their ranks, so plateaus of equal accuracy give no push.
+static void openai_step(EvolutionStrategy* es, const double* fitness, const int* order, double* noise,
+                        double* gradient) {
+    int lambda = es->config.population;
+    size_t n = es->num_params;
+    double* utility = (double*)malloc(lambda * sizeof(double));
+    if (!utility) return;
+    for (int start = 0; start < lambda;) {
+        int stop = start;
+        while (stop < lambda && fitness[order[stop]] == fitness[order[start]]) stop++;
+        double rank = (lambda - 1) - 0.5 * (start + stop - 1);
+        for (int i = start; i < stop; i++) utility[order[i]] = rank / (lambda - 1) - 0.5;
+        start = stop;
+    }
+
+    // The minus partner contributes -u e, so each pair adds (u+ - u-) e
+    memset(gradient, 0, n * sizeof(double));
+    for (int k = 0; k < lambda; k += 2) {
+        double weight = utility[k] - utility[k + 1];
+        if (weight == 0.0) continue;
+        draw_noise(es->seeds[k], noise, n);
+        for (size_t p = 0; p < n; p++) gradient[p] += weight * noise[p];
+    }
+    double scale = 1.0 / (lambda * es->sigma);
+    for (size_t p = 0; p < n; p++) {
+        double step = scale * gradient[p] - es->config.weight_decay * es->mean[p];
+        es->velocity[p] = es->config.momentum * es->velocity[p] + step;
+        es->mean[p] += es->config.learning_rate * es->velocity[p];
+    }
+    free(utility);
+}
+
+static void cma_step(EvolutionStrategy* es, const int* order, double* noise, double* work) {
+    size_t n = es->num_params;
+    double* weighted_z = work;
+    double* weighted_y = work + n;
+    double* weighted_y2 = work + 2 * n;
+    memset(work, 0, 3 * n * sizeof(double));
+    for (int i = 0; i < es->parents; i++) {
+        double w = es->weights[i];
+        draw_noise(es->seeds[order[i]], noise, n);
+        for (size_t p = 0; p < n; p++) {
+            double y = sqrt(es->variances[p]) * noise[p];
+            weighted_z[p] += w * noise[p];
+            weighted_y[p] += w * y;
+            weighted_y2[p] += w * y * y;
+        }
+    }
+
+    double sigma_rate = sqrt(es->c_sigma * (2.0 - es->c_sigma) * es->mu_eff);
+    double norm = 0.0;
+    for (size_t p = 0; p < n; p++) {
+        es->mean[p] += es->sigma * weighted_y[p];
+        es->path_sigma[p] = (1.0 - es->c_sigma) * es->path_sigma[p] + sigma_rate * weighted_z[p];
+        norm += es->path_sigma[p] * es->path_sigma[p];
+    }
+    norm = sqrt(norm);
+
+    // The covariance path stalls while the step-size path is still long
+    double decay = 1.0 - pow(1.0 - es->c_sigma, 2.0 * (es->generation + 1));
+    int h_sigma = norm / sqrt(decay) < (1.4 + 2.0 / (n + 1.0)) * es->chi_n;
+    double c_rate = h_sigma ? sqrt(es->c_c * (2.0 - es->c_c) * es->mu_eff) : 0.0;
+    double lost = h_sigma ? 0.0 : es->c_1 * es->c_c * (2.0 - es->c_c);
+    for (size_t p = 0; p < n; p++) {
+        es->path_c[p] = (1.0 - es->c_c) * es->path_c[p] + c_rate * weighted_y[p];
+        es->variances[p] = (1.0 - es->c_1 - es->c_mu + lost) * es->variances[p] +
+                           es->c_1 * es->path_c[p] * es->path_c[p] + es->c_mu * weighted_y2[p];
+    }
+    es->sigma *= exp(es->c_sigma / es->d_sigma * (norm / es->chi_n - 1.0));
+}
+
+void es_tell(EvolutionStrategy* es, const double* fitness) {
+    size_t n = es->num_params;
+    int* order = rank_candidates(fitness, es->config.population);
+    double* noise = (double*)malloc(n * sizeof(double));
+    double* work = (double*)malloc(3 * n * sizeof(double));
+    if (order && noise && work) {
+        if (es->config.kind == ES_OPENAI) {
+            openai_step(es, fitness, order, noise, work);
+        } else {
+            cma_step(es, order, noise, work);
+        }
+        es->generation++;
+    }
+    free(work);
+    free(noise);
+    free(order);
+}
+
+void es_mean_network(const EvolutionStrategy* es, NeuralNetwork* net) {
+    unflatten_network(net, es->mean);
+}
@@ -0,0 +1,409 @@
+#include "half_network.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HALF_X86 1
+#endif
+
+// --- Conversion ---
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float half_to_float(uint16_t value, HalfFormat format) {
+    if (format == HALF_BF16) return bits_float((uint32_t)value << 16);
+
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24
+        return bits_float(sign | float_bits(mantissa * (1.0f / 16777216.0f)));
+    }
+    if (exponent == 31) return bits_float(sign | 0x7F800000 | (mantissa << 13));
+    return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint16_t float_to_half(float value, HalfFormat format) {
+    uint32_t bits = float_bits(value);
+    if (format == HALF_BF16) {
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) return (uint16_t)((bits >> 16) | 0x40); // Quiet NaN
+        return (uint16_t)((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+    }
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude > 0x7F800000) return sign | 0x7E00;    // NaN
+    if (magnitude >= 0x477FF000) return sign | 0x7C00;   // Rounds to infinity (>= 65520)
+    if (magnitude < 0x38800000) {
+        // Below the smallest normal: scale to units of 2^-24 and round to even
+        return sign | (uint16_t)lrintf(bits_float(magnitude) * 16777216.0f);
+    }
+    // Rounding carries out of the mantissa into the exponent as needed
+    uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+    return sign | (uint16_t)((rounded >> 13) - (112 << 10));
+}
+
+// --- Kernels ---
+//
+// dot returns sum(x[i] * w[i]) with w converted to float32; average writes
+// the rounded mean of two rows. The SIMD versions convert eight values at a
+// time in registers and round exactly like float_to_half.
+
+typedef float (*HalfDot)(const float* x, const uint16_t* w, int n);
+typedef void (*HalfAverage)(const uint16_t* a, const uint16_t* b, uint16_t* out, size_t n);
+
+static float dot_fp16_scalar(const float* x, const uint16_t* w, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) sum += x[i] * half_to_float(w[i], HALF_FP16);
+    return sum;
+}
+
+static float dot_bf16_scalar(const float* x, const uint16_t* w, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) sum += x[i] * half_to_float(w[i], HALF_BF16);
+    return sum;
+}
+
+static void average_fp16_scalar(const uint16_t* a, const uint16_t* b, uint16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = float_to_half((half_to_float(a[i], HALF_FP16) + half_to_float(b[i], HALF_FP16)) * 0.5f, HALF_FP16);
+    }
+}
+
+static void average_bf16_scalar(const uint16_t* a, const uint16_t* b, uint16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = float_to_half((half_to_float(a[i], HALF_BF16) + half_to_float(b[i], HALF_BF16)) * 0.5f, HALF_BF16);
+    }
+}
+
+#ifdef HALF_X86
+__attribute__((target("avx2,fma")))
+static float horizontal_sum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma,f16c")))
+static float dot_fp16_f16c(const float* x, const uint16_t* w, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 weights = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(w + i)));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), weights, acc);
+    }
+    float sum = horizontal_sum(acc);
+    for (; i < n; i++) sum += x[i] * _cvtsh_ss(w[i]);
+    return sum;
+}
+
+__attribute__((target("avx2,fma,f16c")))
+static void average_fp16_f16c(const uint16_t* a, const uint16_t* b, uint16_t* out, size_t n) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 va = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256 vb = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(b + i)));
+        __m128i mean = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_add_ps(va, vb), half), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(out + i), mean);
+    }
+    average_fp16_scalar(a + i, b + i, out + i, n - i);
+}
+
+// bf16 widens to float32 by shifting into the high half of each lane
+__attribute__((target("avx2,fma")))
+static __m256 load_bf16(const uint16_t* p) {
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_bf16_avx2(const float* x, const uint16_t* w, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), load_bf16(w + i), acc);
+    }
+    float sum = horizontal_sum(acc);
+    for (; i < n; i++) sum += x[i] * half_to_float(w[i], HALF_BF16);
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static void average_bf16_avx2(const uint16_t* a, const uint16_t* b, uint16_t* out, size_t n) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 mean = _mm256_mul_ps(_mm256_add_ps(load_bf16(a + i), load_bf16(b + i)), half);
+        // Round to nearest even on the bits, then narrow the high halves
+        __m256i bits = _mm256_castps_si256(mean);
+        __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(bits, bias), odd), 16);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0xD8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(packed));
+    }
+    average_bf16_scalar(a + i, b + i, out + i, n - i);
+}
+#endif
+
+typedef struct {
+    HalfDot dot;
+    HalfAverage average;
+    const char* name;
+} HalfKernels;
+
+static HalfKernels fp16_kernels = {dot_fp16_scalar, average_fp16_scalar, "scalar"};
+static HalfKernels bf16_kernels = {dot_bf16_scalar, average_bf16_scalar, "scalar"};
+static pthread_once_t half_kernels_once = PTHREAD_ONCE_INIT;
+
+static void select_half_kernels(void) {
+    const char* requested = getenv("GENNET_HALF_KERNEL");
+    if (requested && strcmp(requested, "scalar") == 0) return;
+#ifdef HALF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        bf16_kernels = (HalfKernels){dot_bf16_avx2, average_bf16_avx2, "avx2"};
+        // F16C has no __builtin_cpu_supports name; every AVX2 CPU has it, but
+        // check CPUID leaf 1 ECX bit 29 to be sure
+        unsigned int eax, ebx, ecx, edx;
+        __asm__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+        if (ecx & (1u << 29)) {
+            fp16_kernels = (HalfKernels){dot_fp16_f16c, average_fp16_f16c, "f16c"};
+        }
+    }
+#endif
+}
+
+static const HalfKernels* kernels_for(HalfFormat format) {
+    pthread_once(&half_kernels_once, select_half_kernels);
+    return format == HALF_BF16 ? &bf16_kernels : &fp16_kernels;
+}
+
+const char* half_kernel_name(HalfFormat format) {
+    return kernels_for(format)->name;
+}
+
+// --- Half Network Functions ---
+
+// Allocates zeroed storage for an architecture
+static HalfNetwork* alloc_half_network(int num_layers, const int* architecture, HalfFormat format) {
+    HalfNetwork* net = (HalfNetwork*)calloc(1, sizeof(HalfNetwork));
+    if (!net) return NULL;
+    net->format = format;
+    net->num_layers = num_layers;
+    net->architecture = (int*)malloc(num_layers * sizeof(int));
+    net->weights = (uint16_t**)calloc(num_layers - 1, sizeof(uint16_t*));
+    net->biases = (uint16_t**)calloc(num_layers - 1, sizeof(uint16_t*));
+    if (!net->architecture || !net->weights || !net->biases) {
+        free_half_network(net);
+        return NULL;
+    }
+    memcpy(net->architecture, architecture, num_layers * sizeof(int));
+    for (int l = 0; l < num_layers - 1; l++) {
+        net->weights[l] = (uint16_t*)calloc((size_t)architecture[l] * architecture[l + 1], sizeof(uint16_t));
+        net->biases[l] = (uint16_t*)calloc(architecture[l + 1], sizeof(uint16_t));
+        if (!net->weights[l] || !net->biases[l]) {
+            free_half_network(net);
+            return NULL;
+        }
+    }
+    return net;
+}
+
+HalfNetwork* create_half_network(int num_layers, const int* architecture, HalfFormat format) {
+    HalfNetwork* net = alloc_half_network(num_layers, architecture, format);
+    if (!net) return NULL;
+    for (int l = 0; l < num_layers - 1; l++) {
+        double limit = sqrt(2.0 / architecture[l]);
+        size_t count = (size_t)architecture[l] * architecture[l + 1];
+        for (size_t i = 0; i < count; i++) {
+            net->weights[l][i] = float_to_half((float)(((double)rand() / RAND_MAX) * limit), format);
+        }
+    }
+    return net;
+}
+
+HalfNetwork* clone_half_network(const HalfNetwork* src) {
+    HalfNetwork* net = alloc_half_network(src->num_layers, src->architecture, src->format);
+    if (!net) return NULL;
+    for (int l = 0; l < src->num_layers - 1; l++) {
+        memcpy(net->weights[l], src->weights[l],
+               (size_t)src->architecture[l] * src->architecture[l + 1] * sizeof(uint16_t));
+        memcpy(net->biases[l], src->biases[l], src->architecture[l + 1] * sizeof(uint16_t));
+    }
+    return net;
+}
+
+void free_half_network(HalfNetwork* net) {
+    if (!net) return;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        if (net->weights) free(net->weights[l]);
+        if (net->biases) free(net->biases[l]);
+    }
+    free(net->weights);
+    free(net->biases);
+    free(net->architecture);
+    free(net);
+}
+
+HalfNetwork* half_network_from_network(const NeuralNetwork* src, HalfFormat format) {
+    HalfNetwork* net = alloc_half_network(src->num_layers, src->architecture, format);
+    if (!net) return NULL;
+    for (int l = 0; l < src->num_layers - 1; l++) {
+        int inputs = src->architecture[l];
+        for (int j = 0; j < src->architecture[l + 1]; j++) {
+            for (int k = 0; k < inputs; k++) {
+                net->weights[l][(size_t)j * inputs + k] = float_to_half((float)src->weights[l]->data[k][j], format);
+            }
+            net->biases[l][j] = float_to_half((float)src->biases[l]->data[0][j], format);
+        }
+    }
+    return net;
+}
+
+NeuralNetwork* half_network_to_network(const HalfNetwork* src) {
+    NeuralNetwork* net = create_zeroed_network(src->num_layers, src->architecture);
+    if (!net) return NULL;
+    for (int l = 0; l < src->num_layers - 1; l++) {
+        int inputs = src->architecture[l];
+        for (int j = 0; j < src->architecture[l + 1]; j++) {
+            for (int k = 0; k < inputs; k++) {
+                net->weights[l]->data[k][j] = half_to_float(src->weights[l][(size_t)j * inputs + k], src->format);
+            }
+            net->biases[l]->data[0][j] = half_to_float(src->biases[l][j], src->format);
+        }
+    }
+    return net;
+}
+
+size_t half_network_size(const HalfNetwork* net) {
+    size_t count = 0;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        count += ((size_t)net->architecture[l] + 1) * net->architecture[l + 1];
+    }
+    return count * sizeof(uint16_t);
+}
+
+int half_network_scratch_size(const HalfNetwork* net) {
+    int widest = 0;
+    for (int l = 0; l < net->num_layers; l++) {
+        if (net->architecture[l] > widest) widest = net->architecture[l];
+    }
+    return 2 * widest;
+}
+
+int half_predict(const HalfNetwork* net, const double* input, float* scratch) {
+    const HalfKernels* kernels = kernels_for(net->format);
+    float* current = scratch;
+    float* next = scratch + half_network_scratch_size(net) / 2;
+    for (int k = 0; k < net->architecture[0]; k++) current[k] = (float)input[k];
+
+    // The final sigmoid is skipped; it cannot change the argmax
+    int last = net->num_layers - 2;
+    for (int l = 0; l <= last; l++) {
+        int inputs = net->architecture[l];
+        for (int j = 0; j < net->architecture[l + 1]; j++) {
+            float sum = kernels->dot(current, net->weights[l] + (size_t)j * inputs, inputs) +
+                        half_to_float(net->biases[l][j], net->format);
+            next[j] = l < last ? 1.0f / (1.0f + expf(-sum)) : sum;
+        }
+        float* swap = current;
+        current = next;
+        next = swap;
+    }
+
+    int best = 0;
+    for (int j = 1; j < net->architecture[net->num_layers - 1]; j++) {
+        if (current[j] > current[best]) best = j;
+    }
+    return best;
+}
+
+typedef struct {
+    HalfNetwork** population;
+    const Dataset* dataset;
+    int num_samples;
+    double* fitness;
+} HalfFitnessJob;
+
+// Scores a slice of the population with its own scratch buffer
+static void half_fitness_slice(int begin, int end, void* context) {
+    HalfFitnessJob* job = (HalfFitnessJob*)context;
+    float* scratch = (float*)malloc(half_network_scratch_size(job->population[begin]) * sizeof(float));
+    for (int n = begin; n < end; n++) {
+        const HalfNetwork* net = job->population[n];
+        int correct = 0;
+        for (int i = 0; scratch && i < job->num_samples; i++) {
+            if (half_predict(net, job->dataset->images->data[i], scratch) == job->dataset->label_indices[i]) {
+                correct++;
+            }
+        }
+        job->fitness[n] = (double)correct / job->num_samples;
+    }
+    free(scratch);
+}
+
+void half_population_fitness(HalfNetwork** population, int population_size, const Dataset* dataset,
+                             int num_samples, double* fitness) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    HalfFitnessJob job = {population, dataset, num_samples, fitness};
+    parallel_for(population_size, 1, half_fitness_slice, &job);
+}
+
+// --- Genome Operators ---
+
+HalfNetwork* crossover_half(const HalfNetwork* parent1, const HalfNetwork* parent2) {
+    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers || parent1->format != parent2->format) {
+        return NULL;
+    }
+    HalfNetwork* child = alloc_half_network(parent1->num_layers, parent1->architecture, parent1->format);
+    if (!child) return NULL;
+
+    const HalfKernels* kernels = kernels_for(parent1->format);
+    for (int l = 0; l < parent1->num_layers - 1; l++) {
+        size_t count = (size_t)parent1->architecture[l] * parent1->architecture[l + 1];
+        kernels->average(parent1->weights[l], parent2->weights[l], child->weights[l], count);
+        kernels->average(parent1->biases[l], parent2->biases[l], child->biases[l], parent1->architecture[l + 1]);
+    }
+    return child;
+}
+
+void mutate_half_network(HalfNetwork* net, float mutation_rate, float mutation_chance) {
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        size_t count = (size_t)net->architecture[l] * net->architecture[l + 1];
+        for (size_t i = 0; i < count; i++) {
+            if (((double)rand() / RAND_MAX) < mutation_chance) {
+                float value = half_to_float(net->weights[l][i], net->format);
+                value += (float)(((double)rand() / RAND_MAX - 0.5) * mutation_rate);
+                net->weights[l][i] = float_to_half(value, net->format);
+            }
+        }
+    }
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        for (int j = 0; j < net->architecture[l + 1]; j++) {
+            if (((double)rand() / RAND_MAX) < mutation_chance) {
+                float value = half_to_float(net->biases[l][j], net->format);
+                value += (float)(((double)rand() / RAND_MAX - 0.5) * mutation_rate);
+                net->biases[l][j] = float_to_half(value, net->format);
+            }
+        }
+    }
+}
@@ -0,0 +1,214 @@
+#include "inference.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define PANEL_ALIGNMENT 64
+
+static double* alloc_aligned(size_t count) {
+    void* memory = NULL;
+    size_t size = (count * sizeof(double) + PANEL_ALIGNMENT - 1) / PANEL_ALIGNMENT * PANEL_ALIGNMENT;
+    if (posix_memalign(&memory, PANEL_ALIGNMENT, size ? size : PANEL_ALIGNMENT) != 0) return NULL;
+    memset(memory, 0, size);
+    return (double*)memory;
+}
+
+static int padded_width(int outputs) {
+    return (outputs + PACKED_PANEL_WIDTH - 1) / PACKED_PANEL_WIDTH * PACKED_PANEL_WIDTH;
+}
+
+// --- Packing ---
+
+PackedNetwork* pack_network(const NeuralNetwork* net) {
+    PackedNetwork* packed = (PackedNetwork*)calloc(1, sizeof(PackedNetwork));
+    if (!packed) return NULL;
+    int num_weight_layers = net->num_layers - 1;
+    packed->num_layers = net->num_layers;
+    packed->architecture = (int*)malloc(net->num_layers * sizeof(int));
+    packed->panels = (double**)calloc(num_weight_layers, sizeof(double*));
+    packed->biases = (double**)calloc(num_weight_layers, sizeof(double*));
+    if (!packed->architecture || !packed->panels || !packed->biases) {
+        free_packed_network(packed);
+        return NULL;
+    }
+    memcpy(packed->architecture, net->architecture, net->num_layers * sizeof(int));
+
+    int widest = 0;
+    for (int l = 0; l < num_weight_layers; l++) {
+        int inputs = net->architecture[l];
+        int outputs = net->architecture[l + 1];
+        int width = padded_width(outputs);
+        if (width > widest) widest = width;
+
+        // Padding outputs get zero weights and are never read back
+        packed->panels[l] = alloc_aligned((size_t)inputs * width);
+        packed->biases[l] = alloc_aligned(width);
+        if (!packed->panels[l] || !packed->biases[l]) {
+            free_packed_network(packed);
+            return NULL;
+        }
+        for (int j = 0; j < outputs; j++) {
+            double* panel = packed->panels[l] + (size_t)(j / PACKED_PANEL_WIDTH) * inputs * PACKED_PANEL_WIDTH;
+            for (int k = 0; k < inputs; k++) {
+                panel[(size_t)k * PACKED_PANEL_WIDTH + j % PACKED_PANEL_WIDTH] = net->weights[l]->data[k][j];
+            }
+            packed->biases[l][j] = net->biases[l]->data[0][j];
+        }
+    }
+
+    packed->scratch[0] = alloc_aligned(widest);
+    packed->scratch[1] = alloc_aligned(widest);
+    if (!packed->scratch[0] || !packed->scratch[1]) {
+        free_packed_network(packed);
+        return NULL;
+    }
+    return packed;
+}
+
+void free_packed_network(PackedNetwork* packed) {
+    if (!packed) return;
+    for (int l = 0; l < packed->num_layers - 1; l++) {
+        if (packed->panels) free(packed->panels[l]);
+        if (packed->biases) free(packed->biases[l]);
+    }
+    free(packed->panels);
+    free(packed->biases);
+    free(packed->scratch[0]);
+    free(packed->scratch[1]);
+    free(packed->architecture);
+    free(packed);
+}
+
+// --- Kernels ---
+
+// Adds x times one panel row to the accumulators. The SSE2 path keeps the
+// whole panel in four registers; multiplies and adds stay separate so the
+// rounding matches the scalar loop.
+#ifdef __SSE2__
+_Static_assert(PACKED_PANEL_WIDTH == 8, "PANEL_STEP covers exactly eight outputs");
+
+#define PANEL_STEP(acc, x, w)                                                            \
+    do {                                                                                 \
+        const __m128d xv = _mm_set1_pd(x);                                               \
+        acc##0 = _mm_add_pd(acc##0, _mm_mul_pd(xv, _mm_load_pd((w))));                   \
+        acc##1 = _mm_add_pd(acc##1, _mm_mul_pd(xv, _mm_load_pd((w) + 2)));               \
+        acc##2 = _mm_add_pd(acc##2, _mm_mul_pd(xv, _mm_load_pd((w) + 4)));               \
+        acc##3 = _mm_add_pd(acc##3, _mm_mul_pd(xv, _mm_load_pd((w) + 6)));               \
+    } while (0)
+#endif
+
+// Computes one layer into `out`, which must hold a whole number of panels.
+// Every accumulator sums its terms in input order, exactly like
+// dot_product, and stays in a register for the whole panel. Without
+// `activate` the biased logits are written instead of their sigmoid.
+static void packed_layer(const double* panels, const double* bias, const double* in,
+                         int inputs, int outputs, int prefetch_distance, int activate, double* out) {
+    int num_panels = (outputs + PACKED_PANEL_WIDTH - 1) / PACKED_PANEL_WIDTH;
+    for (int p = 0; p < num_panels; p++) {
+        const double* panel = panels + (size_t)p * inputs * PACKED_PANEL_WIDTH;
+        double acc[PACKED_PANEL_WIDTH];
+#ifdef __SSE2__
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+        if (prefetch_distance > 0) {
+            for (int k = 0; k < inputs; k++) {
+                __builtin_prefetch(panel + (size_t)(k + prefetch_distance) * PACKED_PANEL_WIDTH);
+                PANEL_STEP(acc, in[k], panel + (size_t)k * PACKED_PANEL_WIDTH);
+            }
+        } else {
+            for (int k = 0; k < inputs; k++) {
+                PANEL_STEP(acc, in[k], panel + (size_t)k * PACKED_PANEL_WIDTH);
+            }
+        }
+        _mm_storeu_pd(acc, acc0);
+        _mm_storeu_pd(acc + 2, acc1);
+        _mm_storeu_pd(acc + 4, acc2);
+        _mm_storeu_pd(acc + 6, acc3);
+#else
+        for (int j = 0; j < PACKED_PANEL_WIDTH; j++) acc[j] = 0.0;
+        for (int k = 0; k < inputs; k++) {
+            if (prefetch_distance > 0) {
+                __builtin_prefetch(panel + (size_t)(k + prefetch_distance) * PACKED_PANEL_WIDTH);
+            }
+            const double x = in[k];
+            const double* w = panel + (size_t)k * PACKED_PANEL_WIDTH;
+            for (int j = 0; j < PACKED_PANEL_WIDTH; j++) acc[j] += x * w[j];
+        }
+#endif
+        double* dst = out + p * PACKED_PANEL_WIDTH;
+        const double* b = bias + p * PACKED_PANEL_WIDTH;
+        if (activate) {
+            for (int j = 0; j < PACKED_PANEL_WIDTH; j++) dst[j] = 1.0 / (1.0 + exp(-(acc[j] + b[j])));
+        } else {
+            for (int j = 0; j < PACKED_PANEL_WIDTH; j++) dst[j] = acc[j] + b[j];
+        }
+    }
+}
+
+// Runs every layer through the scratch buffers and returns the final
+// activations, or the final logits when `activate_last` is 0. The result
+// stays valid until the next call.
+static const double* run_layers(PackedNetwork* packed, const double* input, int activate_last) {
+    const double* current = input;
+    int last = packed->num_layers - 2;
+    for (int l = 0; l <= last; l++) {
+        double* next = packed->scratch[l & 1];
+        packed_layer(packed->panels[l], packed->biases[l], current, packed->architecture[l],
+                     packed->architecture[l + 1], packed->prefetch_distance, l < last || activate_last, next);
+        current = next;
+    }
+    return current;
+}
+
+void packed_forward(PackedNetwork* packed, const double* input, double* output) {
+    const double* result = run_layers(packed, input, 1);
+    memcpy(output, result, packed->architecture[packed->num_layers - 1] * sizeof(double));
+}
+
+// --- Prediction ---
+
+int predict_class(PackedNetwork* packed, const double* input) {
+    const double* logits = run_layers(packed, input, 0);
+    int best = 0;
+    for (int j = 1; j < packed->architecture[packed->num_layers - 1]; j++) {
+        if (logits[j] > logits[best]) best = j;
+    }
+    return best;
+}
+
+int predict_top_k(PackedNetwork* packed, const double* input, int k, int* classes, double* scores) {
+    const double* logits = run_layers(packed, input, 0);
+    int outputs = packed->architecture[packed->num_layers - 1];
+    if (k > outputs) k = outputs;
+
+    // Insertion into a sorted list of k; output layers are small. Ties keep
+    // the lower class first, like the argmax.
+    for (int j = 0; j < outputs; j++) {
+        int count = j < k ? j : k;
+        int pos = count;
+        while (pos > 0 && logits[j] > logits[classes[pos - 1]]) pos--;
+        if (pos >= k) continue;
+        for (int m = (count < k ? count : k - 1); m > pos; m--) classes[m] = classes[m - 1];
+        classes[pos] = j;
+    }
+    if (scores) {
+        for (int i = 0; i < k; i++) scores[i] = 1.0 / (1.0 + exp(-logits[classes[i]]));
+    }
+    return k;
+}
+
+double network_accuracy(const NeuralNetwork* net, const Dataset* dataset, int num_samples) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    if (num_samples <= 0) return 0.0;
+    PackedNetwork* packed = pack_network(net);
+    if (!packed) return 0.0;
+    int correct = 0;
+    for (int i = 0; i < num_samples; i++) {
+        if (predict_class(packed, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+    }
+    free_packed_network(packed);
+    return (double)correct / num_samples;
+}
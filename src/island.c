@@ -0,0 +1,263 @@
+#include "island.h"
+#include "inference.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+void default_island_config(IslandConfig* config) {
+    config->num_islands = 4;
+    config->population = 50;
+    config->generations = 100;
+    config->migration_interval = 5;
+    config->migrants = 2;
+    config->topology = MIGRATION_RING;
+    config->mutation_rate = 0.05f;
+    config->mutation_chance = 0.1f;
+    config->num_samples = 1000;
+    config->seed = 1;
+    config->report_every = 0;
+}
+
+// --- Migration Queues ---
+
+int init_migration_queue(MigrationQueue* queue, size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    queue->slots = (NetworkFitness*)malloc(rounded * sizeof(NetworkFitness));
+    queue->capacity = rounded;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return queue->slots != NULL;
+}
+
+void destroy_migration_queue(MigrationQueue* queue) {
+    NetworkFitness migrant;
+    while (queue->slots && migration_queue_pop(queue, &migrant)) {
+        free_neural_network(migrant.network);
+    }
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+int migration_queue_push(MigrationQueue* queue, NetworkFitness migrant) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == queue->capacity) return 0;
+    queue->slots[tail & (queue->capacity - 1)] = migrant;
+    // Publishes the slot before the receiver can see the new tail
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+int migration_queue_pop(MigrationQueue* queue, NetworkFitness* migrant) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail) return 0;
+    *migrant = queue->slots[head & (queue->capacity - 1)];
+    // Hands the slot back to the sender only after it has been read
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return 1;
+}
+
+// --- Island Evolution ---
+
+typedef struct {
+    int index;
+    const IslandConfig* config;
+    const Dataset* dataset;
+    NetworkFitness* scored;     // The island's population and its fitness
+    MigrationQueue** inbox;
+    int num_inbox;
+    MigrationQueue** outbox;
+    int num_outbox;
+    Rng rng;
+    NeuralNetwork* best;
+    IslandStats stats;
+} Island;
+
+// Each immigrant displaces the island's worst network if it is better
+static void absorb_immigrants(Island* island) {
+    int population = island->config->population;
+    NetworkFitness migrant;
+    for (int q = 0; q < island->num_inbox; q++) {
+        while (migration_queue_pop(island->inbox[q], &migrant)) {
+            int worst = 0;
+            for (int i = 1; i < population; i++) {
+                if (island->scored[i].fitness < island->scored[worst].fitness) worst = i;
+            }
+            if (migrant.fitness > island->scored[worst].fitness) {
+                free_neural_network(island->scored[worst].network);
+                island->scored[worst] = migrant;
+                island->stats.migrants_received++;
+            } else {
+                free_neural_network(migrant.network);
+                island->stats.migrants_dropped++;
+            }
+        }
+    }
+}
+
+// Sends copies of the fittest networks (sorted best first) to every neighbour
+static void send_emigrants(Island* island, const NetworkFitness* fittest, int num_fittest) {
+    int migrants = island->config->migrants < num_fittest ? island->config->migrants : num_fittest;
+    for (int q = 0; q < island->num_outbox; q++) {
+        for (int m = 0; m < migrants; m++) {
+            NetworkFitness copy = {clone_network(fittest[m].network), fittest[m].fitness};
+            if (copy.network && migration_queue_push(island->outbox[q], copy)) {
+                island->stats.migrants_sent++;
+            } else {
+                free_neural_network(copy.network);
+                island->stats.migrants_dropped++;
+            }
+        }
+    }
+}
+
+static void* island_main(void* arg) {
+    Island* island = (Island*)arg;
+    const IslandConfig* config = island->config;
+    int population = config->population;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int gen = 0; gen < config->generations; gen++) {
+        double best_in_gen = 0.0;
+        for (int i = 0; i < population; i++) {
+            NetworkFitness* entry = &island->scored[i];
+            entry->fitness = network_accuracy(entry->network, island->dataset, config->num_samples);
+            if (entry->fitness > best_in_gen) best_in_gen = entry->fitness;
+            if (!island->best || entry->fitness > island->stats.best_fitness) {
+                NeuralNetwork* copy = clone_network(entry->network);
+                if (copy) {
+                    free_neural_network(island->best);
+                    island->best = copy;
+                    island->stats.best_fitness = entry->fitness;
+                }
+            }
+        }
+        island->stats.evaluations += population;
+        if (config->report_every > 0 && (gen + 1) % config->report_every == 0) {
+            printf("Island %d | Generation %d/%d | Best Accuracy: %.2f%%\n", island->index, gen + 1,
+                   config->generations, best_in_gen * 100.0);
+        }
+        if (gen == config->generations - 1) break;
+
+        absorb_immigrants(island);
+        int num_fittest;
+        NetworkFitness* fittest = select_fittest(island->scored, population, &num_fittest);
+        if (!fittest) break;
+        if ((gen + 1) % config->migration_interval == 0) {
+            send_emigrants(island, fittest, num_fittest);
+        }
+        NeuralNetwork** children = reproduce_rng(fittest, num_fittest, population, config->mutation_rate,
+                                                 config->mutation_chance, &island->rng);
+        free(fittest);
+        if (!children) break;
+        for (int i = 0; i < population; i++) {
+            free_neural_network(island->scored[i].network);
+            island->scored[i].network = children[i];
+        }
+        free(children);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    island->stats.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return NULL;
+}
+
+NeuralNetwork* run_islands(const IslandConfig* config, int num_layers, const int* architecture,
+                           const Dataset* dataset, IslandStats* stats, double* best_fitness) {
+    int count = config->num_islands;
+    if (count < 1 || config->population < 2 || config->generations < 1 || config->migration_interval < 1 ||
+        config->migrants < 0 || config->num_samples < 1 || config->num_samples > dataset->num_items) {
+        return NULL;
+    }
+
+    // One queue per directed edge. A queue holds two emigrations, so a
+    // receiver that falls behind loses migrants instead of stalling the sender.
+    int num_queues = count < 2 ? 0 : config->topology == MIGRATION_RING ? count : count * (count - 1);
+    Island* islands = (Island*)calloc(count, sizeof(Island));
+    MigrationQueue* queues = (MigrationQueue*)calloc(num_queues > 0 ? num_queues : 1, sizeof(MigrationQueue));
+    MigrationQueue** links = (MigrationQueue**)calloc(2 * (size_t)(num_queues > 0 ? num_queues : 1),
+                                                      sizeof(MigrationQueue*));
+    pthread_t* threads = (pthread_t*)calloc(count, sizeof(pthread_t));
+    int* started = (int*)calloc(count, sizeof(int));
+    int ok = islands && queues && links && threads && started;
+    for (int q = 0; ok && q < num_queues; q++) {
+        ok = init_migration_queue(&queues[q], 2 * (size_t)(config->migrants > 0 ? config->migrants : 1));
+    }
+
+    // Wire the topology: outboxes fill the first half of links, inboxes the second
+    MigrationQueue** outboxes = links;
+    MigrationQueue** inboxes = links + num_queues;
+    int next_link = 0;
+    for (int i = 0; ok && i < count; i++) {
+        Island* island = &islands[i];
+        island->index = i;
+        island->config = config;
+        island->dataset = dataset;
+        rng_seed_stream(&island->rng, config->seed, (uint64_t)i);
+        island->outbox = outboxes + next_link;
+        island->inbox = inboxes + next_link;
+        if (config->topology == MIGRATION_RING && num_queues > 0) {
+            island->outbox[0] = &queues[i];
+            island->inbox[0] = &queues[(i + count - 1) % count];
+            island->num_outbox = island->num_inbox = 1;
+        } else if (num_queues > 0) {
+            // Queue from -> to lives at from * (count - 1) + (to < from ? to : to - 1)
+            for (int j = 0; j < count; j++) {
+                if (j == i) continue;
+                island->outbox[island->num_outbox++] = &queues[i * (count - 1) + (j < i ? j : j - 1)];
+                island->inbox[island->num_inbox++] = &queues[j * (count - 1) + (i < j ? i : i - 1)];
+            }
+        }
+        next_link += island->num_outbox;
+
+        // Initial networks come from the island's own stream too, so the
+        // run never touches rand()
+        island->scored = (NetworkFitness*)calloc(config->population, sizeof(NetworkFitness));
+        NeuralNetwork** population =
+            island->scored ? create_initial_population_rng(config->population, num_layers, architecture, &island->rng)
+                           : NULL;
+        ok = population != NULL;
+        for (int n = 0; ok && n < config->population; n++) island->scored[n].network = population[n];
+        free(population);
+    }
+
+    if (ok) {
+        for (int i = 0; i < count; i++) {
+            started[i] = pthread_create(&threads[i], NULL, island_main, &islands[i]) == 0;
+            if (!started[i]) island_main(&islands[i]);
+        }
+        for (int i = 0; i < count; i++) {
+            if (started[i]) pthread_join(threads[i], NULL);
+        }
+    }
+
+    NeuralNetwork* best = NULL;
+    double best_score = 0.0;
+    for (int i = 0; islands && i < count; i++) {
+        Island* island = &islands[i];
+        if (ok && island->best && (!best || island->stats.best_fitness > best_score)) {
+            free_neural_network(best);
+            best = island->best;
+            best_score = island->stats.best_fitness;
+        } else {
+            free_neural_network(island->best);
+        }
+        if (stats) stats[i] = island->stats;
+        for (int n = 0; island->scored && n < config->population; n++) {
+            free_neural_network(island->scored[n].network);
+        }
+        free(island->scored);
+    }
+    for (int q = 0; queues && q < num_queues; q++) destroy_migration_queue(&queues[q]);
+    if (best_fitness) *best_fitness = best_score;
+    free(islands);
+    free(queues);
+    free(links);
+    free(threads);
+    free(started);
+    return best;
+}
@@ -4,163 +4,1395 @@
 #include <string.h>
 #include <time.h>
 
+#include "backprop.h"
+#include "checkpoint.h"
 #include "data_loader.h"
+#include "dataset_stream.h"
+#include "distributed.h"
 #include "evolution.h"
+#include "evolution_strategies.h"
+#include "inference.h"
+#include "island.h"
 #include "neural_network.h"
+#include "projection.h"
+#include "ridge.h"
+#include "steady_state.h"
 
-// --- Helper: Find index of max value ---
-int get_predicted_class(const Matrix *output) {
-  int max_index = 0;
-  for (int i = 1; i < output->cols; i++) {
-    if (output->data[0][i] > output->data[0][max_index]) {
-      max_index = i;
+// --- Population Scoring ---
+// Scores every network against the in-memory dataset, on the workers of a
+// distributed master, or, when a stream is given, in one pass over the
+// streamed batches.
+void evaluate_population(NetworkFitness *population_with_fitness,
+                         int population_size, const Dataset *dataset,
+                         DatasetStream *stream, DistributedMaster *master,
+                         int num_samples) {
+  if (master &&
+      distributed_evaluate(master, population_with_fitness, population_size)) {
+    return;
+  }
+  if (stream) {
+    stream_population_fitness(population_with_fitness, population_size, stream,
+                              num_samples);
+    return;
+  }
+  for (int i = 0; i < population_size; i++) {
+    population_with_fitness[i].fitness = network_accuracy(
+        population_with_fitness[i].network, dataset, num_samples);
+  }
+}
+
+// --- Saving ---
+// The recognizer applies the projection stored next to a model, so every
+// mode writes the one it trained with, or removes a stale one left behind
+// by an earlier run.
+void save_model_projection(const Projection *projection,
+                           const char *projection_file) {
+  if (!projection) {
+    remove(projection_file);
+  } else if (save_projection(projection, projection_file)) {
+    printf("Input projection saved to %s\n", projection_file);
+  } else {
+    fprintf(stderr, "Failed to save the input projection.\n");
+  }
+}
+
+// --- Genome Evolution ---
+// Runs the generational loop on any genome type and scores the final
+// generation. Takes ownership of population and returns the last generation,
+// with the best genome's index in *best, or NULL if a generation could not
+// be allocated.
+void **evolve_genomes(const GenomeOps *ops, void **population,
+                      const void *dataset, int population_size,
+                      int num_generations, int num_samples,
+                      float mutation_rate, float mutation_chance, int *best) {
+  printf("Using %d samples for fitness evaluation.\n", num_samples);
+  printf("--------------------\n");
+
+  GenomeFitness *scored =
+      (GenomeFitness *)malloc(population_size * sizeof(GenomeFitness));
+  double *fitness = (double *)malloc(population_size * sizeof(double));
+  if (!scored || !fitness) {
+    free(scored);
+    free(fitness);
+    free_genome_population(ops, population, population_size);
+    return NULL;
+  }
+  for (int gen = 0; population && gen < num_generations; gen++) {
+    double best_accuracy_in_gen = 0.0;
+    ops->score(population, population_size, dataset, num_samples, fitness);
+    for (int i = 0; i < population_size; i++) {
+      scored[i].genome = population[i];
+      scored[i].fitness = fitness[i];
+      if (fitness[i] > best_accuracy_in_gen) {
+        best_accuracy_in_gen = fitness[i];
+      }
+    }
+    printf("Generation %d/%d | Best Accuracy: %.2f%%\n", gen + 1,
+           num_generations, best_accuracy_in_gen * 100.0);
+
+    int num_fittest;
+    GenomeFitness *fittest =
+        select_fittest_genomes(scored, population_size, &num_fittest);
+    void **new_population =
+        reproduce_genomes(ops, fittest, num_fittest, population_size,
+                          mutation_rate, mutation_chance);
+    free_genome_population(ops, population, population_size);
+    free(fittest);
+    population = new_population;
+  }
+  if (!population) {
+    fprintf(stderr, "Failed to allocate the next generation.\n");
+    free(scored);
+    free(fitness);
+    return NULL;
+  }
+
+  printf("--------------------\n");
+  ops->score(population, population_size, dataset, num_samples, fitness);
+  *best = 0;
+  for (int i = 1; i < population_size; i++) {
+    if (fitness[i] > fitness[*best]) {
+      *best = i;
     }
   }
-  return max_index;
+  printf("Evolution finished.\n");
+  printf("Best accuracy achieved after %d generations: %.2f%%\n",
+         num_generations, fitness[*best] * 100.0);
+
+  free(scored);
+  free(fitness);
+  return population;
 }
 
-// --- Fitness Function (Accuracy) ---
-// Note: Evaluating on the full dataset is slow. We use a subset.
-double calculate_fitness(NeuralNetwork *network, const Dataset *dataset,
-                         int num_samples) {
-  int correct_predictions = 0;
+// --- Integer Genome Evolution ---
+// Runs the generational loop on int8 genomes and saves the best one as a
+// quantized model, together with the input projection if one was used.
+int evolve_int8_genomes(const Dataset *dataset, int num_layers,
+                        const int *architecture, int population_size,
+                        int num_generations, int num_samples,
+                        float mutation_rate, float mutation_chance,
+                        const Projection *projection, const char *model_file,
+                        const char *projection_file) {
+  srand(time(NULL));
+  void **population = create_initial_genome_population(
+      &quantized_genome_ops, population_size, num_layers, architecture);
+  if (!population) {
+    return 1;
+  }
+  printf("Created initial population of %d int8 genomes (%s kernel).\n",
+         population_size, quantized_kernel_name());
+
+  int best;
+  population = evolve_genomes(&quantized_genome_ops, population, dataset,
+                              population_size, num_generations, num_samples,
+                              mutation_rate, mutation_chance, &best);
+  if (!population) {
+    return 1;
+  }
+
+  int status = 0;
+  QuantizedNetwork *best_net = (QuantizedNetwork *)population[best];
+  if (save_quantized_network(best_net, model_file)) {
+    printf("Best int8 network saved to %s (%zu bytes of parameters)\n",
+           model_file, quantized_network_size(best_net));
+  } else {
+    fprintf(stderr, "Failed to save the best network.\n");
+    status = 1;
+  }
+  save_model_projection(projection, projection_file);
+
+  free_genome_population(&quantized_genome_ops, population, population_size);
+  return status;
+}
+
+// --- Half-Precision Genome Evolution ---
+// Runs the generational loop on fp16/bf16 genomes. The best genome is
+// widened back to a double network and saved in the usual format, so the
+// recognizer and nettool read it like any other model.
+int evolve_half_genomes(const Dataset *dataset, int num_layers,
+                        const int *architecture, HalfFormat format,
+                        int population_size, int num_generations,
+                        int num_samples, float mutation_rate,
+                        float mutation_chance, const Projection *projection,
+                        const char *model_file, const char *projection_file) {
+  srand(time(NULL));
+  const GenomeOps *ops =
+      format == HALF_BF16 ? &bf16_genome_ops : &fp16_genome_ops;
+  void **population = create_initial_genome_population(
+      ops, population_size, num_layers, architecture);
+  if (!population) {
+    return 1;
+  }
+  const char *format_name = format == HALF_BF16 ? "bf16" : "fp16";
+  printf("Created initial population of %d %s genomes (%s kernel, %.1f MB).\n",
+         population_size, format_name, half_kernel_name(format),
+         population_size *
+             (double)half_network_size((const HalfNetwork *)population[0]) /
+             (1024.0 * 1024.0));
+
+  int best;
+  population =
+      evolve_genomes(ops, population, dataset, population_size,
+                     num_generations, num_samples, mutation_rate,
+                     mutation_chance, &best);
+  if (!population) {
+    return 1;
+  }
+
+  int status = 0;
+  NeuralNetwork *best_net =
+      half_network_to_network((const HalfNetwork *)population[best]);
+  if (best_net && save_network(best_net, model_file)) {
+    printf("Best %s network saved to %s\n", format_name, model_file);
+  } else {
+    fprintf(stderr, "Failed to save the best network.\n");
+    status = 1;
+  }
+  free_neural_network(best_net);
+  save_model_projection(projection, projection_file);
+
+  free_genome_population(ops, population, population_size);
+  return status;
+}
+
+// --- Binarized Genome Evolution ---
+// Runs the generational loop on one-bit genomes over bit-packed inputs and
+// saves the best one as a binarized model.
+int evolve_binarized_genomes(const BitDataset *dataset, int num_layers,
+                             const int *architecture, int population_size,
+                             int num_generations, int num_samples,
+                             float mutation_rate, float flip_chance,
+                             const char *model_file) {
+  srand(time(NULL));
+  void **population = create_initial_genome_population(
+      &binarized_genome_ops, population_size, num_layers, architecture);
+  if (!population) {
+    return 1;
+  }
+  printf("Created initial population of %d binarized genomes (%s kernel, "
+         "%zu bytes each).\n",
+         population_size, binarized_kernel_name(),
+         binarized_network_size((const BinarizedNetwork *)population[0]));
+
+  int best;
+  population = evolve_genomes(&binarized_genome_ops, population, dataset,
+                              population_size, num_generations, num_samples,
+                              mutation_rate, flip_chance, &best);
+  if (!population) {
+    return 1;
+  }
+
+  int status = 0;
+  if (save_binarized_network((const BinarizedNetwork *)population[best],
+                             model_file)) {
+    printf("Best binarized network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the best network.\n");
+    status = 1;
+  }
+
+  free_genome_population(&binarized_genome_ops, population, population_size);
+  return status;
+}
+
+// --- Gradient Training ---
+// Trains a single network with mini-batch backpropagation instead of
+// evolving a population. Accuracy is measured on the same first records the
+// genetic algorithm scores, so the two modes can be compared epoch for
+// generation against the wall clock.
+int train_with_backprop(const Dataset *dataset, int num_layers,
+                        const int *architecture, const TrainerConfig *config,
+                        int num_epochs, int num_samples, int fitness_samples,
+                        const Projection *projection, const char *model_file,
+                        const char *projection_file) {
+  static const char *optimizer_names[] = {"SGD", "momentum", "Adam"};
+  NeuralNetwork *net = create_neural_network(num_layers, architecture);
+  Rng rng;
+  rng_seed(&rng, (uint64_t)time(NULL));
+  if (net) {
+    initialize_network_for_training(net, &rng);
+  }
+  Trainer *trainer = net ? create_trainer(net, config) : NULL;
+  if (!trainer) {
+    fprintf(stderr, "Failed to set up training.\n");
+    free_neural_network(net);
+    return 1;
+  }
   if (num_samples > dataset->num_items) {
     num_samples = dataset->num_items;
   }
+  printf("Training with %s (learning rate %g, batches of %d, %d thread "
+         "shards) on %d samples.\n",
+         optimizer_names[config->optimizer], config->learning_rate,
+         config->batch_size, trainer->num_shards, num_samples);
+  printf("--------------------\n");
 
-  for (int i = 0; i < num_samples; i++) {
-    // Create a temporary matrix for a single image input
-    Matrix *input = create_matrix(1, MNIST_IMAGE_SIZE);
-    if (!input)
-      continue;
-    memcpy(input->data[0], dataset->images->data[i],
-           MNIST_IMAGE_SIZE * sizeof(double));
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  double accuracy = 0.0;
+  for (int epoch = 0; epoch < num_epochs; epoch++) {
+    double loss = train_epoch(trainer, dataset, num_samples, &rng);
+    accuracy = network_accuracy(net, dataset, fitness_samples);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - start.tv_sec) +
+                     (now.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Epoch %d/%d | Loss: %.4f | Accuracy: %.2f%% | %.1f s\n",
+           epoch + 1, num_epochs, loss, accuracy * 100.0, elapsed);
+  }
+  printf("--------------------\n");
+  printf("Training finished.\n");
+  printf("Accuracy after %d epochs: %.2f%%\n", num_epochs, accuracy * 100.0);
 
-    Matrix *output = forward_pass(network, input);
-    if (!output) {
-      free_matrix(input);
-      continue;
-    }
+  int status = 0;
+  if (save_network(net, model_file)) {
+    printf("Trained network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the trained network.\n");
+    status = 1;
+  }
+  save_model_projection(projection, projection_file);
 
-    int predicted_class = get_predicted_class(output);
+  free_trainer(trainer);
+  free_neural_network(net);
+  return status;
+}
 
-    int true_class = 0;
-    for (int j = 0; j < MNIST_NUM_CLASSES; j++) {
-      if (dataset->labels->data[i][j] == 1.0) {
-        true_class = j;
-        break;
-      }
-    }
+// --- Closed-Form Training ---
+// Keeps the random hidden layer and solves the output layer by ridge
+// regression over the training records.
+int train_with_ridge(const Dataset *dataset, int num_layers,
+                     const int *architecture, double lambda, int num_samples,
+                     int fitness_samples, const Projection *projection,
+                     const char *model_file, const char *projection_file) {
+  NeuralNetwork *net = create_neural_network(num_layers, architecture);
+  if (!net) {
+    fprintf(stderr, "Failed to create the network.\n");
+    return 1;
+  }
+  if (num_samples > dataset->num_items) {
+    num_samples = dataset->num_items;
+  }
+  printf("Solving the output layer by ridge regression (lambda %g) on %d "
+         "samples.\n",
+         lambda, num_samples);
+  printf("--------------------\n");
+
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (!fit_output_layer(net, dataset, num_samples, lambda)) {
+    fprintf(stderr, "Failed to fit the output layer.\n");
+    free_neural_network(net);
+    return 1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double elapsed =
+      (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+  double accuracy = network_accuracy(net, dataset, fitness_samples);
+  printf("Solved in %.2f s | Accuracy: %.2f%%\n", elapsed, accuracy * 100.0);
+
+  int status = 0;
+  if (save_network(net, model_file)) {
+    printf("Trained network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the trained network.\n");
+    status = 1;
+  }
+  save_model_projection(projection, projection_file);
+
+  free_neural_network(net);
+  return status;
+}
+
+// --- Evolution Strategies ---
+// Searches around one mean network. Candidates exist only as seeds, so the
+// generation holds no networks besides one scratch copy per thread.
+int evolve_with_es(const Dataset *dataset, int num_layers,
+                   const int *architecture, const EsConfig *config,
+                   int num_generations, int num_samples,
+                   const Projection *projection, const char *model_file,
+                   const char *projection_file) {
+  // initialize_network's all-positive weights give every nearby candidate
+  // the same predictions, which leaves the ranks nothing to work with
+  NeuralNetwork *net = create_neural_network(num_layers, architecture);
+  if (!net) {
+    fprintf(stderr, "Failed to create the network.\n");
+    return 1;
+  }
+  Rng rng;
+  rng_seed(&rng, config->seed);
+  initialize_network_for_training(net, &rng);
+  EvolutionStrategy *es = create_evolution_strategy(net, config);
+  double *fitness = (double *)malloc(config->population * sizeof(double));
+  if (!es || !fitness) {
+    fprintf(stderr, "Failed to set up the evolution strategy.\n");
+    free(fitness);
+    free_evolution_strategy(es);
+    free_neural_network(net);
+    return 1;
+  }
+  printf("Evolution strategy: %s, %d candidates per generation, sigma %g, "
+         "%zu parameters.\n",
+         config->kind == ES_OPENAI ? "OpenAI-ES (antithetic)"
+                                   : "separable CMA-ES",
+         config->population, config->sigma, es->num_params);
+  printf("Using %d samples for fitness evaluation.\n", num_samples);
+  printf("--------------------\n");
 
-    if (predicted_class == true_class) {
-      correct_predictions++;
+  double accuracy = 0.0;
+  for (int gen = 0; gen < num_generations; gen++) {
+    es_ask(es);
+    es_evaluate(es, net, dataset, num_samples, fitness);
+    double best_candidate = 0.0;
+    for (int i = 0; i < config->population; i++) {
+      if (fitness[i] > best_candidate) {
+        best_candidate = fitness[i];
+      }
     }
+    // Drop the tie-breaking confidence term to report plain accuracy
+    best_candidate = floor(best_candidate * num_samples + 1e-9) / num_samples;
+    es_tell(es, fitness);
+    es_mean_network(es, net);
+    accuracy = network_accuracy(net, dataset, num_samples);
+    printf("Generation %d/%d | Best Candidate: %.2f%% | Mean Network: "
+           "%.2f%% | Sigma: %.4f\n",
+           gen + 1, num_generations, best_candidate * 100.0,
+           accuracy * 100.0, es->sigma);
+  }
+  printf("--------------------\n");
+  printf("Evolution finished.\n");
+  printf("Mean network accuracy after %d generations: %.2f%%\n",
+         num_generations, accuracy * 100.0);
 
-    free_matrix(input);
-    free_matrix(output);
+  int status = 0;
+  if (save_network(net, model_file)) {
+    printf("Mean network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the mean network.\n");
+    status = 1;
   }
+  save_model_projection(projection, projection_file);
 
-  return (double)correct_predictions / num_samples;
+  free(fitness);
+  free_evolution_strategy(es);
+  free_neural_network(net);
+  return status;
 }
 
-int main() {
-  printf(
-      "--- Starting MNIST Training with Genetic Algorithm (C Version) ---\n");
+// --- Island Model ---
+// Runs one population per island thread and saves the best network any
+// island found.
+int evolve_on_islands(const Dataset *dataset, int num_layers,
+                      const int *architecture, const IslandConfig *config,
+                      const Projection *projection, const char *model_file,
+                      const char *projection_file) {
+  IslandStats *stats =
+      (IslandStats *)calloc(config->num_islands, sizeof(IslandStats));
+  if (!stats) {
+    return 1;
+  }
+  printf("Island model: %d islands of %d networks, %s migration of %d "
+         "networks every %d generations.\n",
+         config->num_islands, config->population,
+         config->topology == MIGRATION_RING ? "ring" : "all-to-all",
+         config->migrants, config->migration_interval);
+  printf("Using %d samples for fitness evaluation.\n", config->num_samples);
+  printf("--------------------\n");
 
-  // --- 1. Define Parameters ---
-  const int ARCHITECTURE[] = {MNIST_IMAGE_SIZE, 128, MNIST_NUM_CLASSES};
-  const int NUM_LAYERS = sizeof(ARCHITECTURE) / sizeof(int);
-#define POPULATION_SIZE 50
-#define NUM_GENERATIONS 100
-  const float MUTATION_RATE = 0.05f;
-  const float MUTATION_CHANCE = 0.1f;
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  double best_fitness = 0.0;
+  NeuralNetwork *best_net = run_islands(config, num_layers, architecture,
+                                        dataset, stats, &best_fitness);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double elapsed =
+      (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+  if (!best_net) {
+    fprintf(stderr, "Island evolution failed.\n");
+    free(stats);
+    return 1;
+  }
 
-  // --- 2. Load MNIST Data ---
-  Dataset *train_dataset = load_mnist_dataset("data/train-images.idx3-ubyte",
-                                              "data/train-labels.idx1-ubyte");
-  if (!train_dataset) {
-    fprintf(stderr, "Failed to load training data.\n");
+  printf("--------------------\n");
+  long evaluations = 0;
+  for (int i = 0; i < config->num_islands; i++) {
+    printf("Island %d | Best Accuracy: %.2f%% | %.1f networks/s | Migrants "
+           "sent %ld, received %ld, dropped %ld\n",
+           i, stats[i].best_fitness * 100.0,
+           stats[i].seconds > 0.0 ? stats[i].evaluations / stats[i].seconds
+                                  : 0.0,
+           stats[i].migrants_sent, stats[i].migrants_received,
+           stats[i].migrants_dropped);
+    evaluations += stats[i].evaluations;
+  }
+  printf("Evolution finished.\n");
+  printf("Best accuracy achieved after %d generations: %.2f%%\n",
+         config->generations, best_fitness * 100.0);
+  printf("Scored %ld networks in %.1f s (%.1f networks/s).\n", evaluations,
+         elapsed, elapsed > 0.0 ? evaluations / elapsed : 0.0);
+
+  int status = 0;
+  if (save_network(best_net, model_file)) {
+    printf("Best network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the best network.\n");
+    status = 1;
+  }
+  save_model_projection(projection, projection_file);
+
+  free_neural_network(best_net);
+  free(stats);
+  return status;
+}
+
+// --- Steady-State Evolution ---
+// Breeds and scores one child at a time on every worker thread, with no
+// generation barrier, and saves the fittest network.
+int evolve_steady_state(const Dataset *dataset, int num_layers,
+                        const int *architecture,
+                        const SteadyStateConfig *config,
+                        const Projection *projection, const char *model_file,
+                        const char *projection_file) {
+  printf("Steady-state evolution: %d networks, %ld children, tournaments of "
+         "%d, %d worker threads.\n",
+         config->population, config->evaluations, config->tournament_size,
+         config->threads);
+  printf("Using %d samples for fitness evaluation.\n", config->num_samples);
+  printf("--------------------\n");
+
+  SteadyStateStats stats;
+  double best_fitness = 0.0;
+  NeuralNetwork *best_net = run_steady_state(
+      config, num_layers, architecture, dataset, &stats, &best_fitness);
+  if (!best_net) {
+    fprintf(stderr, "Steady-state evolution failed.\n");
     return 1;
   }
-  // The training set will be used for both training and fitness evaluation.
+  printf("--------------------\n");
+  printf("Evolution finished.\n");
+  printf("Best accuracy after %ld children: %.2f%% (initial population "
+         "%.2f%%)\n",
+         stats.evaluations, best_fitness * 100.0,
+         stats.initial_best_fitness * 100.0);
+  double worker_seconds = stats.seconds * config->threads;
+  printf("Scored %.1f children/s; %ld replaced a network; workers waited "
+         "on the population lock %.2f%% of the time.\n",
+         stats.seconds > 0.0 ? stats.evaluations / stats.seconds : 0.0,
+         stats.insertions,
+         worker_seconds > 0.0 ? 100.0 * stats.lock_wait_seconds / worker_seconds
+                              : 0.0);
 
-#define FITNESS_SAMPLES 1000 // Use 1000 samples for fitness eval
+  int status = 0;
+  if (save_network(best_net, model_file)) {
+    printf("Best network saved to %s\n", model_file);
+  } else {
+    fprintf(stderr, "Failed to save the best network.\n");
+    status = 1;
+  }
+  save_model_projection(projection, projection_file);
+
+  free_neural_network(best_net);
+  return status;
+}
+
+// --- Generational Evolution ---
+// The default mode: evolves float64 networks generation by generation,
+// scoring them in memory, from a stream or on distributed workers, with
+// optional checkpoints. A resumed run adopts the checkpoint's population.
+// Everything created here is freed on every path; the caller keeps the
+// dataset, stream, checkpoint state and projection.
+int evolve_population(const Dataset *dataset, DatasetStream *stream,
+                      int num_layers, const int *architecture,
+                      int population_size, int num_generations,
+                      int num_samples,
+                      float mutation_rate, float mutation_chance,
+                      EvolutionState *resumed, const char *resume_path,
+                      int ridge_seed, double ridge_lambda,
+                      const char *master_address, int dispatch_batch,
+                      const char *checkpoint_path, int checkpoint_every,
+                      const Projection *projection, const char *model_file,
+                      const char *projection_file) {
+  NeuralNetwork **population = NULL;
+  int start_gen = 0;
+  if (resumed) {
+    const NeuralNetwork *first = resumed->population[0];
+    int matches = first->num_layers == num_layers;
+    for (int i = 0; matches && i < num_layers; i++) {
+      matches = first->architecture[i] == architecture[i];
+    }
+    if (!matches) {
+      fprintf(stderr, "Checkpoint %s does not match the network "
+                      "architecture.\n",
+              resume_path);
+      return 1;
+    }
+    // The population is adopted as is; the fitness values stored with it
+    // stand in for the first evaluation
+    population = resumed->population;
+    resumed->population = NULL;
+    start_gen = resumed->generation;
+    srand(resumed->rng_seed);
+    printf("Resumed from %s at generation %d.\n", resume_path,
+           start_gen + 1);
+  } else {
+    srand(time(NULL));
+    population =
+        create_initial_population(population_size, num_layers, architecture);
+    if (!population) {
+      fprintf(stderr, "Failed to allocate the population.\n");
+      return 1;
+    }
+    printf("Created initial population of %d networks.\n", population_size);
+    // Seeded networks keep their own random hidden layers, so the
+    // population stays diverse
+    if (ridge_seed) {
+      for (int i = 0; i < population_size; i++) {
+        fit_output_layer(population[i], dataset, num_samples, ridge_lambda);
+      }
+      printf("Solved every output layer by ridge regression on the fitness "
+             "samples.\n");
+    }
+  }
+
+  // Per-generation scratch lives on the heap so large populations do not
+  // depend on the stack size
+  NetworkFitness *population_with_fitness =
+      (NetworkFitness *)malloc(population_size * sizeof(NetworkFitness));
+  double *fitness = (double *)malloc(population_size * sizeof(double));
+  int status = 0;
+  if (!population_with_fitness || !fitness) {
+    fprintf(stderr, "Failed to allocate the population.\n");
+    status = 1;
+  }
+  // Genomes are scored on the master itself while no worker is connected
+  DistributedMaster *master = NULL;
+  if (status == 0 && master_address) {
+    master = start_master(master_address, num_layers, architecture,
+                          num_samples, dispatch_batch, dataset, 1);
+    if (!master) {
+      fprintf(stderr, "Failed to start the master on %s.\n", master_address);
+      status = 1;
+    } else {
+      printf("Master listening on %s for workers.\n", master_address);
+    }
+  }
+  if (status != 0) {
+    for (int i = 0; i < population_size; i++) {
+      free_neural_network(population[i]);
+    }
+    free(population);
+    free(population_with_fitness);
+    free(fitness);
+    return status;
+  }
 
-  // --- 3. Create Initial Population ---
-  srand(time(NULL));
-  NeuralNetwork **population =
-      create_initial_population(POPULATION_SIZE, NUM_LAYERS, ARCHITECTURE);
-  printf("Created initial population of %d networks.\n", POPULATION_SIZE);
   printf("Network architecture: [");
-  for (int i = 0; i < NUM_LAYERS; i++)
-    printf("%d%s", ARCHITECTURE[i], i == NUM_LAYERS - 1 ? "" : ", ");
+  for (int i = 0; i < num_layers; i++)
+    printf("%d%s", architecture[i], i == num_layers - 1 ? "" : ", ");
   printf("]\n");
-  printf("Using %d samples for fitness evaluation.\n", FITNESS_SAMPLES);
+  if (num_samples > 0) {
+    printf("Using %d samples for fitness evaluation.\n", num_samples);
+  } else {
+    printf("Using all %d samples for fitness evaluation.\n",
+           dataset_stream_num_items(stream));
+  }
   printf("--------------------\n");
 
-  // --- 4. Run Evolutionary Loop ---
-  for (int gen = 0; gen < NUM_GENERATIONS; gen++) {
-    NetworkFitness population_with_fitness[POPULATION_SIZE];
+  CheckpointWriter *checkpoint_writer = NULL;
+  if (checkpoint_path) {
+    checkpoint_writer = start_checkpoint_writer(checkpoint_path);
+    if (!checkpoint_writer) {
+      fprintf(stderr, "Failed to start the checkpoint writer.\n");
+    }
+  }
+
+  for (int gen = start_gen; gen < num_generations; gen++) {
     double best_accuracy_in_gen = 0.0;
 
-    for (int i = 0; i < POPULATION_SIZE; i++) {
+    for (int i = 0; i < population_size; i++) {
       population_with_fitness[i].network = population[i];
-      population_with_fitness[i].fitness =
-          calculate_fitness(population[i], train_dataset, FITNESS_SAMPLES);
+    }
+    if (resumed && gen == start_gen) {
+      for (int i = 0; i < population_size; i++) {
+        population_with_fitness[i].fitness = resumed->fitness[i];
+      }
+    } else {
+      evaluate_population(population_with_fitness, population_size, dataset,
+                          stream, master, num_samples);
+    }
+    for (int i = 0; i < population_size; i++) {
       if (population_with_fitness[i].fitness > best_accuracy_in_gen) {
         best_accuracy_in_gen = population_with_fitness[i].fitness;
       }
     }
     printf("Generation %d/%d | Best Accuracy: %.2f%%\n", gen + 1,
-           NUM_GENERATIONS, best_accuracy_in_gen * 100.0);
+           num_generations, best_accuracy_in_gen * 100.0);
+
+    // rand() state cannot be saved, so the generator is reseeded from its
+    // own stream and the seed stored; a resumed run reseeds identically.
+    // The snapshot is written on the background thread while evolution
+    // carries on. The generation a run resumed from is already on disk.
+    int resuming = resumed && gen == start_gen;
+    if (checkpoint_writer && !resuming && (gen + 1) % checkpoint_every == 0) {
+      for (int i = 0; i < population_size; i++) {
+        fitness[i] = population_with_fitness[i].fitness;
+      }
+      EvolutionState *snapshot =
+          snapshot_evolution_state(population, fitness, population_size);
+      unsigned int seed = (unsigned int)rand();
+      srand(seed);
+      if (snapshot) {
+        snapshot->generation = gen;
+        snapshot->num_generations = num_generations;
+        snapshot->mutation_rate = mutation_rate;
+        snapshot->mutation_chance = mutation_chance;
+        snapshot->fitness_samples = num_samples;
+        snapshot->projection_kind = projection ? projection->kind : 0;
+        snapshot->projection_size = projection ? projection->output_size : 0;
+        snapshot->rng_seed = seed;
+        checkpoint_writer_submit(checkpoint_writer, snapshot);
+      }
+    }
 
     int num_fittest;
     NetworkFitness *fittest_networks_info =
-        select_fittest(population_with_fitness, POPULATION_SIZE, &num_fittest);
+        select_fittest(population_with_fitness, population_size, &num_fittest);
 
     NeuralNetwork **new_population =
-        reproduce(fittest_networks_info, num_fittest, POPULATION_SIZE,
-                  MUTATION_RATE, MUTATION_CHANCE);
+        reproduce(fittest_networks_info, num_fittest, population_size,
+                  mutation_rate, mutation_chance);
+    free(fittest_networks_info);
+    // The current generation is kept and saved if the next cannot be bred
+    if (!new_population) {
+      fprintf(stderr, "Failed to allocate the next generation.\n");
+      status = 1;
+      break;
+    }
 
-    for (int i = 0; i < POPULATION_SIZE; i++) {
+    for (int i = 0; i < population_size; i++) {
       free_neural_network(population[i]);
     }
     free(population);
-    free(fittest_networks_info);
     population = new_population;
   }
 
+  stop_checkpoint_writer(checkpoint_writer);
+
   printf("--------------------\n");
-  // --- 5. Find Best Network and Save ---
+  // Find the best network and save it
   NeuralNetwork *best_net = NULL;
   double best_overall_accuracy = 0.0;
-  for (int i = 0; i < POPULATION_SIZE; i++) {
-    double accuracy =
-        calculate_fitness(population[i], train_dataset, FITNESS_SAMPLES);
-    if (accuracy > best_overall_accuracy) {
-      best_overall_accuracy = accuracy;
+  for (int i = 0; i < population_size; i++) {
+    population_with_fitness[i].network = population[i];
+  }
+  evaluate_population(population_with_fitness, population_size, dataset,
+                      stream, master, num_samples);
+  for (int i = 0; i < population_size; i++) {
+    if (population_with_fitness[i].fitness > best_overall_accuracy) {
+      best_overall_accuracy = population_with_fitness[i].fitness;
       best_net = population[i];
     }
   }
 
   printf("Evolution finished.\n");
   printf("Best accuracy achieved after %d generations: %.2f%%\n",
-         NUM_GENERATIONS, best_overall_accuracy * 100.0);
+         num_generations, best_overall_accuracy * 100.0);
+  if (master) {
+    DistributedStats stats;
+    distributed_stats(master, &stats);
+    printf("Workers connected at the end: %d | Networks sent: %ld | "
+           "Re-queued: %ld | Scored by the master: %ld\n",
+           stats.workers, stats.jobs_sent, stats.jobs_requeued,
+           stats.jobs_local);
+    stop_master(master);
+  }
 
   if (best_net) {
-    if (save_network(best_net, "trained_network.dat")) {
-      printf("Best network saved to trained_network.dat\n");
+    if (save_network(best_net, model_file)) {
+      printf("Best network saved to %s\n", model_file);
     } else {
       fprintf(stderr, "Failed to save the best network.\n");
+      status = 1;
     }
+    save_model_projection(projection, projection_file);
   }
 
-  // --- 6. Cleanup ---
-  free_dataset(train_dataset);
-  for (int i = 0; i < POPULATION_SIZE; i++) {
+  for (int i = 0; i < population_size; i++) {
     free_neural_network(population[i]);
   }
   free(population);
+  free(population_with_fitness);
+  free(fitness);
+  return status;
+}
 
-  return 0;
+#define CHECKPOINT_INTERVAL 10
+// Generations (or a generation's worth of children) between progress lines
+// of the threaded modes
+#define REPORT_INTERVAL 10
+#define POPULATION_SIZE 50
+#define TRAIN_EPOCHS 10
+
+// --- Training Modes ---
+// Each run trains with exactly one mode. --stream, --checkpoint, --resume,
+// --ridge-seed and --master only apply to the default genetic algorithm.
+typedef enum {
+  MODE_GENERATIONAL = 0,
+  MODE_INT8,
+  MODE_HALF,
+  MODE_BINARIZED,
+  MODE_BACKPROP,
+  MODE_RIDGE,
+  MODE_ES,
+  MODE_ISLANDS,
+  MODE_STEADY_STATE,
+  MODE_WORKER
+} TrainingMode;
+
+// Records the mode a flag selects, refusing a second, different one
+int select_mode(TrainingMode *mode, const char **mode_flag,
+                TrainingMode requested, const char *flag) {
+  if (*mode != MODE_GENERATIONAL && *mode != requested) {
+    fprintf(stderr, "%s cannot be combined with %s; choose one training "
+                    "mode.\n",
+            flag, *mode_flag);
+    return 0;
+  }
+  *mode = requested;
+  *mode_flag = flag;
+  return 1;
+}
+
+void print_usage(const char *program) {
+  IslandConfig island_defaults;
+  default_island_config(&island_defaults);
+  SteadyStateConfig steady_defaults;
+  default_steady_state_config(&steady_defaults);
+  fprintf(stderr,
+          "Usage: %s [--stream] [--fitness-samples N] [--pca K | "
+          "--random-projection K]\n"
+          "          [--checkpoint PATH] [--checkpoint-every N] "
+          "[--resume PATH]\n"
+          "          [--genome float64|int8|fp16|bf16|binary] [--population N]\n"
+          "          [--train sgd|momentum|adam] [--epochs N] [--batch-size N]\n"
+          "          [--learning-rate R] [--train-samples N]\n"
+          "          [--train ridge] [--ridge-lambda L] [--ridge-seed]\n"
+          "          [--es openai|cma] [--sigma S]\n"
+          "          [--islands K] [--migration ring|all] "
+          "[--migration-interval N] [--migrants M]\n"
+          "          [--master ADDRESS [--dispatch-batch N] | --worker "
+          "ADDRESS]\n"
+          "          [--steady-state] [--tournament K]\n"
+          "  --stream             Stream training batches from disk with "
+          "background prefetch\n"
+          "  --fitness-samples N  Samples used to score each network "
+          "(0 = all, streaming only)\n"
+          "  --pca K              Reduce inputs to K principal components\n"
+          "  --random-projection K  Reduce inputs with a seeded K-wide random "
+          "projection\n"
+          "  --checkpoint PATH    Periodically save the full evolutionary "
+          "state to PATH\n"
+          "  --checkpoint-every N Generations between checkpoints (default "
+          "%d)\n"
+          "  --resume PATH        Continue the run saved in a checkpoint\n"
+          "  --genome int8        Evolve int8 weights directly and save an "
+          "int8 model\n"
+          "  --genome fp16|bf16   Store genomes as 16-bit floats, a quarter "
+          "of the memory\n"
+          "  --genome binary      Evolve +-1 weights on thresholded, "
+          "bit-packed inputs\n"
+          "  --population N       Networks per generation (default %d)\n"
+          "  --train OPTIMIZER    Train one network with backpropagation "
+          "instead of evolving\n"
+          "  --epochs N           Passes over the training samples (default "
+          "%d)\n"
+          "  --batch-size N       Mini-batch size (default 64)\n"
+          "  --learning-rate R    Step size (default depends on the "
+          "optimizer)\n"
+          "  --train-samples N    Records to train on (default all)\n"
+          "  --train ridge        Keep the random hidden layer and solve the "
+          "output layer\n"
+          "  --ridge-lambda L     Ridge penalty (default %g)\n"
+          "  --ridge-seed         Solve each initial network's output layer "
+          "before evolving\n"
+          "  --es openai|cma      Evolve one mean network with OpenAI-ES or "
+          "separable CMA-ES\n"
+          "  --sigma S            Initial noise scale for --es\n"
+          "  --islands K          Evolve K populations of --population "
+          "networks on K threads\n"
+          "  --migration TOPOLOGY Send migrants around a ring or to all "
+          "other islands (default ring)\n"
+          "  --migration-interval N  Generations between migrations "
+          "(default %d)\n"
+          "  --migrants M         Best networks sent to each neighbour "
+          "(default %d)\n"
+          "  --master ADDRESS     Score networks on worker processes "
+          "connecting to host:port or unix:PATH\n"
+          "  --dispatch-batch N   Networks sent to a worker per message "
+          "(default %d)\n"
+          "  --worker ADDRESS     Score networks for the master at ADDRESS "
+          "until it finishes\n"
+          "  --steady-state       Breed children continuously on every thread "
+          "instead of in generations\n"
+          "  --tournament K       Contestants per parent in --steady-state "
+          "(default %d)\n",
+          program, CHECKPOINT_INTERVAL, POPULATION_SIZE, TRAIN_EPOCHS,
+          RIDGE_DEFAULT_LAMBDA, island_defaults.migration_interval,
+          island_defaults.migrants, DISTRIBUTED_DEFAULT_BATCH,
+          steady_defaults.tournament_size);
+}
+
+int main(int argc, char *argv[]) {
+  printf(
+      "--- Starting MNIST Training with Genetic Algorithm (C Version) ---\n");
+
+  // --- 1. Define Parameters ---
+  int ARCHITECTURE[] = {MNIST_IMAGE_SIZE, 128, MNIST_NUM_CLASSES};
+  const int NUM_LAYERS = sizeof(ARCHITECTURE) / sizeof(int);
+#define NUM_GENERATIONS 100
+  float mutation_rate = 0.05f;
+  float mutation_chance = 0.1f;
+
+#define FITNESS_SAMPLES 1000 // Use 1000 samples for fitness eval
+#define STREAM_BATCH_SIZE 1024
+// Loads of at least this many training records go through the dataset cache
+#define CACHED_LOAD_MIN_RECORDS (MNIST_TRAIN_SIZE / 4)
+#define PCA_FIT_SAMPLES 10000 // Records used to fit the PCA basis
+#define PROJECTION_SEED 2024
+#define NETWORK_FILE "trained_network.dat"
+#define PROJECTION_FILE NETWORK_FILE ".proj"
+#define INT8_NETWORK_FILE "trained_network.q8"
+#define BINARIZED_NETWORK_FILE "trained_network.bnn"
+// A bit flip changes a weight from +1 to -1, a far bigger step than a float
+// mutation, so binarized genomes flip a tenth as many bits
+#define BINARIZED_FLIP_SCALE 0.1f
+
+  int fitness_samples = FITNESS_SAMPLES;
+  int use_stream = 0;
+  int projection_kind = 0;
+  int projection_size = 0;
+  const char *checkpoint_path = NULL;
+  const char *resume_path = NULL;
+  int checkpoint_every = CHECKPOINT_INTERVAL;
+  TrainingMode mode = MODE_GENERATIONAL;
+  const char *mode_flag = NULL;
+  HalfFormat half_format = 0;
+  int population_size = POPULATION_SIZE;
+  EsConfig es_config;
+  double es_sigma = 0.0;
+  int ridge_seed = 0;
+  double ridge_lambda = RIDGE_DEFAULT_LAMBDA;
+  TrainerConfig trainer_config;
+  default_trainer_config(&trainer_config, OPTIMIZER_ADAM);
+  double learning_rate = 0.0;
+  int batch_size = 0;
+  int num_epochs = TRAIN_EPOCHS;
+  int train_samples = MNIST_TRAIN_SIZE;
+  IslandConfig island_config;
+  default_island_config(&island_config);
+  const char *master_address = NULL;
+  const char *worker_address = NULL;
+  int dispatch_batch = DISTRIBUTED_DEFAULT_BATCH;
+  SteadyStateConfig steady_config;
+  default_steady_state_config(&steady_config);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stream") == 0) {
+      use_stream = 1;
+    } else if (strcmp(argv[i], "--fitness-samples") == 0 && i + 1 < argc) {
+      fitness_samples = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--pca") == 0 && i + 1 < argc) {
+      projection_kind = PROJECTION_PCA;
+      projection_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--random-projection") == 0 && i + 1 < argc) {
+      projection_kind = PROJECTION_RANDOM;
+      projection_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+      checkpoint_path = argv[++i];
+    } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+      checkpoint_every = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+      resume_path = argv[++i];
+    } else if (strcmp(argv[i], "--population") == 0 && i + 1 < argc) {
+      population_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--train") == 0 && i + 1 < argc) {
+      const char *optimizer = argv[++i];
+      int ridge = strcmp(optimizer, "ridge") == 0;
+      if (!select_mode(&mode, &mode_flag, ridge ? MODE_RIDGE : MODE_BACKPROP,
+                       "--train")) {
+        return 1;
+      }
+      if (strcmp(optimizer, "sgd") == 0) {
+        default_trainer_config(&trainer_config, OPTIMIZER_SGD);
+      } else if (strcmp(optimizer, "momentum") == 0) {
+        default_trainer_config(&trainer_config, OPTIMIZER_MOMENTUM);
+      } else if (strcmp(optimizer, "adam") == 0) {
+        default_trainer_config(&trainer_config, OPTIMIZER_ADAM);
+      } else if (!ridge) {
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--es") == 0 && i + 1 < argc) {
+      const char *strategy = argv[++i];
+      if (!select_mode(&mode, &mode_flag, MODE_ES, "--es")) {
+        return 1;
+      }
+      if (strcmp(strategy, "openai") == 0) {
+        default_es_config(&es_config, ES_OPENAI);
+      } else if (strcmp(strategy, "cma") == 0) {
+        default_es_config(&es_config, ES_SEPARABLE_CMA);
+      } else {
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--sigma") == 0 && i + 1 < argc) {
+      es_sigma = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--islands") == 0 && i + 1 < argc) {
+      if (!select_mode(&mode, &mode_flag, MODE_ISLANDS, "--islands")) {
+        return 1;
+      }
+      island_config.num_islands = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--migration") == 0 && i + 1 < argc) {
+      const char *topology = argv[++i];
+      if (strcmp(topology, "ring") == 0) {
+        island_config.topology = MIGRATION_RING;
+      } else if (strcmp(topology, "all") == 0) {
+        island_config.topology = MIGRATION_ALL_TO_ALL;
+      } else {
+        print_usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--migration-interval") == 0 && i + 1 < argc) {
+      island_config.migration_interval = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--migrants") == 0 && i + 1 < argc) {
+      island_config.migrants = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--master") == 0 && i + 1 < argc) {
+      master_address = argv[++i];
+    } else if (strcmp(argv[i], "--worker") == 0 && i + 1 < argc) {
+      if (!select_mode(&mode, &mode_flag, MODE_WORKER, "--worker")) {
+        return 1;
+      }
+      worker_address = argv[++i];
+    } else if (strcmp(argv[i], "--dispatch-batch") == 0 && i + 1 < argc) {
+      dispatch_batch = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--steady-state") == 0) {
+      if (!select_mode(&mode, &mode_flag, MODE_STEADY_STATE,
+                       "--steady-state")) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--tournament") == 0 && i + 1 < argc) {
+      steady_config.tournament_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ridge-lambda") == 0 && i + 1 < argc) {
+      ridge_lambda = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--ridge-seed") == 0) {
+      ridge_seed = 1;
+    } else if (strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+      num_epochs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc) {
+      batch_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--learning-rate") == 0 && i + 1 < argc) {
+      learning_rate = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--train-samples") == 0 && i + 1 < argc) {
+      train_samples = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--genome") == 0 && i + 1 < argc) {
+      const char *genome = argv[++i];
+      TrainingMode genome_mode = MODE_GENERATIONAL;
+      if (strcmp(genome, "int8") == 0) {
+        genome_mode = MODE_INT8;
+      } else if (strcmp(genome, "fp16") == 0) {
+        genome_mode = MODE_HALF;
+        half_format = HALF_FP16;
+      } else if (strcmp(genome, "bf16") == 0) {
+        genome_mode = MODE_HALF;
+        half_format = HALF_BF16;
+      } else if (strcmp(genome, "binary") == 0) {
+        genome_mode = MODE_BINARIZED;
+      } else if (strcmp(genome, "float64") != 0) {
+        print_usage(argv[0]);
+        return 1;
+      }
+      if (genome_mode != MODE_GENERATIONAL &&
+          !select_mode(&mode, &mode_flag, genome_mode, "--genome")) {
+        return 1;
+      }
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (mode != MODE_GENERATIONAL &&
+      (use_stream || checkpoint_path || resume_path || ridge_seed ||
+       master_address)) {
+    fprintf(stderr, "%s cannot be combined with --stream, --checkpoint, "
+                    "--resume, --ridge-seed or --master, which only apply to "
+                    "the default genetic algorithm.\n",
+            mode_flag);
+    return 1;
+  }
+  if (ridge_seed && (use_stream || resume_path)) {
+    fprintf(stderr, "--ridge-seed only seeds a fresh in-memory float64 "
+                    "population.\n");
+    return 1;
+  }
+  if (master_address && use_stream) {
+    fprintf(stderr, "--master scores the in-memory records and cannot be "
+                    "combined with --stream.\n");
+    return 1;
+  }
+  if (mode == MODE_BACKPROP && (num_epochs < 1 || train_samples < 1 ||
+                                batch_size < 0 || learning_rate < 0.0)) {
+    fprintf(stderr, "--train needs positive epochs, samples, batch size and "
+                    "learning rate.\n");
+    return 1;
+  }
+  if (mode == MODE_ES) {
+    es_config.population = population_size;
+    es_config.seed = (uint64_t)time(NULL);
+    if (es_sigma > 0.0) {
+      es_config.sigma = es_sigma;
+    }
+    if (learning_rate > 0.0) {
+      es_config.learning_rate = learning_rate;
+    }
+  }
+  if (mode == MODE_ISLANDS &&
+      (island_config.num_islands < 1 ||
+       island_config.migration_interval < 1 || island_config.migrants < 0 ||
+       island_config.migrants > population_size / 2)) {
+    fprintf(stderr, "--islands needs at least one island, a positive "
+                    "migration interval and at most half the population "
+                    "as migrants.\n");
+    return 1;
+  }
+  if (mode == MODE_ISLANDS) {
+    island_config.population = population_size;
+    island_config.generations = NUM_GENERATIONS;
+    island_config.mutation_rate = mutation_rate;
+    island_config.mutation_chance = mutation_chance;
+    island_config.num_samples = fitness_samples;
+    island_config.seed = (uint64_t)time(NULL);
+    island_config.report_every = REPORT_INTERVAL;
+  }
+  if (dispatch_batch < 1) {
+    fprintf(stderr, "--dispatch-batch needs at least one network.\n");
+    return 1;
+  }
+  if (mode == MODE_STEADY_STATE && steady_config.tournament_size < 1) {
+    fprintf(stderr, "--tournament needs at least one contestant.\n");
+    return 1;
+  }
+  if (mode == MODE_STEADY_STATE) {
+    // The same number of scored networks as the generational loop
+    steady_config.population = population_size;
+    steady_config.evaluations = (long)NUM_GENERATIONS * population_size;
+    steady_config.mutation_rate = mutation_rate;
+    steady_config.mutation_chance = mutation_chance;
+    steady_config.num_samples = fitness_samples;
+    steady_config.seed = (uint64_t)time(NULL);
+    steady_config.report_every = (long)REPORT_INTERVAL * population_size;
+  }
+  if ((mode == MODE_RIDGE || ridge_seed) &&
+      (ridge_lambda < 0.0 || train_samples < 1)) {
+    fprintf(stderr, "Ridge fits need a non-negative penalty and positive "
+                    "samples.\n");
+    return 1;
+  }
+  if (batch_size > 0) {
+    trainer_config.batch_size = batch_size;
+  }
+  if (learning_rate > 0.0) {
+    trainer_config.learning_rate = learning_rate;
+  }
+  if (mode == MODE_BINARIZED && projection_kind) {
+    fprintf(stderr, "--genome binary thresholds raw pixels and cannot be "
+                    "combined with a projection.\n");
+    return 1;
+  }
+  if (population_size < 2) {
+    fprintf(stderr, "--population needs at least 2 networks.\n");
+    return 1;
+  }
+  if (checkpoint_every <= 0) {
+    fprintf(stderr, "--checkpoint-every needs a positive interval.\n");
+    return 1;
+  }
+
+  // A resumed run takes its hyperparameters and input reduction from the
+  // checkpoint so it continues exactly as the interrupted run would have
+  EvolutionState *resumed = NULL;
+  if (resume_path) {
+    resumed = load_checkpoint(resume_path);
+    if (!resumed) {
+      fprintf(stderr, "Failed to load checkpoint %s.\n", resume_path);
+      return 1;
+    }
+    if (resumed->population_size != population_size ||
+        resumed->num_generations != NUM_GENERATIONS) {
+      fprintf(stderr, "Checkpoint %s was written with a different population "
+                      "size or generation count.\n",
+              resume_path);
+      free_evolution_state(resumed);
+      return 1;
+    }
+    mutation_rate = resumed->mutation_rate;
+    mutation_chance = resumed->mutation_chance;
+    fitness_samples = resumed->fitness_samples;
+    projection_kind = resumed->projection_kind;
+    projection_size = resumed->projection_size;
+  }
+  if (!use_stream && fitness_samples <= 0) {
+    fprintf(stderr, "--fitness-samples 0 requires --stream.\n");
+    free_evolution_state(resumed);
+    return 1;
+  }
+  // A full-width projection would be indistinguishable from raw pixels:
+  // recognizer only looks for <model>.proj when the input width is not 784
+  if (projection_kind &&
+      (use_stream || projection_size <= 0 ||
+       projection_size >= MNIST_IMAGE_SIZE)) {
+    fprintf(stderr, "Projections need 1..%d components and cannot be "
+                    "combined with --stream.\n",
+            MNIST_IMAGE_SIZE - 1);
+    free_evolution_state(resumed);
+    return 1;
+  }
+
+  // Asking for more records than the training files hold uses all of them
+  if (!use_stream) {
+    int available = count_idx_records("data/train-images.idx3-ubyte",
+                                      "data/train-labels.idx1-ubyte");
+    if (available < 1) {
+      fprintf(stderr, "Failed to load training data.\n");
+      free_evolution_state(resumed);
+      return 1;
+    }
+    if (fitness_samples > available || train_samples > available) {
+      printf("The training files hold %d records; using at most that many.\n",
+             available);
+    }
+    if (fitness_samples > available) {
+      fitness_samples = available;
+    }
+    if (train_samples > available) {
+      train_samples = available;
+    }
+    island_config.num_samples = fitness_samples;
+    steady_config.num_samples = fitness_samples;
+  }
+
+  // Binarized genomes read thresholded, bit-packed records instead
+  if (mode == MODE_BINARIZED) {
+    BitDataset *bit_dataset = load_mnist_binarized(
+        "data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte", 0,
+        fitness_samples, MNIST_BINARIZE_THRESHOLD);
+    if (!bit_dataset) {
+      fprintf(stderr, "Failed to load training data.\n");
+      return 1;
+    }
+    int status = evolve_binarized_genomes(
+        bit_dataset, NUM_LAYERS, ARCHITECTURE, population_size,
+        NUM_GENERATIONS, fitness_samples, mutation_rate,
+        mutation_chance * BINARIZED_FLIP_SCALE, BINARIZED_NETWORK_FILE);
+    free_bit_dataset(bit_dataset);
+    return status;
+  }
+
+  // --- 2. Load MNIST Data ---
+  // Fitness only ever looks at the first fitness_samples records, so a small
+  // subset is read straight from the training files. Larger loads map the
+  // dataset cache and keep its first records, so repeated gradient and ridge
+  // runs skip parsing. With --stream the records are read batch by batch
+  // instead and never held in memory all at once.
+  Dataset *train_dataset = NULL;
+  DatasetStream *train_stream = NULL;
+  if (use_stream) {
+    train_stream = open_dataset_stream("data/train-images.idx3-ubyte",
+                                       "data/train-labels.idx1-ubyte",
+                                       STREAM_BATCH_SIZE);
+  } else {
+    // Gradient training visits every record it trains on, not just the
+    // ones fitness is scored on
+    int records = (mode == MODE_BACKPROP || mode == MODE_RIDGE) &&
+                          train_samples > fitness_samples
+                      ? train_samples
+                      : fitness_samples;
+    if (records < CACHED_LOAD_MIN_RECORDS) {
+      train_dataset =
+          load_mnist_range("data/train-images.idx3-ubyte",
+                           "data/train-labels.idx1-ubyte", 0, records);
+    } else {
+      train_dataset = load_mnist_dataset_cached(
+          "data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte",
+          "data/train.cache");
+      if (train_dataset) {
+        truncate_dataset(train_dataset, records);
+      }
+    }
+  }
+  if (!train_dataset && !train_stream) {
+    fprintf(stderr, "Failed to load training data.\n");
+    free_evolution_state(resumed);
+    return 1;
+  }
+  // The training set will be used for both training and fitness evaluation.
+
+  // --- 2b. Reduce Input Dimensionality ---
+  // The basis is fitted once, every image is projected up front, and the
+  // network is built for the reduced width.
+  Projection *projection = NULL;
+  if (projection_kind == PROJECTION_PCA) {
+    Dataset *fit_dataset = load_mnist_range("data/train-images.idx3-ubyte",
+                                            "data/train-labels.idx1-ubyte", 0,
+                                            PCA_FIT_SAMPLES);
+    projection = fit_pca(fit_dataset ? fit_dataset : train_dataset,
+                         projection_size, 0);
+    free_dataset(fit_dataset);
+  } else if (projection_kind == PROJECTION_RANDOM) {
+    projection = create_random_projection(MNIST_IMAGE_SIZE, projection_size,
+                                          PROJECTION_SEED);
+  }
+  if (projection_kind) {
+    Dataset *projected =
+        projection ? project_dataset(projection, train_dataset) : NULL;
+    if (!projected) {
+      fprintf(stderr, "Failed to build the input projection.\n");
+      free_projection(projection);
+      free_dataset(train_dataset);
+      free_evolution_state(resumed);
+      return 1;
+    }
+    free_dataset(train_dataset);
+    train_dataset = projected;
+    ARCHITECTURE[0] = projection_size;
+    printf("Projected inputs from %d to %d values (%s).\n", MNIST_IMAGE_SIZE,
+           projection_size,
+           projection_kind == PROJECTION_PCA ? "PCA" : "random projection");
+  }
+
+  int status;
+  switch (mode) {
+  case MODE_WORKER: {
+    // A worker holds the same records and projection as the master and
+    // scores whatever networks it is sent
+    printf("Worker holding %d records, connecting to %s.\n",
+           train_dataset->num_items, worker_address);
+    long scored = run_worker(worker_address, train_dataset, 0);
+    if (scored >= 0) {
+      printf("Master finished; scored %ld networks.\n", scored);
+    }
+    status = scored < 0;
+    break;
+  }
+  case MODE_INT8:
+    status = evolve_int8_genomes(
+        train_dataset, NUM_LAYERS, ARCHITECTURE, population_size,
+        NUM_GENERATIONS, fitness_samples, mutation_rate, mutation_chance,
+        projection, INT8_NETWORK_FILE, INT8_NETWORK_FILE ".proj");
+    break;
+  case MODE_HALF:
+    status = evolve_half_genomes(
+        train_dataset, NUM_LAYERS, ARCHITECTURE, half_format, population_size,
+        NUM_GENERATIONS, fitness_samples, mutation_rate, mutation_chance,
+        projection, NETWORK_FILE, PROJECTION_FILE);
+    break;
+  case MODE_BACKPROP:
+    status = train_with_backprop(
+        train_dataset, NUM_LAYERS, ARCHITECTURE, &trainer_config, num_epochs,
+        train_samples, fitness_samples, projection, NETWORK_FILE,
+        PROJECTION_FILE);
+    break;
+  case MODE_RIDGE:
+    status = train_with_ridge(train_dataset, NUM_LAYERS, ARCHITECTURE,
+                              ridge_lambda, train_samples, fitness_samples,
+                              projection, NETWORK_FILE, PROJECTION_FILE);
+    break;
+  case MODE_ES:
+    status = evolve_with_es(train_dataset, NUM_LAYERS, ARCHITECTURE,
+                            &es_config, NUM_GENERATIONS, fitness_samples,
+                            projection, NETWORK_FILE, PROJECTION_FILE);
+    break;
+  case MODE_ISLANDS:
+    status = evolve_on_islands(train_dataset, NUM_LAYERS, ARCHITECTURE,
+                               &island_config, projection, NETWORK_FILE,
+                               PROJECTION_FILE);
+    break;
+  case MODE_STEADY_STATE:
+    status = evolve_steady_state(train_dataset, NUM_LAYERS, ARCHITECTURE,
+                                 &steady_config, projection, NETWORK_FILE,
+                                 PROJECTION_FILE);
+    break;
+  default:
+    status = evolve_population(
+        train_dataset, train_stream, NUM_LAYERS, ARCHITECTURE,
+        population_size, NUM_GENERATIONS, fitness_samples, mutation_rate,
+        mutation_chance, resumed, resume_path, ridge_seed, ridge_lambda,
+        master_address, dispatch_batch, checkpoint_path, checkpoint_every,
+        projection, NETWORK_FILE, PROJECTION_FILE);
+    break;
+  }
+
+  // --- 3. Cleanup ---
+  free_evolution_state(resumed);
+  free_dataset(train_dataset);
+  close_dataset_stream(train_stream);
+  free_projection(projection);
+  return status;
 }
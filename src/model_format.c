@@ -0,0 +1,403 @@
+#include "model_format.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// --- CRC-32 ---
+
+// Built on first use; the checkpoint writer thread and the main thread can
+// both get there first
+static uint32_t crc_table[256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void init_crc_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t size) {
+    pthread_once(&crc_table_once, init_crc_table);
+    const unsigned char* bytes = (const unsigned char*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = crc_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// --- Layout ---
+
+static uint64_t align_up(uint64_t offset) {
+    return (offset + MODEL_ALIGNMENT - 1) & ~(uint64_t)(MODEL_ALIGNMENT - 1);
+}
+
+// Computes where each block lives; either offset array may be NULL
+uint64_t model_layout(int num_layers, const int* architecture,
+                      uint64_t* weight_offsets, uint64_t* bias_offsets) {
+    uint64_t offset = align_up(sizeof(ModelHeader) + (uint64_t)num_layers * sizeof(int32_t));
+    for (int i = 0; i < num_layers - 1; i++) {
+        if (weight_offsets) weight_offsets[i] = offset;
+        offset = align_up(offset + (uint64_t)architecture[i] * architecture[i + 1] * sizeof(double));
+        if (bias_offsets) bias_offsets[i] = offset;
+        offset = align_up(offset + (uint64_t)architecture[i + 1] * sizeof(double));
+    }
+    return offset;
+}
+
+// --- Detection ---
+
+// Binary files start with the magic; text files start with the layer count
+ModelFormat detect_model_format(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return MODEL_FORMAT_UNKNOWN;
+
+    unsigned char bytes[4] = {0};
+    size_t n = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+
+    uint32_t magic = 0;
+    if (n == sizeof(bytes)) memcpy(&magic, bytes, sizeof(magic));
+    if (magic == MODEL_MAGIC) return MODEL_FORMAT_BINARY;
+    if (magic == QUANTIZED_MODEL_MAGIC) return MODEL_FORMAT_INT8;
+    if (magic == BINARIZED_MODEL_MAGIC) return MODEL_FORMAT_BINARIZED;
+    if (magic == SPARSE_MODEL_MAGIC) return MODEL_FORMAT_SPARSE;
+    if (magic == CODEBOOK_MODEL_MAGIC) return MODEL_FORMAT_CODEBOOK;
+    if (n > 0 && (bytes[0] >= '0' && bytes[0] <= '9')) return MODEL_FORMAT_TEXT;
+    return MODEL_FORMAT_UNKNOWN;
+}
+
+// --- Shared File Helpers ---
+
+int model_write_block(FILE* file, const void* data, size_t size, uint32_t* crc) {
+    if (size == 0) return 1;
+    *crc = crc32_update(*crc, data, size);
+    return fwrite(data, 1, size, file) == size;
+}
+
+int model_read_block(FILE* file, void* data, size_t size, uint32_t* crc) {
+    if (size == 0) return 1;
+    if (fread(data, 1, size, file) != size) return 0;
+    *crc = crc32_update(*crc, data, size);
+    return 1;
+}
+
+int model_write_architecture(FILE* file, int num_layers, const int* architecture, uint32_t* crc) {
+    int ok = 1;
+    for (int i = 0; ok && i < num_layers; i++) {
+        int32_t size = architecture[i];
+        ok = model_write_block(file, &size, sizeof(size), crc);
+    }
+    return ok;
+}
+
+int* model_read_architecture(FILE* file, int num_layers, uint32_t* crc) {
+    int* architecture = (int*)malloc(num_layers * sizeof(int));
+    int ok = architecture != NULL;
+    for (int i = 0; ok && i < num_layers; i++) {
+        int32_t size;
+        ok = model_read_block(file, &size, sizeof(size), crc) && size > 0;
+        if (ok) architecture[i] = size;
+    }
+    if (!ok) {
+        free(architecture);
+        return NULL;
+    }
+    return architecture;
+}
+
+void model_header_init(ModelHeader* header, uint32_t magic, uint8_t dtype, int num_layers, uint64_t file_size) {
+    memset(header, 0, sizeof(*header));
+    header->magic = magic;
+    header->version = MODEL_VERSION;
+    header->dtype = dtype;
+    header->endian_marker = MODEL_ENDIAN_MARKER;
+    header->num_layers = (uint32_t)num_layers;
+    header->file_size = file_size;
+}
+
+int model_write_header(FILE* file, const ModelHeader* header) {
+    return fseek(file, 0, SEEK_SET) == 0 && fwrite(header, sizeof(*header), 1, file) == 1;
+}
+
+int model_header_valid(const ModelHeader* header, uint32_t magic, uint8_t dtype) {
+    return header->magic == magic && header->endian_marker == MODEL_ENDIAN_MARKER &&
+           header->version == MODEL_VERSION && header->dtype == dtype &&
+           header->num_layers >= 2 && header->num_layers <= 1024;
+}
+
+int model_read_header(FILE* file, ModelHeader* header, uint32_t magic, uint8_t dtype) {
+    return fread(header, sizeof(*header), 1, file) == 1 && model_header_valid(header, magic, dtype);
+}
+
+FILE* model_create_file(const char* filepath, char** tmp_path) {
+    size_t path_len = strlen(filepath);
+    *tmp_path = (char*)malloc(path_len + 5);
+    if (!*tmp_path) return NULL;
+    memcpy(*tmp_path, filepath, path_len);
+    memcpy(*tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(*tmp_path, "wb");
+    if (!file) {
+        perror("Failed to open file for writing");
+        free(*tmp_path);
+        *tmp_path = NULL;
+    }
+    return file;
+}
+
+int model_commit_file(FILE* file, char* tmp_path, const char* filepath, int ok) {
+    if (fclose(file) != 0) ok = 0;
+    if (ok) ok = rename(tmp_path, filepath) == 0;
+    if (!ok) remove(tmp_path);
+    free(tmp_path);
+    return ok;
+}
+
+// --- Writing ---
+
+// Pads the file with zeros up to `offset`
+static int pad_to(FILE* file, uint64_t* position, uint64_t offset, uint32_t* crc) {
+    static const unsigned char zeros[MODEL_ALIGNMENT] = {0};
+    size_t gap = (size_t)(offset - *position);
+    *position = offset;
+    return model_write_block(file, zeros, gap, crc);
+}
+
+// The file is written under a temporary name and renamed into place, so a
+// reader that has the old file mapped keeps its pages instead of faulting.
+int save_network_binary(const NeuralNetwork* net, const char* filepath) {
+    int num_layers = net->num_layers;
+    uint64_t* weight_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    uint64_t* bias_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    char* tmp_path = NULL;
+    FILE* file = weight_offsets && bias_offsets ? model_create_file(filepath, &tmp_path) : NULL;
+    if (!file) {
+        free(weight_offsets);
+        free(bias_offsets);
+        return 0; // Failure
+    }
+
+    ModelHeader header;
+    model_header_init(&header, MODEL_MAGIC, MODEL_DTYPE_FLOAT64, num_layers,
+                      model_layout(num_layers, net->architecture, weight_offsets, bias_offsets));
+
+    // The header is written twice: once as a placeholder, then with the CRC
+    int ok = model_write_header(file, &header);
+    uint32_t crc = 0;
+    uint64_t position = sizeof(header);
+
+    ok = ok && model_write_architecture(file, num_layers, net->architecture, &crc);
+    position += num_layers * sizeof(int32_t);
+
+    // Weights and biases are contiguous in memory, so each block is one write
+    for (int i = 0; ok && i < num_layers - 1; i++) {
+        size_t weight_bytes = (size_t)net->weights[i]->rows * net->weights[i]->cols * sizeof(double);
+        size_t bias_bytes = (size_t)net->biases[i]->cols * sizeof(double);
+        ok = pad_to(file, &position, weight_offsets[i], &crc) &&
+             model_write_block(file, net->weights[i]->data[0], weight_bytes, &crc);
+        position += weight_bytes;
+        ok = ok && pad_to(file, &position, bias_offsets[i], &crc) &&
+             model_write_block(file, net->biases[i]->data[0], bias_bytes, &crc);
+        position += bias_bytes;
+    }
+    ok = ok && pad_to(file, &position, header.file_size, &crc);
+
+    header.crc32 = crc;
+    ok = ok && model_write_header(file, &header);
+
+    free(weight_offsets);
+    free(bias_offsets);
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+// --- Reading ---
+
+// Consumes padding up to `offset`
+static int skip_to(FILE* file, uint64_t* position, uint64_t offset, uint32_t* crc) {
+    unsigned char padding[MODEL_ALIGNMENT];
+    size_t gap = (size_t)(offset - *position);
+    *position = offset;
+    return model_read_block(file, padding, gap, crc);
+}
+
+NeuralNetwork* load_network_binary(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    ModelHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!model_read_header(file, &header, MODEL_MAGIC, MODEL_DTYPE_FLOAT64)) {
+        if (header.magic == MODEL_MAGIC && header.endian_marker != MODEL_ENDIAN_MARKER) {
+            fprintf(stderr, "%s was written on a host with a different byte order.\n", filepath);
+        } else {
+            fprintf(stderr, "%s is not a supported binary model file.\n", filepath);
+        }
+        fclose(file);
+        return NULL;
+    }
+    // A truncated or forged header must not drive the allocation below
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 || (uint64_t)st.st_size != header.file_size) {
+        fprintf(stderr, "Model file %s has an inconsistent size.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = (int)header.num_layers;
+    uint32_t crc = 0;
+    uint64_t position = sizeof(header) + num_layers * sizeof(int32_t);
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    uint64_t* weight_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    uint64_t* bias_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    NeuralNetwork* net = NULL;
+    int ok = architecture && weight_offsets && bias_offsets;
+
+    if (ok && model_layout(num_layers, architecture, weight_offsets, bias_offsets) != header.file_size) {
+        fprintf(stderr, "Model file %s has an inconsistent size.\n", filepath);
+        ok = 0;
+    }
+    if (ok) {
+        net = create_zeroed_network(num_layers, architecture);
+        ok = net != NULL;
+    }
+
+    // Each block is read straight into the contiguous matrix storage
+    for (int i = 0; ok && i < num_layers - 1; i++) {
+        size_t weight_bytes = (size_t)net->weights[i]->rows * net->weights[i]->cols * sizeof(double);
+        size_t bias_bytes = (size_t)net->biases[i]->cols * sizeof(double);
+        ok = skip_to(file, &position, weight_offsets[i], &crc) &&
+             model_read_block(file, net->weights[i]->data[0], weight_bytes, &crc);
+        position += weight_bytes;
+        ok = ok && skip_to(file, &position, bias_offsets[i], &crc) &&
+             model_read_block(file, net->biases[i]->data[0], bias_bytes, &crc);
+        position += bias_bytes;
+    }
+    ok = ok && skip_to(file, &position, header.file_size, &crc);
+
+    if (ok && crc != header.crc32) {
+        fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+        ok = 0;
+    }
+
+    fclose(file);
+    free(architecture);
+    free(weight_offsets);
+    free(bias_offsets);
+    if (!ok) {
+        free_neural_network(net);
+        return NULL;
+    }
+    return net;
+}
+
+// --- Memory Mapping ---
+
+// Maps a binary model file; matrices point straight into the mapping
+MappedNetwork* map_network(const char* filepath, int verify_checksum) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ModelHeader)) {
+        fprintf(stderr, "%s is not a binary model file.\n", filepath);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (mapping == MAP_FAILED) {
+        perror("Failed to map model file");
+        return NULL;
+    }
+
+    const ModelHeader* header = (const ModelHeader*)mapping;
+    int num_layers = (int)header->num_layers;
+    if (!model_header_valid(header, MODEL_MAGIC, MODEL_DTYPE_FLOAT64) || header->file_size != size ||
+        sizeof(ModelHeader) + (size_t)num_layers * sizeof(int32_t) > size) {
+        fprintf(stderr, "%s is not a valid binary model file.\n", filepath);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    const int32_t* stored = (const int32_t*)((const char*)mapping + sizeof(ModelHeader));
+    MappedNetwork* mapped = (MappedNetwork*)calloc(1, sizeof(MappedNetwork));
+    NeuralNetwork* net = (NeuralNetwork*)calloc(1, sizeof(NeuralNetwork));
+    uint64_t* weight_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    uint64_t* bias_offsets = (uint64_t*)malloc(num_layers * sizeof(uint64_t));
+    int ok = mapped && net && weight_offsets && bias_offsets;
+    if (ok) {
+        net->num_layers = num_layers;
+        net->architecture = (int*)malloc(num_layers * sizeof(int));
+        net->weights = (Matrix**)calloc(num_layers - 1, sizeof(Matrix*));
+        net->biases = (Matrix**)calloc(num_layers - 1, sizeof(Matrix*));
+        ok = net->architecture && net->weights && net->biases;
+    }
+    for (int i = 0; ok && i < num_layers; i++) {
+        net->architecture[i] = stored[i];
+        if (stored[i] <= 0) ok = 0;
+    }
+    if (ok && model_layout(num_layers, net->architecture, weight_offsets, bias_offsets) != size) {
+        fprintf(stderr, "Model file %s has an inconsistent size.\n", filepath);
+        ok = 0;
+    }
+    if (ok && verify_checksum) {
+        uint32_t crc = crc32_update(0, (const char*)mapping + sizeof(ModelHeader), size - sizeof(ModelHeader));
+        if (crc != header->crc32) {
+            fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+            ok = 0;
+        }
+    }
+
+    // Only the row pointer tables are allocated; parameters stay in the mapping
+    char* base = (char*)mapping;
+    for (int i = 0; ok && i < num_layers - 1; i++) {
+        net->weights[i] = create_matrix_view(net->architecture[i], net->architecture[i + 1],
+                                             (double*)(base + weight_offsets[i]));
+        net->biases[i] = create_matrix_view(1, net->architecture[i + 1], (double*)(base + bias_offsets[i]));
+        ok = net->weights[i] && net->biases[i];
+    }
+
+    free(weight_offsets);
+    free(bias_offsets);
+    if (!ok) {
+        if (net) {
+            for (int i = 0; net->weights && net->biases && i < num_layers - 1; i++) {
+                free_matrix(net->weights[i]);
+                free_matrix(net->biases[i]);
+            }
+            free(net->weights);
+            free(net->biases);
+            free(net->architecture);
+            free(net);
+        }
+        free(mapped);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    mapped->net = net;
+    mapped->mapping = mapping;
+    mapped->mapping_size = size;
+    return mapped;
+}
+
+// Releases the matrix views and unmaps the file
+void unmap_network(MappedNetwork* mapped) {
+    if (!mapped) return;
+    // free_neural_network only frees view headers, never the mapped parameters
+    free_neural_network(mapped->net);
+    munmap(mapped->mapping, mapped->mapping_size);
+    free(mapped);
+}
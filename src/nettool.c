@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neural_network.h"
+#include "codegen.h"
+#include "quantization.h"
+#include "sparse_network.h"
+#include "codebook.h"
+
+// --- Commands ---
+
+// Turns a saved network into a standalone C source file and header
+static int command_compile(int argc, char* argv[]) {
+    const char* network_filepath = NULL;
+    const char* name = "compiled_network";
+    const char* out_dir = "generated";
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) name = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out_dir = argv[++i];
+        else if (!network_filepath && argv[i][0] != '-') network_filepath = argv[i];
+        else {
+            fprintf(stderr, "Unknown compile option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!network_filepath) network_filepath = "trained_network.dat";
+
+    NeuralNetwork* net = load_network(network_filepath);
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", network_filepath);
+        return 1;
+    }
+
+    char source_path[1024];
+    char header_path[1024];
+    snprintf(source_path, sizeof(source_path), "%s/%s.c", out_dir, name);
+    snprintf(header_path, sizeof(header_path), "%s/%s.h", out_dir, name);
+    int ok = compile_network_source(net, name, source_path, header_path);
+    if (ok) {
+        printf("Compiled %s into %s and %s\n", network_filepath, source_path, header_path);
+    } else {
+        fprintf(stderr, "Failed to compile %s.\n", network_filepath);
+    }
+
+    free_neural_network(net);
+    return ok ? 0 : 1;
+}
+
+// Converts a saved network to per-channel symmetric int8 weights
+static int command_quantize(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "quantize needs an input and an output file.\n");
+        return 1;
+    }
+    NeuralNetwork* net = load_network(argv[0]);
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", argv[0]);
+        return 1;
+    }
+    QuantizedNetwork* qnet = quantize_network(net);
+    int ok = qnet && save_quantized_network(qnet, argv[1]);
+    if (ok) {
+        size_t float_size = 0;
+        for (int i = 0; i < net->num_layers - 1; i++) {
+            float_size += ((size_t)net->architecture[i] + 1) * net->architecture[i + 1] * sizeof(double);
+        }
+        printf("Quantized %s into %s: %zu -> %zu bytes of parameters (%.1fx smaller)\n", argv[0], argv[1],
+               float_size, quantized_network_size(qnet), (double)float_size / quantized_network_size(qnet));
+    } else {
+        fprintf(stderr, "Failed to quantize %s.\n", argv[0]);
+    }
+
+    free_quantized_network(qnet);
+    free_neural_network(net);
+    return ok ? 0 : 1;
+}
+
+// Zeroes the smallest weights and writes the survivors in CSR form
+static int command_prune(int argc, char* argv[]) {
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    double sparsity = -1.0;
+    PruneScope scope = PRUNE_GLOBAL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--sparsity") == 0 && i + 1 < argc) sparsity = atof(argv[++i]);
+        else if (strcmp(argv[i], "--per-layer") == 0) scope = PRUNE_PER_LAYER;
+        else if (!input_path && argv[i][0] != '-') input_path = argv[i];
+        else if (!output_path && argv[i][0] != '-') output_path = argv[i];
+        else {
+            fprintf(stderr, "Unknown prune option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!input_path || !output_path || sparsity < 0.0 || sparsity > 1.0) {
+        fprintf(stderr, "prune needs an input file, an output file and --sparsity between 0 and 1.\n");
+        return 1;
+    }
+
+    NeuralNetwork* net = load_network(input_path);
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", input_path);
+        return 1;
+    }
+    double achieved = prune_network(net, sparsity, scope);
+    int ok = attach_sparse_weights(net) && save_network_sparse(net, output_path);
+    if (ok) {
+        for (int l = 0; l < net->num_layers - 1; l++) {
+            const CsrMatrix* csr = &net->sparse->layers[l];
+            printf("Layer %d [%d -> %d]: %d of %d weights kept (%.1f%% zero)\n", l, csr->cols, csr->rows,
+                   csr->nnz, csr->rows * csr->cols, 100.0 - 100.0 * csr->nnz / ((double)csr->rows * csr->cols));
+        }
+        printf("Pruned %s into %s: %.1f%% of weights zero (%s), %zu nonzero\n", input_path, output_path,
+               100.0 * achieved, scope == PRUNE_PER_LAYER ? "per layer" : "global",
+               sparse_weights_nnz(net->sparse));
+    } else {
+        fprintf(stderr, "Failed to write %s.\n", output_path);
+    }
+
+    free_neural_network(net);
+    return ok ? 0 : 1;
+}
+
+// Shares each layer's weights through a k-means codebook of K centroids
+static int command_compress(int argc, char* argv[]) {
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    int num_centroids = CODEBOOK_MIN_CENTROIDS;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--centroids") == 0 && i + 1 < argc) num_centroids = atoi(argv[++i]);
+        else if (!input_path && argv[i][0] != '-') input_path = argv[i];
+        else if (!output_path && argv[i][0] != '-') output_path = argv[i];
+        else {
+            fprintf(stderr, "Unknown compress option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!input_path || !output_path) {
+        fprintf(stderr, "compress needs an input and an output file.\n");
+        return 1;
+    }
+
+    NeuralNetwork* net = load_network(input_path);
+    if (!net) {
+        fprintf(stderr, "Failed to load network from %s.\n", input_path);
+        return 1;
+    }
+    CodebookNetwork* cnet = compress_network(net, num_centroids);
+    int ok = cnet && save_codebook_network(cnet, output_path);
+    if (ok) {
+        size_t float_size = 0;
+        for (int i = 0; i < net->num_layers - 1; i++) {
+            float_size += ((size_t)net->architecture[i] + 1) * net->architecture[i + 1] * sizeof(double);
+        }
+        printf("Compressed %s into %s with %d centroids per layer: %zu -> %zu bytes of parameters "
+               "(%.1fx smaller), weight RMS error %.5f\n",
+               input_path, output_path, num_centroids, float_size, codebook_network_size(cnet),
+               (double)float_size / codebook_network_size(cnet), codebook_weight_error(cnet, net));
+    } else {
+        fprintf(stderr, "Failed to compress %s.\n", input_path);
+    }
+
+    free_codebook_network(cnet);
+    free_neural_network(net);
+    return ok ? 0 : 1;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s <command> [options]\n"
+            "Commands:\n"
+            "  compile [network_file] [--name NAME] [--out DIR]\n"
+            "          Generate DIR/NAME.c and DIR/NAME.h (default generated/compiled_network)\n"
+            "  quantize <network_file> <output_file>\n"
+            "          Write an int8 model that recognizer evaluates directly\n"
+            "  prune <network_file> <output_file> --sparsity S [--per-layer]\n"
+            "          Zero the smallest S of the weights and write a sparse CSR model\n"
+            "  compress <network_file> <output_file> [--centroids K]\n"
+            "          Share weights through a K-entry codebook per layer (16-256, default 16)\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "compile") == 0) return command_compile(argc - 2, argv + 2);
+    if (strcmp(argv[1], "quantize") == 0) return command_quantize(argc - 2, argv + 2);
+    if (strcmp(argv[1], "prune") == 0) return command_prune(argc - 2, argv + 2);
+    if (strcmp(argv[1], "compress") == 0) return command_compress(argc - 2, argv + 2);
+
+    print_usage(argv[0]);
+    return 1;
+}
@@ -1,6 +1,10 @@
 #include "neural_network.h"
+#include "model_format.h"
+#include "specialized_forward.h"
+#include "sparse_network.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 
@@ -13,21 +17,43 @@ Matrix* create_matrix(int rows, int cols) {
 
     m->rows = rows;
     m->cols = cols;
-    m->data = (double**)malloc(rows * sizeof(double*));
+    m->owns_data = 1;
+    m->data = (double**)malloc((rows > 0 ? rows : 1) * sizeof(double*));
     if (!m->data) {
         free(m);
         return NULL;
     }
+    if (rows == 0) return m;
 
+    // One zeroed block for all rows keeps the matrix contiguous in memory
+    double* block = (double*)calloc((size_t)rows * cols > 0 ? (size_t)rows * cols : 1, sizeof(double));
+    if (!block) {
+        free(m->data);
+        free(m);
+        return NULL;
+    }
     for (int i = 0; i < rows; i++) {
-        m->data[i] = (double*)calloc(cols, sizeof(double));
-        if (!m->data[i]) {
-            // Rollback allocation on failure
-            for (int j = 0; j < i; j++) free(m->data[j]);
-            free(m->data);
-            free(m);
-            return NULL;
-        }
+        m->data[i] = block + (size_t)i * cols;
+    }
+    return m;
+}
+
+// Creates a matrix whose rows point into an existing buffer of rows * cols values.
+// The buffer is not copied and is not freed by free_matrix.
+Matrix* create_matrix_view(int rows, int cols, double* buffer) {
+    Matrix* m = (Matrix*)malloc(sizeof(Matrix));
+    if (!m) return NULL;
+
+    m->rows = rows;
+    m->cols = cols;
+    m->owns_data = 0;
+    m->data = (double**)malloc((rows > 0 ? rows : 1) * sizeof(double*));
+    if (!m->data) {
+        free(m);
+        return NULL;
+    }
+    for (int i = 0; i < rows; i++) {
+        m->data[i] = buffer + (size_t)i * cols;
     }
     return m;
 }
@@ -35,8 +61,8 @@ Matrix* create_matrix(int rows, int cols) {
 // Frees the memory of a matrix
 void free_matrix(Matrix* m) {
     if (!m) return;
-    for (int i = 0; i < m->rows; i++) {
-        free(m->data[i]);
+    if (m->owns_data && m->rows > 0) {
+        free(m->data[0]);
     }
     free(m->data);
     free(m);
@@ -98,8 +124,16 @@ void apply_sigmoid(Matrix* m) {
 
 // Creates and allocates memory for a neural network
 NeuralNetwork* create_neural_network(int num_layers, const int* architecture) {
+    NeuralNetwork* net = create_zeroed_network(num_layers, architecture);
+    if (net) initialize_network(net);
+    return net;
+}
+
+// Allocates a network whose weights and biases are all zero
+NeuralNetwork* create_zeroed_network(int num_layers, const int* architecture) {
     NeuralNetwork* net = (NeuralNetwork*)malloc(sizeof(NeuralNetwork));
     net->num_layers = num_layers;
+    net->sparse = NULL;
     net->architecture = (int*)malloc(num_layers * sizeof(int));
     for(int i=0; i<num_layers; i++) net->architecture[i] = architecture[i];
 
@@ -111,8 +145,6 @@ NeuralNetwork* create_neural_network(int num_layers, const int* architecture) {
         net->biases[i] = create_matrix(1, architecture[i+1]);
     }
 
-    initialize_network(net);
-
     return net;
 }
 
@@ -146,6 +178,7 @@ void free_neural_network(NeuralNetwork* net) {
     free(net->weights);
     free(net->biases);
     free(net->architecture);
+    free_sparse_weights(net->sparse);
     free(net);
 }
 
@@ -153,6 +186,31 @@ void free_neural_network(NeuralNetwork* net) {
 Matrix* forward_pass(const NeuralNetwork* net, const Matrix* input) {
     if (input->cols != net->architecture[0]) return NULL;
 
+    // Pruned networks only visit their nonzero weights
+    if (net->sparse) {
+        Matrix* output = create_matrix(input->rows, net->architecture[net->num_layers - 1]);
+        double* scratch = (double*)malloc(sparse_scratch_size(net) * sizeof(double));
+        if (!output || !scratch) {
+            free_matrix(output);
+            free(scratch);
+            return NULL;
+        }
+        for (int i = 0; i < input->rows; i++) {
+            sparse_forward(net, input->data[i], output->data[i], scratch);
+        }
+        free(scratch);
+        return output;
+    }
+
+    // Architectures compiled into the registry skip the generic loops
+    ForwardKernel kernel = find_forward_kernel(net->num_layers, net->architecture);
+    if (kernel) {
+        Matrix* output = create_matrix(input->rows, net->architecture[net->num_layers - 1]);
+        if (!output) return NULL;
+        if (input->rows > 0) kernel(net, input->data[0], output->data[0], input->rows);
+        return output;
+    }
+
     Matrix* current_output = create_matrix(input->rows, input->cols);
     for(int i=0; i<input->rows; i++) {
         for(int j=0; j<input->cols; j++) {
@@ -176,6 +234,7 @@ Matrix* forward_pass(const NeuralNetwork* net, const Matrix* input) {
 
 // Mutates the network's parameters
 void mutate_network(NeuralNetwork* net, float mutation_rate, float mutation_chance) {
+    detach_sparse_weights(net);
     // Mutate weights
     for (int i = 0; i < net->num_layers - 1; i++) {
         for (int r = 0; r < net->weights[i]->rows; r++) {
@@ -200,7 +259,9 @@ void mutate_network(NeuralNetwork* net, float mutation_rate, float mutation_chan
 NeuralNetwork* clone_network(const NeuralNetwork* src_net) {
     if (!src_net) return NULL;
 
-    NeuralNetwork* new_net = create_neural_network(src_net->num_layers, src_net->architecture);
+    // Every parameter is overwritten, so there is nothing to initialize
+    NeuralNetwork* new_net = create_zeroed_network(src_net->num_layers, src_net->architecture);
+    if (!new_net) return NULL;
 
     for (int i = 0; i < src_net->num_layers - 1; i++) {
         for (int r = 0; r < src_net->weights[i]->rows; r++) {
@@ -212,11 +273,62 @@ NeuralNetwork* clone_network(const NeuralNetwork* src_net) {
             new_net->biases[i]->data[0][c] = src_net->biases[i]->data[0][c];
         }
     }
+    if (src_net->sparse) attach_sparse_weights(new_net);
 
     return new_net;
 }
 
+// Number of weights and biases in the network
+size_t network_num_params(const NeuralNetwork* net) {
+    size_t count = 0;
+    for (int i = 0; i < net->num_layers - 1; i++) {
+        count += ((size_t)net->architecture[i] + 1) * net->architecture[i + 1];
+    }
+    return count;
+}
+
+// Copies every layer's weights, then its biases, into one flat vector
+void flatten_network(const NeuralNetwork* net, double* params) {
+    for (int i = 0; i < net->num_layers - 1; i++) {
+        size_t weights = (size_t)net->architecture[i] * net->architecture[i + 1];
+        memcpy(params, net->weights[i]->data[0], weights * sizeof(double));
+        params += weights;
+        memcpy(params, net->biases[i]->data[0], net->architecture[i + 1] * sizeof(double));
+        params += net->architecture[i + 1];
+    }
+}
+
+// Inverse of flatten_network. A CSR copy no longer matches, so it is dropped.
+void unflatten_network(NeuralNetwork* net, const double* params) {
+    for (int i = 0; i < net->num_layers - 1; i++) {
+        size_t weights = (size_t)net->architecture[i] * net->architecture[i + 1];
+        memcpy(net->weights[i]->data[0], params, weights * sizeof(double));
+        params += weights;
+        memcpy(net->biases[i]->data[0], params, net->architecture[i + 1] * sizeof(double));
+        params += net->architecture[i + 1];
+    }
+    detach_sparse_weights(net);
+}
+
+// Saves the network in the binary model format
 int save_network(const NeuralNetwork* net, const char* filepath) {
+    return save_network_binary(net, filepath);
+}
+
+// Loads a network in either the binary or the legacy text format
+NeuralNetwork* load_network(const char* filepath) {
+    ModelFormat format = detect_model_format(filepath);
+    if (format == MODEL_FORMAT_BINARY) {
+        return load_network_binary(filepath);
+    }
+    if (format == MODEL_FORMAT_SPARSE) {
+        return load_network_sparse(filepath);
+    }
+    return load_network_text(filepath);
+}
+
+// Saves the network in the legacy text format (one %.17g value per parameter)
+int save_network_text(const NeuralNetwork* net, const char* filepath) {
     FILE* file = fopen(filepath, "w");
     if (!file) {
         perror("Failed to open file for writing");
@@ -250,7 +362,8 @@ int save_network(const NeuralNetwork* net, const char* filepath) {
     return 1; // Success
 }
 
-NeuralNetwork* load_network(const char* filepath) {
+// Loads a network written by save_network_text
+NeuralNetwork* load_network_text(const char* filepath) {
     FILE* file = fopen(filepath, "r");
     if (!file) {
         perror("Failed to open file for reading");
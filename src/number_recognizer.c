@@ -3,96 +3,382 @@
 #include <string.h>
 #include "neural_network.h"
 #include "data_loader.h"
+#include "dataset_stream.h"
+#include "projection.h"
+#include "model_format.h"
+#include "inference.h"
+#include "quantization.h"
+#include "binarized_network.h"
+#include "sparse_network.h"
+#include "codebook.h"
 
-// Helper function to get the predicted class from the network's output
-int get_predicted_class(const Matrix* output) {
-    int max_index = 0;
-    for (int i = 1; i < output->cols; i++) {
-        if (output->data[0][i] > output->data[0][max_index]) {
-            max_index = i;
+#define STREAM_BATCH_SIZE 1024
+
+// Frees a network obtained either from load_network or from map_network
+void release_network(NeuralNetwork* net, MappedNetwork* mapped) {
+    if (mapped) {
+        unmap_network(mapped);
+    } else {
+        free_neural_network(net);
+    }
+}
+
+void print_architecture(int num_layers, const int* architecture) {
+    printf("Network architecture: [");
+    for(int i=0; i<num_layers; i++) {
+        printf("%d%s", architecture[i], i == num_layers - 1 ? "" : ", ");
+    }
+    printf("]\n");
+}
+
+// A projection saved next to the network means it was trained on reduced
+// inputs. Returns 0 if one is needed but missing; *projection stays NULL
+// for networks that take raw pixels.
+int load_input_projection(const char* network_filepath, int input_size, Projection** projection) {
+    *projection = NULL;
+    if (input_size == MNIST_IMAGE_SIZE) return 1;
+
+    char projection_filepath[1024];
+    snprintf(projection_filepath, sizeof(projection_filepath), "%s.proj", network_filepath);
+    Projection* loaded = load_projection(projection_filepath);
+    if (!loaded || loaded->output_size != input_size || loaded->input_size != MNIST_IMAGE_SIZE) {
+        fprintf(stderr, "Network expects %d inputs but no matching projection was found at %s.\n",
+                input_size, projection_filepath);
+        free_projection(loaded);
+        return 0;
+    }
+    printf("Applying %s input projection from %s (%d -> %d).\n",
+           loaded->kind == PROJECTION_PCA ? "PCA" : "random", projection_filepath,
+           loaded->input_size, loaded->output_size);
+    *projection = loaded;
+    return 1;
+}
+
+// Loads the MNIST test set and applies the projection, if any. Takes
+// ownership of the projection.
+Dataset* load_test_dataset(Projection* projection) {
+    printf("Loading MNIST test data...\n");
+    Dataset* test_dataset = load_mnist_dataset_cached("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte", "data/t10k.cache");
+    if (!test_dataset) {
+        fprintf(stderr, "Failed to load the MNIST test dataset.\n");
+        free_projection(projection);
+        return NULL;
+    }
+    printf("Test data loaded: %d images.\n", test_dataset->num_items);
+
+    if (projection) {
+        Dataset* projected = project_dataset(projection, test_dataset);
+        free_dataset(test_dataset);
+        free_projection(projection);
+        if (!projected) {
+            fprintf(stderr, "Failed to project the test dataset.\n");
+            return NULL;
         }
+        test_dataset = projected;
     }
-    return max_index;
+    return test_dataset;
 }
 
-// Helper function to get the true class from the one-hot encoded label
-int get_true_class(const double* label_row) {
-    for (int i = 0; i < MNIST_NUM_CLASSES; i++) {
-        if (label_row[i] == 1.0) {
-            return i;
+// Counts correct int8 predictions over the test set
+int evaluate_quantized(QuantizedNetwork* qnet, const Dataset* test_dataset) {
+    int correct_predictions = 0;
+    for (int i = 0; i < test_dataset->num_items; i++) {
+        if (quantized_predict(qnet, test_dataset->images->data[i]) == test_dataset->label_indices[i]) {
+            correct_predictions++;
         }
     }
-    return -1; // Should not happen
+    return correct_predictions;
+}
+
+void print_accuracy(const char* label, int correct_predictions, int num_items) {
+    printf("%s: %.2f%% (%d/%d correct)\n", label,
+           100.0 * correct_predictions / num_items, correct_predictions, num_items);
+}
+
+// Scores a model file that was already quantized with `nettool quantize`
+int run_quantized_model(const char* network_filepath) {
+    QuantizedNetwork* qnet = load_quantized_network(network_filepath);
+    if (!qnet) {
+        fprintf(stderr, "Failed to load quantized network from %s.\n", network_filepath);
+        return 1;
+    }
+    printf("Quantized network loaded (%zu bytes of parameters, %s kernel).\n",
+           quantized_network_size(qnet), quantized_kernel_name());
+    print_architecture(qnet->num_layers, qnet->architecture);
+
+    Projection* projection = NULL;
+    Dataset* test_dataset = NULL;
+    if (load_input_projection(network_filepath, qnet->architecture[0], &projection)) {
+        test_dataset = load_test_dataset(projection);
+    }
+    if (!test_dataset) {
+        free_quantized_network(qnet);
+        return 1;
+    }
+
+    printf("Evaluating int8 network accuracy...\n");
+    int correct_predictions = evaluate_quantized(qnet, test_dataset);
+    printf("----------------------------------\n");
+    print_accuracy("Final Accuracy on Test Set (int8)", correct_predictions, test_dataset->num_items);
+    printf("----------------------------------\n");
+
+    free_quantized_network(qnet);
+    free_dataset(test_dataset);
+    return 0;
+}
+
+// Scores a model compressed with `nettool compress`
+int run_codebook_model(const char* network_filepath) {
+    CodebookNetwork* cnet = load_codebook_network(network_filepath);
+    if (!cnet) {
+        fprintf(stderr, "Failed to load codebook network from %s.\n", network_filepath);
+        return 1;
+    }
+    printf("Codebook network loaded (%zu bytes of parameters, %s kernel).\n",
+           codebook_network_size(cnet), codebook_kernel_name());
+    print_architecture(cnet->num_layers, cnet->architecture);
+
+    Projection* projection = NULL;
+    Dataset* test_dataset = NULL;
+    if (load_input_projection(network_filepath, cnet->architecture[0], &projection)) {
+        test_dataset = load_test_dataset(projection);
+    }
+    if (!test_dataset) {
+        free_codebook_network(cnet);
+        return 1;
+    }
+
+    printf("Evaluating codebook network accuracy...\n");
+    int correct_predictions = 0;
+    for (int i = 0; i < test_dataset->num_items; i++) {
+        if (codebook_predict(cnet, test_dataset->images->data[i]) == test_dataset->label_indices[i]) {
+            correct_predictions++;
+        }
+    }
+    printf("----------------------------------\n");
+    print_accuracy("Final Accuracy on Test Set (codebook)", correct_predictions, test_dataset->num_items);
+    printf("----------------------------------\n");
+
+    free_codebook_network(cnet);
+    free_dataset(test_dataset);
+    return 0;
+}
+
+// Scores a binarized model on the thresholded, bit-packed test set
+int run_binarized_model(const char* network_filepath) {
+    BinarizedNetwork* net = load_binarized_network(network_filepath);
+    if (!net) {
+        fprintf(stderr, "Failed to load binarized network from %s.\n", network_filepath);
+        return 1;
+    }
+    printf("Binarized network loaded (%zu bytes of parameters, %s kernel).\n",
+           binarized_network_size(net), binarized_kernel_name());
+    print_architecture(net->num_layers, net->architecture);
+    if (net->architecture[0] != MNIST_IMAGE_SIZE) {
+        fprintf(stderr, "Binarized networks take %d thresholded pixels, not %d inputs.\n",
+                MNIST_IMAGE_SIZE, net->architecture[0]);
+        free_binarized_network(net);
+        return 1;
+    }
+
+    printf("Loading binarized MNIST test data...\n");
+    BitDataset* test_dataset = load_mnist_binarized("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte",
+                                                    0, -1, MNIST_BINARIZE_THRESHOLD);
+    uint64_t* scratch = (uint64_t*)malloc(binarized_scratch_words(net) * sizeof(uint64_t));
+    if (!test_dataset || !scratch) {
+        fprintf(stderr, "Failed to load the MNIST test dataset.\n");
+        free(scratch);
+        free_bit_dataset(test_dataset);
+        free_binarized_network(net);
+        return 1;
+    }
+    printf("Test data loaded: %d images.\n", test_dataset->num_items);
+
+    printf("Evaluating binarized network accuracy...\n");
+    int correct_predictions = 0;
+    for (int i = 0; i < test_dataset->num_items; i++) {
+        const uint64_t* input = test_dataset->bits + (size_t)i * test_dataset->words_per_item;
+        if (binarized_predict(net, input, scratch) == test_dataset->label_indices[i]) {
+            correct_predictions++;
+        }
+    }
+    printf("----------------------------------\n");
+    print_accuracy("Final Accuracy on Test Set (binarized)", correct_predictions, test_dataset->num_items);
+    printf("----------------------------------\n");
+
+    free(scratch);
+    free_bit_dataset(test_dataset);
+    free_binarized_network(net);
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     printf("--- MNIST Number Recognizer ---\n");
 
-    const char* network_filepath = "trained_network.dat";
-    if (argc > 1) {
-        network_filepath = argv[1];
+    const char* network_filepath = NULL;
+    int use_stream = 0;
+    int verify_checksum = 0;
+    int top_k = 0;
+    int use_int8 = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            use_stream = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify_checksum = 1;
+        } else if (strcmp(argv[i], "--top-k") == 0 && i + 1 < argc) {
+            top_k = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--int8") == 0) {
+            use_int8 = 1;
+        } else if (!network_filepath && argv[i][0] != '-') {
+            network_filepath = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--stream] [--verify] [--top-k K] [--int8] [network_file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (network_filepath) {
         printf("Loading network from specified file: %s\n", network_filepath);
     } else {
+        network_filepath = "trained_network.dat";
         printf("Loading network from default file: %s\n", network_filepath);
     }
 
-    // 1. Load the pre-trained network
-    NeuralNetwork* net = load_network(network_filepath);
+    // 1. Load the pre-trained network. Binary models are mapped in place
+    // instead of being copied into freshly allocated matrices; --verify also
+    // checks their CRC, which reads the whole file up front.
+    MappedNetwork* mapped = NULL;
+    NeuralNetwork* net = NULL;
+    ModelFormat format = detect_model_format(network_filepath);
+    if (format == MODEL_FORMAT_INT8) {
+        return run_quantized_model(network_filepath);
+    } else if (format == MODEL_FORMAT_BINARIZED) {
+        return run_binarized_model(network_filepath);
+    } else if (format == MODEL_FORMAT_CODEBOOK) {
+        return run_codebook_model(network_filepath);
+    } else if (format == MODEL_FORMAT_BINARY) {
+        mapped = map_network(network_filepath, verify_checksum);
+        if (mapped) net = mapped->net;
+    } else {
+        net = load_network(network_filepath);
+    }
     if (!net) {
         fprintf(stderr, "Failed to load network from %s. Please train a model first by running './main'.\n", network_filepath);
         return 1;
     }
     printf("Network loaded successfully.\n");
-    printf("Network architecture: [");
-    for(int i=0; i<net->num_layers; i++) {
-        printf("%d%s", net->architecture[i], i == net->num_layers - 1 ? "" : ", ");
+    print_architecture(net->num_layers, net->architecture);
+    if (net->sparse) {
+        printf("Pruned network: %.1f%% of weights are zero, %zu nonzero (CSR kernels).\n",
+               100.0 * network_sparsity(net), sparse_weights_nnz(net->sparse));
+    }
+
+    Projection* projection = NULL;
+    if (!load_input_projection(network_filepath, net->architecture[0], &projection)) {
+        release_network(net, mapped);
+        return 1;
+    }
+    if (use_stream && (projection || use_int8)) {
+        fprintf(stderr, "--stream does not support projected or int8 networks; evaluating in memory.\n");
+        use_stream = 0;
     }
-    printf("]\n");
 
     // 2. Load the MNIST test dataset
-    printf("Loading MNIST test data...\n");
-    Dataset* test_dataset = load_mnist_dataset("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    if (use_stream) {
+        // Score the test set batch by batch without loading it into memory
+        DatasetStream* test_stream = open_dataset_stream("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte", STREAM_BATCH_SIZE);
+        if (!test_stream) {
+            fprintf(stderr, "Failed to open the MNIST test dataset.\n");
+            release_network(net, mapped);
+            return 1;
+        }
+        printf("Evaluating network accuracy on streamed test data...\n");
+        int num_items = dataset_stream_num_items(test_stream);
+        double accuracy = stream_accuracy(net, test_stream, 0);
+        printf("----------------------------------\n");
+        printf("Final Accuracy on Test Set: %.2f%% (%d/%d correct)\n",
+               accuracy * 100.0, (int)(accuracy * num_items + 0.5), num_items);
+        printf("----------------------------------\n");
+        close_dataset_stream(test_stream);
+        release_network(net, mapped);
+        return 0;
+    }
+
+    Dataset* test_dataset = load_test_dataset(projection);
     if (!test_dataset) {
-        fprintf(stderr, "Failed to load the MNIST test dataset.\n");
-        free_neural_network(net);
+        release_network(net, mapped);
         return 1;
     }
-    printf("Test data loaded: %d images.\n", test_dataset->num_items);
 
-    // 3. Evaluate the network on the test dataset
+    // 3. Evaluate the network on the test dataset, one image at a time
+    // through the allocation-free packed path. Pruned networks go through
+    // the CSR kernels instead, which skip the zero weights.
+    PackedNetwork* packed = pack_network(net);
+    double* sparse_scratch = net->sparse ? (double*)malloc(sparse_scratch_size(net) * sizeof(double)) : NULL;
+    if (!packed || (net->sparse && !sparse_scratch)) {
+        fprintf(stderr, "Failed to pack the network for inference.\n");
+        free_packed_network(packed);
+        free(sparse_scratch);
+        release_network(net, mapped);
+        free_dataset(test_dataset);
+        return 1;
+    }
     printf("Evaluating network accuracy...\n");
     int correct_predictions = 0;
+    int top_k_hits = 0;
+    int top_classes[MNIST_NUM_CLASSES];
+    if (top_k > MNIST_NUM_CLASSES) top_k = MNIST_NUM_CLASSES;
     for (int i = 0; i < test_dataset->num_items; i++) {
-        Matrix* input = create_matrix(1, MNIST_IMAGE_SIZE);
-        if (!input) continue;
-        memcpy(input->data[0], test_dataset->images->data[i], MNIST_IMAGE_SIZE * sizeof(double));
-
-        Matrix* output = forward_pass(net, input);
-        if (!output) {
-            free_matrix(input);
-            continue;
-        }
-
-        int predicted_class = get_predicted_class(output);
-        int true_class = get_true_class(test_dataset->labels->data[i]);
-
-        if (predicted_class == true_class) {
+        const double* image = test_dataset->images->data[i];
+        int true_class = test_dataset->label_indices[i];
+        if (top_k > 1) {
+            // The first of the top k is the argmax, so one pass gives both scores
+            int count = predict_top_k(packed, image, top_k, top_classes, NULL);
+            if (top_classes[0] == true_class) correct_predictions++;
+            for (int j = 0; j < count; j++) {
+                if (top_classes[j] == true_class) {
+                    top_k_hits++;
+                    break;
+                }
+            }
+        } else if (sparse_scratch) {
+            if (sparse_predict(net, image, sparse_scratch) == true_class) correct_predictions++;
+        } else if (predict_class(packed, image) == true_class) {
             correct_predictions++;
         }
-
-        free_matrix(input);
-        free_matrix(output);
     }
+    free_packed_network(packed);
+    free(sparse_scratch);
 
     // 4. Calculate and print the final accuracy
     double accuracy = (double)correct_predictions / test_dataset->num_items;
     printf("----------------------------------\n");
     printf("Final Accuracy on Test Set: %.2f%% (%d/%d correct)\n",
            accuracy * 100.0, correct_predictions, test_dataset->num_items);
+    if (top_k > 1) {
+        printf("Top-%d Accuracy on Test Set: %.2f%% (%d/%d)\n", top_k,
+               100.0 * top_k_hits / test_dataset->num_items, top_k_hits, test_dataset->num_items);
+    }
+
+    // With --int8 the same network is quantized in memory and scored again
+    // so the cost of quantization is visible
+    if (use_int8) {
+        QuantizedNetwork* qnet = quantize_network(net);
+        if (!qnet) {
+            fprintf(stderr, "Failed to quantize the network.\n");
+        } else {
+            int int8_correct = evaluate_quantized(qnet, test_dataset);
+            print_accuracy("Final Accuracy on Test Set (int8)", int8_correct, test_dataset->num_items);
+            printf("int8 accuracy delta: %+.2f points (%+d correct), %s kernel\n",
+                   100.0 * (int8_correct - correct_predictions) / test_dataset->num_items,
+                   int8_correct - correct_predictions, quantized_kernel_name());
+            free_quantized_network(qnet);
+        }
+    }
     printf("----------------------------------\n");
 
     // 5. Cleanup
-    free_neural_network(net);
+    release_network(net, mapped);
     free_dataset(test_dataset);
 
     return 0;
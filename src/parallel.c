@@ -0,0 +1,61 @@
+#include "parallel.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_THREADS 64
+
+typedef struct {
+    int begin;
+    int end;
+    ParallelBody body;
+    void* context;
+} ParallelSlice;
+
+static void* run_slice(void* arg) {
+    ParallelSlice* slice = (ParallelSlice*)arg;
+    slice->body(slice->begin, slice->end, slice->context);
+    return NULL;
+}
+
+// Number of worker threads to use
+int parallel_num_threads(void) {
+    const char* env = getenv("GENNET_THREADS");
+    long threads = env ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    return (int)threads;
+}
+
+// Runs body over [0, count) split into one contiguous slice per thread.
+// The calling thread processes the first slice itself.
+void parallel_for(int count, int min_chunk, ParallelBody body, void* context) {
+    if (count <= 0) return;
+    if (min_chunk < 1) min_chunk = 1;
+
+    int threads = parallel_num_threads();
+    if (threads > count / min_chunk) threads = count / min_chunk;
+    if (threads <= 1) {
+        body(0, count, context);
+        return;
+    }
+
+    ParallelSlice slices[MAX_THREADS];
+    pthread_t handles[MAX_THREADS];
+    int started[MAX_THREADS] = {0};
+    for (int t = 0; t < threads; t++) {
+        slices[t].begin = (int)((long)count * t / threads);
+        slices[t].end = (int)((long)count * (t + 1) / threads);
+        slices[t].body = body;
+        slices[t].context = context;
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, run_slice, &slices[t]) == 0;
+        // Fall back to running the slice inline if the thread cannot start
+        if (!started[t]) run_slice(&slices[t]);
+    }
+    run_slice(&slices[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(handles[t], NULL);
+    }
+}
@@ -0,0 +1,300 @@
+#include "projection.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "parallel.h"
+#include "rng.h"
+
+#define PCA_ITERATIONS 60
+
+// Allocates a projection with a zeroed mean and basis
+static Projection* create_projection(int kind, int input_size, int output_size) {
+    Projection* projection = (Projection*)calloc(1, sizeof(Projection));
+    if (!projection) return NULL;
+    projection->kind = kind;
+    projection->input_size = input_size;
+    projection->output_size = output_size;
+    projection->mean = (double*)calloc(input_size, sizeof(double));
+    projection->basis = create_matrix(input_size, output_size);
+    if (!projection->mean || !projection->basis) {
+        free_projection(projection);
+        return NULL;
+    }
+    return projection;
+}
+
+// --- PCA ---
+
+// Shared state of the parallel covariance accumulation. Samples are split
+// into num_partials slices of slice_size items, each with its own accumulator.
+typedef struct {
+    const Dataset* dataset;
+    const double* mean;
+    int dim;
+    int num_samples;
+    int slice_size;
+    double** partials; // Upper-triangular dim x dim accumulator per slice
+} CovarianceJob;
+
+// Accumulates the centered outer products of the samples in slices [begin, end)
+static void accumulate_covariance(int begin, int end, void* context) {
+    CovarianceJob* job = (CovarianceJob*)context;
+    int dim = job->dim;
+    double* centered = (double*)malloc(dim * sizeof(double));
+    if (!centered) return;
+
+    for (int slice = begin; slice < end; slice++) {
+        double* acc = job->partials[slice];
+        int first = slice * job->slice_size;
+        int last = first + job->slice_size < job->num_samples ? first + job->slice_size : job->num_samples;
+        for (int i = first; i < last; i++) {
+            const double* row = job->dataset->images->data[i];
+            for (int j = 0; j < dim; j++) centered[j] = row[j] - job->mean[j];
+            for (int r = 0; r < dim; r++) {
+                double cr = centered[r];
+                double* acc_row = acc + (size_t)r * dim;
+                for (int c = r; c < dim; c++) acc_row[c] += cr * centered[c];
+            }
+        }
+    }
+    free(centered);
+}
+
+// Orthonormalizes the columns of a dim x k column-major block (modified Gram-Schmidt)
+static void orthonormalize(double* q, int dim, int k) {
+    for (int a = 0; a < k; a++) {
+        double* qa = q + (size_t)a * dim;
+        for (int b = 0; b < a; b++) {
+            const double* qb = q + (size_t)b * dim;
+            double dot = 0.0;
+            for (int j = 0; j < dim; j++) dot += qa[j] * qb[j];
+            for (int j = 0; j < dim; j++) qa[j] -= dot * qb[j];
+        }
+        double norm = 0.0;
+        for (int j = 0; j < dim; j++) norm += qa[j] * qa[j];
+        norm = sqrt(norm);
+        if (norm < 1e-12) {
+            // Degenerate direction: restart it from a unit vector
+            memset(qa, 0, dim * sizeof(double));
+            qa[a % dim] = 1.0;
+            continue;
+        }
+        for (int j = 0; j < dim; j++) qa[j] /= norm;
+    }
+}
+
+// Fits the leading principal components by subspace iteration on the sample covariance
+Projection* fit_pca(const Dataset* dataset, int components, int max_samples) {
+    int dim = dataset->images->cols;
+    int n = dataset->num_items;
+    if (max_samples > 0 && max_samples < n) n = max_samples;
+    if (components <= 0 || components > dim || n < 2) {
+        fprintf(stderr, "Invalid PCA configuration (%d components, %d samples).\n", components, n);
+        return NULL;
+    }
+
+    Projection* projection = create_projection(PROJECTION_PCA, dim, components);
+    if (!projection) return NULL;
+
+    // --- Mean ---
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < dim; j++) projection->mean[j] += dataset->images->data[i][j];
+    }
+    for (int j = 0; j < dim; j++) projection->mean[j] /= n;
+
+    // --- Covariance ---
+    int threads = parallel_num_threads();
+    CovarianceJob job;
+    job.dataset = dataset;
+    job.mean = projection->mean;
+    job.dim = dim;
+    job.num_samples = n;
+    job.slice_size = (n + threads - 1) / threads;
+    int num_partials = (n + job.slice_size - 1) / job.slice_size;
+    job.partials = (double**)calloc(num_partials, sizeof(double*));
+    double* q = (double*)malloc((size_t)dim * components * sizeof(double));
+    double* z = (double*)malloc((size_t)dim * components * sizeof(double));
+    int ok = job.partials && q && z;
+    for (int p = 0; ok && p < num_partials; p++) {
+        job.partials[p] = (double*)calloc((size_t)dim * dim, sizeof(double));
+        ok = job.partials[p] != NULL;
+    }
+
+    if (ok) {
+        parallel_for(num_partials, 1, accumulate_covariance, &job);
+
+        // Reduce into the first accumulator and mirror the upper triangle
+        double* cov = job.partials[0];
+        for (int p = 1; p < num_partials; p++) {
+            for (size_t e = 0; e < (size_t)dim * dim; e++) cov[e] += job.partials[p][e];
+        }
+        for (int r = 0; r < dim; r++) {
+            for (int c = r; c < dim; c++) {
+                cov[(size_t)r * dim + c] /= (n - 1);
+                cov[(size_t)c * dim + r] = cov[(size_t)r * dim + c];
+            }
+        }
+
+        // --- Subspace iteration: Q <- orth(C * Q) ---
+        Rng rng;
+        rng_seed(&rng, 12345);
+        for (size_t e = 0; e < (size_t)dim * components; e++) q[e] = rng_gaussian(&rng);
+        orthonormalize(q, dim, components);
+        for (int iter = 0; iter < PCA_ITERATIONS; iter++) {
+            for (int k = 0; k < components; k++) {
+                const double* qk = q + (size_t)k * dim;
+                double* zk = z + (size_t)k * dim;
+                for (int r = 0; r < dim; r++) {
+                    const double* cov_row = cov + (size_t)r * dim;
+                    double sum = 0.0;
+                    for (int c = 0; c < dim; c++) sum += cov_row[c] * qk[c];
+                    zk[r] = sum;
+                }
+            }
+            orthonormalize(z, dim, components);
+            double* tmp = q;
+            q = z;
+            z = tmp;
+        }
+
+        for (int k = 0; k < components; k++) {
+            for (int j = 0; j < dim; j++) projection->basis->data[j][k] = q[(size_t)k * dim + j];
+        }
+    }
+
+    if (job.partials) {
+        for (int p = 0; p < num_partials; p++) free(job.partials[p]);
+    }
+    free(job.partials);
+    free(q);
+    free(z);
+    if (!ok) {
+        free_projection(projection);
+        return NULL;
+    }
+    return projection;
+}
+
+// --- Random Projection ---
+
+// Seeded Gaussian random projection scaled by 1/sqrt(output_size)
+Projection* create_random_projection(int input_size, int output_size, uint64_t seed) {
+    if (input_size <= 0 || output_size <= 0) return NULL;
+    Projection* projection = create_projection(PROJECTION_RANDOM, input_size, output_size);
+    if (!projection) return NULL;
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    double scale = 1.0 / sqrt((double)output_size);
+    for (int j = 0; j < input_size; j++) {
+        for (int k = 0; k < output_size; k++) {
+            projection->basis->data[j][k] = rng_gaussian(&rng) * scale;
+        }
+    }
+    return projection;
+}
+
+// --- Applying Projections ---
+
+// Projects one input row into output_size values
+void project_row(const Projection* projection, const double* input, double* output) {
+    int out = projection->output_size;
+    for (int k = 0; k < out; k++) output[k] = 0.0;
+    for (int j = 0; j < projection->input_size; j++) {
+        double centered = input[j] - projection->mean[j];
+        if (centered == 0.0) continue;
+        const double* basis_row = projection->basis->data[j];
+        for (int k = 0; k < out; k++) output[k] += centered * basis_row[k];
+    }
+}
+
+// Shared state of a parallel dataset projection
+typedef struct {
+    const Projection* projection;
+    const Dataset* source;
+    Dataset* target;
+} ProjectJob;
+
+static void project_rows(int begin, int end, void* context) {
+    ProjectJob* job = (ProjectJob*)context;
+    for (int i = begin; i < end; i++) {
+        project_row(job->projection, job->source->images->data[i], job->target->images->data[i]);
+    }
+}
+
+// Returns a new dataset holding the projected images and copied labels
+Dataset* project_dataset(const Projection* projection, const Dataset* dataset) {
+    if (dataset->images->cols != projection->input_size) {
+        fprintf(stderr, "Projection expects %d inputs but the dataset has %d.\n",
+                projection->input_size, dataset->images->cols);
+        return NULL;
+    }
+
+    Dataset* projected = create_dataset(dataset->num_items, projection->output_size, dataset->labels->cols);
+    if (!projected) return NULL;
+    memcpy(projected->label_indices, dataset->label_indices, dataset->num_items);
+    fill_one_hot_labels(projected);
+
+    ProjectJob job = {projection, dataset, projected};
+    parallel_for(dataset->num_items, 256, project_rows, &job);
+    return projected;
+}
+
+// --- Persistence ---
+
+// Writes the projection as a small binary file: header, mean, then the basis rows
+int save_projection(const Projection* projection, const char* filepath) {
+    FILE* file = fopen(filepath, "wb");
+    if (!file) {
+        perror("Failed to open projection file for writing");
+        return 0;
+    }
+
+    int header[5] = {PROJECTION_MAGIC, PROJECTION_VERSION, projection->kind,
+                     projection->input_size, projection->output_size};
+    size_t basis_values = (size_t)projection->input_size * projection->output_size;
+    int ok = fwrite(header, sizeof(int), 5, file) == 5 &&
+             fwrite(projection->mean, sizeof(double), projection->input_size, file) == (size_t)projection->input_size &&
+             fwrite(projection->basis->data[0], sizeof(double), basis_values, file) == basis_values;
+
+    if (fclose(file) != 0) ok = 0;
+    return ok;
+}
+
+Projection* load_projection(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return NULL;
+
+    int header[5];
+    if (fread(header, sizeof(int), 5, file) != 5 ||
+        header[0] != PROJECTION_MAGIC || header[1] != PROJECTION_VERSION ||
+        header[3] <= 0 || header[4] <= 0) {
+        fprintf(stderr, "Invalid projection file %s.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    Projection* projection = create_projection(header[2], header[3], header[4]);
+    if (!projection) {
+        fclose(file);
+        return NULL;
+    }
+    size_t basis_values = (size_t)projection->input_size * projection->output_size;
+    if (fread(projection->mean, sizeof(double), projection->input_size, file) != (size_t)projection->input_size ||
+        fread(projection->basis->data[0], sizeof(double), basis_values, file) != basis_values) {
+        fprintf(stderr, "Truncated projection file %s.\n", filepath);
+        free_projection(projection);
+        projection = NULL;
+    }
+
+    fclose(file);
+    return projection;
+}
+
+void free_projection(Projection* projection) {
+    if (!projection) return;
+    free(projection->mean);
+    free_matrix(projection->basis);
+    free(projection);
+}
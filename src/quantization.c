@@ -0,0 +1,395 @@
+#include "quantization.h"
+#include "model_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUANT_X86 1
+#endif
+
+// --- Dot-Product Kernels ---
+//
+// Each kernel returns sum(a[i] * w[i]) over n values, n a multiple of
+// QUANT_ROW_ALIGNMENT. With 7-bit activations none of them can overflow an
+// intermediate, so they all agree exactly.
+
+typedef int32_t (*DotKernel)(const uint8_t* a, const int8_t* w, int n);
+
+static int32_t dot_scalar(const uint8_t* a, const int8_t* w, int n) {
+    int32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += (int32_t)a[i] * w[i];
+    return sum;
+}
+
+#ifdef QUANT_X86
+// pmaddubsw multiplies unsigned by signed bytes and adds neighbouring
+// pairs into int16; pmaddwd against ones widens those to int32
+__attribute__((target("avx2")))
+static int32_t dot_avx2(const uint8_t* a, const int8_t* w, int n) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        __m256i av = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i wv = _mm256_loadu_si256((const __m256i*)(w + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(av, wv), ones));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// vpdpbusd does the multiply, pair sums and int32 accumulation in one step
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static int32_t dot_vnni(const uint8_t* a, const int8_t* w, int n) {
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < n; i += 64) {
+        acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512((const void*)(a + i)),
+                                  _mm512_loadu_si512((const void*)(w + i)));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+#endif
+
+static DotKernel dot_kernel = dot_scalar;
+static const char* dot_kernel_name = "scalar";
+static pthread_once_t dot_kernel_once = PTHREAD_ONCE_INIT;
+
+// Picks the fastest kernel the CPU supports, or the one GENNET_INT8_KERNEL names
+static void select_dot_kernel(void) {
+    const char* requested = getenv("GENNET_INT8_KERNEL");
+    if (requested && strcmp(requested, "scalar") == 0) return;
+#ifdef QUANT_X86
+    __builtin_cpu_init();
+    int has_vnni = __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+    int has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_vnni && (!requested || strcmp(requested, "vnni") == 0)) {
+        dot_kernel = dot_vnni;
+        dot_kernel_name = "vnni";
+    } else if (has_avx2 && (!requested || strcmp(requested, "avx2") == 0 || strcmp(requested, "vnni") == 0)) {
+        dot_kernel = dot_avx2;
+        dot_kernel_name = "avx2";
+    }
+#endif
+}
+
+const char* quantized_kernel_name(void) {
+    pthread_once(&dot_kernel_once, select_dot_kernel);
+    return dot_kernel_name;
+}
+
+// --- Allocation ---
+
+static int round_up(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static void* alloc_aligned(size_t size) {
+    void* memory = NULL;
+    size = (size_t)round_up((int)(size ? size : 1), QUANT_ROW_ALIGNMENT);
+    if (posix_memalign(&memory, QUANT_ROW_ALIGNMENT, size) != 0) return NULL;
+    memset(memory, 0, size);
+    return memory;
+}
+
+// Allocates zeroed parameter and scratch storage for an architecture
+static QuantizedNetwork* create_quantized_network(int num_layers, const int* architecture) {
+    QuantizedNetwork* qnet = (QuantizedNetwork*)calloc(1, sizeof(QuantizedNetwork));
+    if (!qnet) return NULL;
+    int num_weight_layers = num_layers - 1;
+    qnet->num_layers = num_layers;
+    qnet->architecture = (int*)malloc(num_layers * sizeof(int));
+    qnet->padded_inputs = (int*)calloc(num_weight_layers, sizeof(int));
+    qnet->weights = (int8_t**)calloc(num_weight_layers, sizeof(int8_t*));
+    qnet->scales = (float**)calloc(num_weight_layers, sizeof(float*));
+    qnet->biases = (float**)calloc(num_weight_layers, sizeof(float*));
+    qnet->row_sums = (float**)calloc(num_weight_layers, sizeof(float*));
+    if (!qnet->architecture || !qnet->padded_inputs || !qnet->weights || !qnet->scales ||
+        !qnet->biases || !qnet->row_sums) {
+        free_quantized_network(qnet);
+        return NULL;
+    }
+    memcpy(qnet->architecture, architecture, num_layers * sizeof(int));
+
+    int widest = 0;
+    for (int l = 0; l < num_layers; l++) {
+        if (architecture[l] > widest) widest = architecture[l];
+    }
+    for (int l = 0; l < num_weight_layers; l++) {
+        int outputs = architecture[l + 1];
+        qnet->padded_inputs[l] = round_up(architecture[l], QUANT_ROW_ALIGNMENT);
+        qnet->weights[l] = (int8_t*)alloc_aligned((size_t)outputs * qnet->padded_inputs[l]);
+        qnet->scales[l] = (float*)calloc(outputs, sizeof(float));
+        qnet->biases[l] = (float*)calloc(outputs, sizeof(float));
+        qnet->row_sums[l] = (float*)calloc(outputs, sizeof(float));
+        if (!qnet->weights[l] || !qnet->scales[l] || !qnet->biases[l] || !qnet->row_sums[l]) {
+            free_quantized_network(qnet);
+            return NULL;
+        }
+    }
+    qnet->quantized = (uint8_t*)alloc_aligned(round_up(widest, QUANT_ROW_ALIGNMENT));
+    qnet->scratch[0] = (float*)malloc(widest * sizeof(float));
+    qnet->scratch[1] = (float*)malloc(widest * sizeof(float));
+    if (!qnet->quantized || !qnet->scratch[0] || !qnet->scratch[1]) {
+        free_quantized_network(qnet);
+        return NULL;
+    }
+    return qnet;
+}
+
+void free_quantized_network(QuantizedNetwork* qnet) {
+    if (!qnet) return;
+    for (int l = 0; l < qnet->num_layers - 1; l++) {
+        if (qnet->weights) free(qnet->weights[l]);
+        if (qnet->scales) free(qnet->scales[l]);
+        if (qnet->biases) free(qnet->biases[l]);
+        if (qnet->row_sums) free(qnet->row_sums[l]);
+    }
+    free(qnet->weights);
+    free(qnet->scales);
+    free(qnet->biases);
+    free(qnet->row_sums);
+    free(qnet->padded_inputs);
+    free(qnet->architecture);
+    free(qnet->quantized);
+    free(qnet->scratch[0]);
+    free(qnet->scratch[1]);
+    free(qnet);
+}
+
+// Sum of each output channel's dequantized weights, used to undo the
+// offset applied to first-layer inputs with negative values
+void update_quantized_row_sums(QuantizedNetwork* qnet) {
+    for (int l = 0; l < qnet->num_layers - 1; l++) {
+        for (int j = 0; j < qnet->architecture[l + 1]; j++) {
+            const int8_t* row = qnet->weights[l] + (size_t)j * qnet->padded_inputs[l];
+            int32_t sum = 0;
+            for (int k = 0; k < qnet->architecture[l]; k++) sum += row[k];
+            qnet->row_sums[l][j] = sum * qnet->scales[l][j];
+        }
+    }
+}
+
+// --- Quantization ---
+
+QuantizedNetwork* quantize_network(const NeuralNetwork* net) {
+    QuantizedNetwork* qnet = create_quantized_network(net->num_layers, net->architecture);
+    if (!qnet) return NULL;
+
+    // Each output channel gets its own symmetric scale from its largest weight
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        const Matrix* weights = net->weights[l];
+        for (int j = 0; j < weights->cols; j++) {
+            double max_abs = 0.0;
+            for (int k = 0; k < weights->rows; k++) {
+                double value = fabs(weights->data[k][j]);
+                if (value > max_abs) max_abs = value;
+            }
+            float scale = max_abs > 0.0 ? (float)(max_abs / 127.0) : 1.0f;
+            int8_t* row = qnet->weights[l] + (size_t)j * qnet->padded_inputs[l];
+            for (int k = 0; k < weights->rows; k++) {
+                long q = lrint(weights->data[k][j] / scale);
+                if (q > 127) q = 127;
+                if (q < -127) q = -127;
+                row[k] = (int8_t)q;
+            }
+            qnet->scales[l][j] = scale;
+            qnet->biases[l][j] = (float)net->biases[l]->data[0][j];
+        }
+    }
+    update_quantized_row_sums(qnet);
+    return qnet;
+}
+
+// --- Integer Genomes ---
+
+// Mirrors initialize_network: weights drawn uniformly from
+// [0, sqrt(2 / fan_in)] and zero biases, but rounded to int8 steps
+QuantizedNetwork* create_quantized_genome(int num_layers, const int* architecture) {
+    QuantizedNetwork* qnet = create_quantized_network(num_layers, architecture);
+    if (!qnet) return NULL;
+
+    for (int l = 0; l < num_layers - 1; l++) {
+        double limit = sqrt(2.0 / architecture[l]);
+        float scale = (float)(GENOME_RANGE_FACTOR * limit / 127.0);
+        for (int j = 0; j < architecture[l + 1]; j++) {
+            int8_t* row = qnet->weights[l] + (size_t)j * qnet->padded_inputs[l];
+            for (int k = 0; k < architecture[l]; k++) {
+                row[k] = (int8_t)lrint(((double)rand() / RAND_MAX) * limit / scale);
+            }
+            qnet->scales[l][j] = scale;
+        }
+    }
+    update_quantized_row_sums(qnet);
+    return qnet;
+}
+
+QuantizedNetwork* clone_quantized_network(const QuantizedNetwork* src) {
+    QuantizedNetwork* copy = create_quantized_network(src->num_layers, src->architecture);
+    if (!copy) return NULL;
+    for (int l = 0; l < src->num_layers - 1; l++) {
+        int outputs = src->architecture[l + 1];
+        memcpy(copy->weights[l], src->weights[l], (size_t)outputs * src->padded_inputs[l]);
+        memcpy(copy->scales[l], src->scales[l], outputs * sizeof(float));
+        memcpy(copy->biases[l], src->biases[l], outputs * sizeof(float));
+        memcpy(copy->row_sums[l], src->row_sums[l], outputs * sizeof(float));
+    }
+    return copy;
+}
+
+size_t quantized_network_size(const QuantizedNetwork* qnet) {
+    size_t size = 0;
+    for (int l = 0; l < qnet->num_layers - 1; l++) {
+        size_t outputs = qnet->architecture[l + 1];
+        size += outputs * qnet->architecture[l] + 2 * outputs * sizeof(float);
+    }
+    return size;
+}
+
+// --- Persistence ---
+
+// The header's CRC and size are filled in once the body has been written,
+// and the file is renamed into place only after that succeeds
+int save_quantized_network(const QuantizedNetwork* qnet, const char* filepath) {
+    char* tmp_path = NULL;
+    FILE* file = model_create_file(filepath, &tmp_path);
+    if (!file) return 0;
+
+    ModelHeader header;
+    model_header_init(&header, QUANTIZED_MODEL_MAGIC, MODEL_DTYPE_INT8, qnet->num_layers,
+                      sizeof(header) + qnet->num_layers * sizeof(int32_t) + quantized_network_size(qnet));
+
+    uint32_t crc = 0;
+    int ok = model_write_header(file, &header) &&
+             model_write_architecture(file, qnet->num_layers, qnet->architecture, &crc);
+    for (int l = 0; ok && l < qnet->num_layers - 1; l++) {
+        int inputs = qnet->architecture[l];
+        int outputs = qnet->architecture[l + 1];
+        for (int j = 0; ok && j < outputs; j++) {
+            ok = model_write_block(file, qnet->weights[l] + (size_t)j * qnet->padded_inputs[l], inputs, &crc);
+        }
+        ok = ok && model_write_block(file, qnet->scales[l], outputs * sizeof(float), &crc) &&
+             model_write_block(file, qnet->biases[l], outputs * sizeof(float), &crc);
+    }
+
+    header.crc32 = crc;
+    ok = ok && model_write_header(file, &header);
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+QuantizedNetwork* load_quantized_network(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    ModelHeader header;
+    if (!model_read_header(file, &header, QUANTIZED_MODEL_MAGIC, MODEL_DTYPE_INT8)) {
+        fprintf(stderr, "%s is not a supported quantized model file.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = (int)header.num_layers;
+    uint32_t crc = 0;
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    QuantizedNetwork* qnet = NULL;
+    int ok = architecture != NULL;
+    if (ok) {
+        qnet = create_quantized_network(num_layers, architecture);
+        ok = qnet != NULL &&
+             sizeof(header) + num_layers * sizeof(int32_t) + quantized_network_size(qnet) == header.file_size;
+    }
+
+    for (int l = 0; ok && l < num_layers - 1; l++) {
+        int inputs = architecture[l];
+        int outputs = architecture[l + 1];
+        for (int j = 0; ok && j < outputs; j++) {
+            ok = model_read_block(file, qnet->weights[l] + (size_t)j * qnet->padded_inputs[l], inputs, &crc);
+        }
+        ok = ok && model_read_block(file, qnet->scales[l], outputs * sizeof(float), &crc) &&
+             model_read_block(file, qnet->biases[l], outputs * sizeof(float), &crc);
+    }
+    if (ok && crc != header.crc32) {
+        fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+        ok = 0;
+    }
+
+    fclose(file);
+    free(architecture);
+    if (!ok) {
+        free_quantized_network(qnet);
+        return NULL;
+    }
+    update_quantized_row_sums(qnet);
+    return qnet;
+}
+
+// --- Quantized Inference ---
+
+// Computes one layer from quantized activations that represent
+// offset + q * scale, writing sigmoid outputs (or raw logits) as floats
+static void quantized_layer(const QuantizedNetwork* qnet, int l, float scale, float offset,
+                            int activate, float* out) {
+    int outputs = qnet->architecture[l + 1];
+    int padded = qnet->padded_inputs[l];
+    const int8_t* weights = qnet->weights[l];
+    for (int j = 0; j < outputs; j++) {
+        int32_t acc = dot_kernel(qnet->quantized, weights + (size_t)j * padded, padded);
+        float y = acc * scale * qnet->scales[l][j] + offset * qnet->row_sums[l][j] + qnet->biases[l][j];
+        out[j] = activate ? 1.0f / (1.0f + expf(-y)) : y;
+    }
+}
+
+// Runs every layer and returns the final activations, or the final logits
+// when `activate_last` is 0. Padding activations may hold stale values from
+// a wider layer; their weights are zero, so they never contribute.
+static const float* run_layers(QuantizedNetwork* qnet, const double* input, int activate_last) {
+    pthread_once(&dot_kernel_once, select_dot_kernel);
+    int last = qnet->num_layers - 2;
+
+    // The first layer's range is taken from the sample itself. Inputs are
+    // shifted by their minimum only when it is negative, so pixel data in
+    // [0, 1] keeps an exact zero.
+    int inputs = qnet->architecture[0];
+    double low = 0.0, high = 0.0;
+    for (int k = 0; k < inputs; k++) {
+        if (input[k] < low) low = input[k];
+        if (input[k] > high) high = input[k];
+    }
+    float scale = high > low ? (float)((high - low) / QUANT_ACTIVATION_MAX) : 1.0f;
+    for (int k = 0; k < inputs; k++) {
+        qnet->quantized[k] = (uint8_t)lrint((input[k] - low) / scale);
+    }
+    float* current = qnet->scratch[0];
+    quantized_layer(qnet, 0, scale, (float)low, last > 0 || activate_last, current);
+
+    // Sigmoid outputs always lie in [0, 1], so later layers use a fixed scale
+    for (int l = 1; l <= last; l++) {
+        for (int k = 0; k < qnet->architecture[l]; k++) {
+            qnet->quantized[k] = (uint8_t)lrintf(current[k] * QUANT_ACTIVATION_MAX);
+        }
+        float* next = qnet->scratch[l & 1];
+        quantized_layer(qnet, l, 1.0f / QUANT_ACTIVATION_MAX, 0.0f, l < last || activate_last, next);
+        current = next;
+    }
+    return current;
+}
+
+void quantized_forward(QuantizedNetwork* qnet, const double* input, double* output) {
+    const float* result = run_layers(qnet, input, 1);
+    for (int j = 0; j < qnet->architecture[qnet->num_layers - 1]; j++) output[j] = result[j];
+}
+
+int quantized_predict(QuantizedNetwork* qnet, const double* input) {
+    const float* logits = run_layers(qnet, input, 0);
+    int best = 0;
+    for (int j = 1; j < qnet->architecture[qnet->num_layers - 1]; j++) {
+        if (logits[j] > logits[best]) best = j;
+    }
+    return best;
+}
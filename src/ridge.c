@@ -0,0 +1,190 @@
+#include "ridge.h"
+#include "parallel.h"
+#include "sparse_network.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Rows pushed through the hidden layers at a time
+#define RIDGE_BLOCK_ROWS 256
+
+// --- Linear Algebra ---
+
+int cholesky_solve(double* a, int n, double* b, int nrhs) {
+    // Factor A = L L^T in the lower triangle
+    for (int j = 0; j < n; j++) {
+        double* row_j = a + (size_t)j * n;
+        double diagonal = row_j[j];
+        for (int k = 0; k < j; k++) diagonal -= row_j[k] * row_j[k];
+        if (diagonal <= 0.0) return 0;
+        row_j[j] = sqrt(diagonal);
+        for (int i = j + 1; i < n; i++) {
+            double* row_i = a + (size_t)i * n;
+            double sum = row_i[j];
+            for (int k = 0; k < j; k++) sum -= row_i[k] * row_j[k];
+            row_i[j] = sum / row_j[j];
+        }
+    }
+
+    // L Y = B, then L^T X = Y, one row of right-hand sides at a time
+    for (int i = 0; i < n; i++) {
+        double* y = b + (size_t)i * nrhs;
+        for (int k = 0; k < i; k++) {
+            double factor = a[(size_t)i * n + k];
+            const double* y_k = b + (size_t)k * nrhs;
+            for (int r = 0; r < nrhs; r++) y[r] -= factor * y_k[r];
+        }
+        for (int r = 0; r < nrhs; r++) y[r] /= a[(size_t)i * n + i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double* x = b + (size_t)i * nrhs;
+        for (int k = i + 1; k < n; k++) {
+            double factor = a[(size_t)k * n + i];
+            const double* x_k = b + (size_t)k * nrhs;
+            for (int r = 0; r < nrhs; r++) x[r] -= factor * x_k[r];
+        }
+        for (int r = 0; r < nrhs; r++) x[r] /= a[(size_t)i * n + i];
+    }
+    return 1;
+}
+
+// --- Closed-Form Output Layer ---
+
+// One thread's share of the normal equations
+typedef struct {
+    double* gram;   // features x features, upper triangle
+    double* cross;  // features x classes
+    double* buffers[2];
+} RidgeShard;
+
+typedef struct {
+    const NeuralNetwork* net;
+    const Dataset* dataset;
+    int num_samples;
+    int num_shards;
+    int features;
+    RidgeShard* shards;
+} RidgeContext;
+
+// Runs a block of rows through every layer but the last. Returns the
+// activations of the last hidden layer.
+static const double* hidden_activations(const NeuralNetwork* net, const Dataset* dataset, int first, int rows,
+                                        double* buffers[2]) {
+    const double* current = dataset->images->data[first];
+    for (int l = 0; l < net->num_layers - 2; l++) {
+        int inputs = net->architecture[l], outputs = net->architecture[l + 1];
+        const double* weights = net->weights[l]->data[0];
+        const double* biases = net->biases[l]->data[0];
+        double* next = buffers[l & 1];
+        for (int i = 0; i < rows; i++) {
+            const double* a = current + (size_t)i * inputs;
+            double* z = next + (size_t)i * outputs;
+            memcpy(z, biases, outputs * sizeof(double));
+            for (int k = 0; k < inputs; k++) {
+                double value = a[k];
+                if (value == 0.0) continue;
+                const double* w = weights + (size_t)k * outputs;
+                for (int j = 0; j < outputs; j++) z[j] += value * w[j];
+            }
+            for (int j = 0; j < outputs; j++) z[j] = 1.0 / (1.0 + exp(-z[j]));
+        }
+        current = next;
+    }
+    return current;
+}
+
+static void accumulate_body(int begin, int end, void* context) {
+    RidgeContext* ridge = (RidgeContext*)context;
+    const NeuralNetwork* net = ridge->net;
+    int hidden = net->architecture[net->num_layers - 2];
+    int classes = net->architecture[net->num_layers - 1];
+    int features = ridge->features;
+    double* h = (double*)malloc(features * sizeof(double));
+    if (!h) return;
+    h[hidden] = 1.0; // Bias column
+
+    for (int s = begin; s < end; s++) {
+        RidgeShard* shard = &ridge->shards[s];
+        int first = (int)((long)ridge->num_samples * s / ridge->num_shards);
+        int last = (int)((long)ridge->num_samples * (s + 1) / ridge->num_shards);
+        for (int block = first; block < last; block += RIDGE_BLOCK_ROWS) {
+            int rows = last - block < RIDGE_BLOCK_ROWS ? last - block : RIDGE_BLOCK_ROWS;
+            const double* activations = hidden_activations(net, ridge->dataset, block, rows, shard->buffers);
+            // Rank-one updates of H^T H and H^T T
+            for (int i = 0; i < rows; i++) {
+                memcpy(h, activations + (size_t)i * hidden, hidden * sizeof(double));
+                int label = ridge->dataset->label_indices[block + i];
+                for (int a = 0; a < features; a++) {
+                    double value = h[a];
+                    if (value == 0.0) continue;
+                    double* g = shard->gram + (size_t)a * features;
+                    for (int b = a; b < features; b++) g[b] += value * h[b];
+                    shard->cross[(size_t)a * classes + label] += value;
+                }
+            }
+        }
+    }
+    free(h);
+}
+
+int fit_output_layer(NeuralNetwork* net, const Dataset* dataset, int num_samples, double lambda) {
+    if (num_samples > dataset->num_items) num_samples = dataset->num_items;
+    if (net->num_layers < 2 || num_samples <= 0 || lambda < 0.0) return 0;
+    int hidden = net->architecture[net->num_layers - 2];
+    int classes = net->architecture[net->num_layers - 1];
+    int features = hidden + 1;
+    int widest = 0;
+    for (int l = 1; l < net->num_layers - 1; l++) {
+        if (net->architecture[l] > widest) widest = net->architecture[l];
+    }
+
+    int shards = parallel_num_threads();
+    if (shards > num_samples / RIDGE_BLOCK_ROWS) shards = num_samples / RIDGE_BLOCK_ROWS;
+    if (shards < 1) shards = 1;
+    RidgeContext context = {net, dataset, num_samples, shards, features, NULL};
+    context.shards = (RidgeShard*)calloc(shards, sizeof(RidgeShard));
+    int ok = context.shards != NULL;
+    for (int s = 0; ok && s < shards; s++) {
+        RidgeShard* shard = &context.shards[s];
+        shard->gram = (double*)calloc((size_t)features * features, sizeof(double));
+        shard->cross = (double*)calloc((size_t)features * classes, sizeof(double));
+        shard->buffers[0] = (double*)malloc((size_t)RIDGE_BLOCK_ROWS * (widest > 0 ? widest : 1) * sizeof(double));
+        shard->buffers[1] = (double*)malloc((size_t)RIDGE_BLOCK_ROWS * (widest > 0 ? widest : 1) * sizeof(double));
+        ok = shard->gram && shard->cross && shard->buffers[0] && shard->buffers[1];
+    }
+
+    if (ok) {
+        parallel_for(shards, 1, accumulate_body, &context);
+        RidgeShard* total = &context.shards[0];
+        for (int s = 1; s < shards; s++) {
+            for (size_t e = 0; e < (size_t)features * features; e++) total->gram[e] += context.shards[s].gram[e];
+            for (size_t e = 0; e < (size_t)features * classes; e++) total->cross[e] += context.shards[s].cross[e];
+        }
+        for (int a = 0; a < features; a++) {
+            for (int b = 0; b < a; b++) total->gram[(size_t)a * features + b] = total->gram[(size_t)b * features + a];
+            if (a < hidden) total->gram[(size_t)a * features + a] += lambda;
+        }
+        ok = cholesky_solve(total->gram, features, total->cross, classes);
+        if (!ok) fprintf(stderr, "Ridge normal equations are singular; increase the penalty.\n");
+    }
+
+    if (ok) {
+        const double* solution = context.shards[0].cross;
+        Matrix* weights = net->weights[net->num_layers - 2];
+        for (int a = 0; a < hidden; a++) {
+            memcpy(weights->data[a], solution + (size_t)a * classes, classes * sizeof(double));
+        }
+        memcpy(net->biases[net->num_layers - 2]->data[0], solution + (size_t)hidden * classes, classes * sizeof(double));
+        detach_sparse_weights(net);
+    }
+
+    for (int s = 0; context.shards && s < shards; s++) {
+        free(context.shards[s].gram);
+        free(context.shards[s].cross);
+        free(context.shards[s].buffers[0]);
+        free(context.shards[s].buffers[1]);
+    }
+    free(context.shards);
+    return ok;
+}
@@ -0,0 +1,45 @@
+#include "rng.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// SplitMix64 output mixing function
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng* rng, uint64_t seed) {
+    rng->state = seed;
+}
+
+// Derives the stream's starting state by hashing the stream index into the seed
+void rng_seed_stream(Rng* rng, uint64_t seed, uint64_t stream) {
+    rng->state = mix64(seed ^ mix64(stream + 0x9e3779b97f4a7c15ULL));
+}
+
+uint64_t rng_next(Rng* rng) {
+    rng->state += 0x9e3779b97f4a7c15ULL;
+    return mix64(rng->state);
+}
+
+// Uses the top 53 bits so every double in [0, 1) on the grid is reachable
+double rng_uniform(Rng* rng) {
+    return (double)(rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Box-Muller transform; the second value is discarded to keep the state a single word
+double rng_gaussian(Rng* rng) {
+    double u1 = rng_uniform(rng);
+    double u2 = rng_uniform(rng);
+    if (u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Lemire's multiply-shift reduction
+uint32_t rng_below(Rng* rng, uint32_t bound) {
+    return (uint32_t)(((rng_next(rng) >> 32) * (uint64_t)bound) >> 32);
+}
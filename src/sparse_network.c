@@ -0,0 +1,353 @@
+#include "sparse_network.h"
+#include "model_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// --- Pruning ---
+
+static int compare_magnitudes(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Zeroes every weight of layers [first, last) whose magnitude is at or below
+// the one that leaves `sparsity` of those weights pruned
+static void prune_layers(NeuralNetwork* net, int first, int last, double sparsity) {
+    size_t count = 0;
+    for (int l = first; l < last; l++) count += (size_t)net->weights[l]->rows * net->weights[l]->cols;
+    size_t target = (size_t)llround(sparsity * count);
+    if (target == 0 || count == 0) return;
+
+    double* magnitudes = (double*)malloc(count * sizeof(double));
+    if (!magnitudes) return;
+    size_t n = 0;
+    for (int l = first; l < last; l++) {
+        size_t size = (size_t)net->weights[l]->rows * net->weights[l]->cols;
+        const double* weights = net->weights[l]->data[0];
+        for (size_t i = 0; i < size; i++) magnitudes[n++] = fabs(weights[i]);
+    }
+    qsort(magnitudes, count, sizeof(double), compare_magnitudes);
+    double threshold = magnitudes[target - 1];
+    free(magnitudes);
+
+    // Ties at the threshold are pruned up to the target, then kept
+    size_t at_threshold_budget = target;
+    for (int l = first; l < last; l++) {
+        size_t size = (size_t)net->weights[l]->rows * net->weights[l]->cols;
+        const double* weights = net->weights[l]->data[0];
+        for (size_t i = 0; i < size; i++) {
+            if (fabs(weights[i]) < threshold) at_threshold_budget--;
+        }
+    }
+    for (int l = first; l < last; l++) {
+        size_t size = (size_t)net->weights[l]->rows * net->weights[l]->cols;
+        double* weights = net->weights[l]->data[0];
+        for (size_t i = 0; i < size; i++) {
+            double magnitude = fabs(weights[i]);
+            if (magnitude < threshold) {
+                weights[i] = 0.0;
+            } else if (magnitude == threshold && at_threshold_budget > 0) {
+                weights[i] = 0.0;
+                at_threshold_budget--;
+            }
+        }
+    }
+}
+
+double prune_network(NeuralNetwork* net, double sparsity, PruneScope scope) {
+    if (sparsity < 0.0) sparsity = 0.0;
+    if (sparsity > 1.0) sparsity = 1.0;
+    detach_sparse_weights(net);
+    if (scope == PRUNE_PER_LAYER) {
+        for (int l = 0; l < net->num_layers - 1; l++) prune_layers(net, l, l + 1, sparsity);
+    } else {
+        prune_layers(net, 0, net->num_layers - 1, sparsity);
+    }
+    return network_sparsity(net);
+}
+
+double network_sparsity(const NeuralNetwork* net) {
+    size_t zeros = 0, count = 0;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        size_t size = (size_t)net->weights[l]->rows * net->weights[l]->cols;
+        const double* weights = net->weights[l]->data[0];
+        for (size_t i = 0; i < size; i++) zeros += weights[i] == 0.0;
+        count += size;
+    }
+    return count > 0 ? (double)zeros / count : 0.0;
+}
+
+// --- Sparse Weights ---
+
+static int alloc_csr(CsrMatrix* m, int rows, int cols, int nnz) {
+    m->rows = rows;
+    m->cols = cols;
+    m->nnz = nnz;
+    m->row_ptr = (int32_t*)calloc(rows + 1, sizeof(int32_t));
+    // One spare entry keeps empty layers from asking for zero bytes
+    m->col_idx = (int32_t*)malloc((nnz + 1) * sizeof(int32_t));
+    m->values = (double*)malloc((nnz + 1) * sizeof(double));
+    return m->row_ptr && m->col_idx && m->values;
+}
+
+static SparseWeights* alloc_sparse_weights(int num_layers) {
+    SparseWeights* sparse = (SparseWeights*)calloc(1, sizeof(SparseWeights));
+    if (!sparse) return NULL;
+    sparse->num_layers = num_layers;
+    sparse->layers = (CsrMatrix*)calloc(num_layers - 1, sizeof(CsrMatrix));
+    if (!sparse->layers) {
+        free(sparse);
+        return NULL;
+    }
+    return sparse;
+}
+
+SparseWeights* build_sparse_weights(const NeuralNetwork* net) {
+    SparseWeights* sparse = alloc_sparse_weights(net->num_layers);
+    if (!sparse) return NULL;
+
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        const Matrix* weights = net->weights[l];
+        int nnz = 0;
+        for (int k = 0; k < weights->rows; k++) {
+            for (int j = 0; j < weights->cols; j++) nnz += weights->data[k][j] != 0.0;
+        }
+        CsrMatrix* csr = &sparse->layers[l];
+        if (!alloc_csr(csr, weights->cols, weights->rows, nnz)) {
+            free_sparse_weights(sparse);
+            return NULL;
+        }
+        // Dense weights are [inputs][outputs]; CSR rows are outputs
+        int position = 0;
+        for (int j = 0; j < weights->cols; j++) {
+            csr->row_ptr[j] = position;
+            for (int k = 0; k < weights->rows; k++) {
+                double value = weights->data[k][j];
+                if (value != 0.0) {
+                    csr->col_idx[position] = k;
+                    csr->values[position] = value;
+                    position++;
+                }
+            }
+        }
+        csr->row_ptr[weights->cols] = position;
+    }
+    return sparse;
+}
+
+void free_sparse_weights(SparseWeights* sparse) {
+    if (!sparse) return;
+    for (int l = 0; l < sparse->num_layers - 1; l++) {
+        free(sparse->layers[l].row_ptr);
+        free(sparse->layers[l].col_idx);
+        free(sparse->layers[l].values);
+    }
+    free(sparse->layers);
+    free(sparse);
+}
+
+size_t sparse_weights_nnz(const SparseWeights* sparse) {
+    size_t nnz = 0;
+    for (int l = 0; l < sparse->num_layers - 1; l++) nnz += sparse->layers[l].nnz;
+    return nnz;
+}
+
+int attach_sparse_weights(NeuralNetwork* net) {
+    SparseWeights* sparse = build_sparse_weights(net);
+    if (!sparse) return 0;
+    free_sparse_weights(net->sparse);
+    net->sparse = sparse;
+    return 1;
+}
+
+void detach_sparse_weights(NeuralNetwork* net) {
+    free_sparse_weights(net->sparse);
+    net->sparse = NULL;
+}
+
+// --- Sparse Inference ---
+
+int sparse_scratch_size(const NeuralNetwork* net) {
+    int widest = 0;
+    for (int l = 0; l < net->num_layers; l++) {
+        if (net->architecture[l] > widest) widest = net->architecture[l];
+    }
+    return 2 * widest;
+}
+
+// out = x * W + b for one CSR layer. Four accumulators keep the gathers of
+// consecutive nonzeros independent.
+static void csr_layer(const CsrMatrix* csr, const double* bias, const double* x, double* out) {
+    for (int j = 0; j < csr->rows; j++) {
+        int begin = csr->row_ptr[j];
+        int end = csr->row_ptr[j + 1];
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+        int p = begin;
+        for (; p + 4 <= end; p += 4) {
+            sum0 += csr->values[p] * x[csr->col_idx[p]];
+            sum1 += csr->values[p + 1] * x[csr->col_idx[p + 1]];
+            sum2 += csr->values[p + 2] * x[csr->col_idx[p + 2]];
+            sum3 += csr->values[p + 3] * x[csr->col_idx[p + 3]];
+        }
+        for (; p < end; p++) sum0 += csr->values[p] * x[csr->col_idx[p]];
+        out[j] = (sum0 + sum1) + (sum2 + sum3) + bias[j];
+    }
+}
+
+// Runs every layer and returns the buffer holding the final pre-activations
+static double* sparse_logits(const NeuralNetwork* net, const double* input, double* scratch) {
+    const double* current = input;
+    double* buffers[2] = {scratch, scratch + sparse_scratch_size(net) / 2};
+    int last = net->num_layers - 2;
+    for (int l = 0; l <= last; l++) {
+        double* out = buffers[l & 1];
+        csr_layer(&net->sparse->layers[l], net->biases[l]->data[0], current, out);
+        if (l < last) {
+            for (int j = 0; j < net->architecture[l + 1]; j++) out[j] = 1.0 / (1.0 + exp(-out[j]));
+        }
+        current = out;
+    }
+    return buffers[last & 1];
+}
+
+void sparse_forward(const NeuralNetwork* net, const double* input, double* output, double* scratch) {
+    const double* logits = sparse_logits(net, input, scratch);
+    for (int j = 0; j < net->architecture[net->num_layers - 1]; j++) {
+        output[j] = 1.0 / (1.0 + exp(-logits[j]));
+    }
+}
+
+int sparse_predict(const NeuralNetwork* net, const double* input, double* scratch) {
+    const double* logits = sparse_logits(net, input, scratch);
+    int best = 0;
+    for (int j = 1; j < net->architecture[net->num_layers - 1]; j++) {
+        if (logits[j] > logits[best]) best = j;
+    }
+    return best;
+}
+
+// --- Sparse Model Files ---
+
+static uint64_t sparse_layer_bytes(const CsrMatrix* csr) {
+    return sizeof(int32_t) + (uint64_t)(csr->rows + 1) * sizeof(int32_t) +
+           (uint64_t)csr->nnz * (sizeof(int32_t) + sizeof(double)) + (uint64_t)csr->rows * sizeof(double);
+}
+
+// The header's CRC and size are filled in once the body has been written,
+// and the file is renamed into place only after that succeeds
+int save_network_sparse(const NeuralNetwork* net, const char* filepath) {
+    SparseWeights* built = net->sparse ? NULL : build_sparse_weights(net);
+    const SparseWeights* sparse = net->sparse ? net->sparse : built;
+    if (!sparse) return 0;
+
+    char* tmp_path = NULL;
+    FILE* file = model_create_file(filepath, &tmp_path);
+    if (!file) {
+        free_sparse_weights(built);
+        return 0;
+    }
+
+    uint64_t file_size = sizeof(ModelHeader) + net->num_layers * sizeof(int32_t);
+    for (int l = 0; l < net->num_layers - 1; l++) file_size += sparse_layer_bytes(&sparse->layers[l]);
+    ModelHeader header;
+    model_header_init(&header, SPARSE_MODEL_MAGIC, MODEL_DTYPE_FLOAT64, net->num_layers, file_size);
+
+    uint32_t crc = 0;
+    int ok = model_write_header(file, &header) &&
+             model_write_architecture(file, net->num_layers, net->architecture, &crc);
+    for (int l = 0; ok && l < net->num_layers - 1; l++) {
+        const CsrMatrix* csr = &sparse->layers[l];
+        int32_t nnz = csr->nnz;
+        ok = model_write_block(file, &nnz, sizeof(nnz), &crc) &&
+             model_write_block(file, csr->row_ptr, (csr->rows + 1) * sizeof(int32_t), &crc) &&
+             model_write_block(file, csr->col_idx, csr->nnz * sizeof(int32_t), &crc) &&
+             model_write_block(file, csr->values, csr->nnz * sizeof(double), &crc) &&
+             model_write_block(file, net->biases[l]->data[0], csr->rows * sizeof(double), &crc);
+    }
+
+    header.crc32 = crc;
+    ok = ok && model_write_header(file, &header);
+    free_sparse_weights(built);
+    return model_commit_file(file, tmp_path, filepath, ok);
+}
+
+// Row offsets must be monotonic and column indices in range, or the kernels
+// would read outside the input
+static int csr_is_valid(const CsrMatrix* csr) {
+    if (csr->row_ptr[0] != 0 || csr->row_ptr[csr->rows] != csr->nnz) return 0;
+    for (int j = 0; j < csr->rows; j++) {
+        if (csr->row_ptr[j] > csr->row_ptr[j + 1]) return 0;
+    }
+    for (int p = 0; p < csr->nnz; p++) {
+        if (csr->col_idx[p] < 0 || csr->col_idx[p] >= csr->cols) return 0;
+    }
+    return 1;
+}
+
+NeuralNetwork* load_network_sparse(const char* filepath) {
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    ModelHeader header;
+    if (!model_read_header(file, &header, SPARSE_MODEL_MAGIC, MODEL_DTYPE_FLOAT64)) {
+        fprintf(stderr, "%s is not a supported sparse model file.\n", filepath);
+        fclose(file);
+        return NULL;
+    }
+
+    int num_layers = (int)header.num_layers;
+    uint32_t crc = 0;
+    int* architecture = model_read_architecture(file, num_layers, &crc);
+    SparseWeights* sparse = alloc_sparse_weights(num_layers);
+    double** biases = (double**)calloc(num_layers - 1, sizeof(double*));
+    int ok = architecture && sparse && biases;
+
+    uint64_t expected_size = sizeof(header) + num_layers * sizeof(int32_t);
+    for (int l = 0; ok && l < num_layers - 1; l++) {
+        int32_t nnz;
+        ok = model_read_block(file, &nnz, sizeof(nnz), &crc) && nnz >= 0 &&
+             (int64_t)nnz <= (int64_t)architecture[l] * architecture[l + 1];
+        CsrMatrix* csr = &sparse->layers[l];
+        ok = ok && alloc_csr(csr, architecture[l + 1], architecture[l], nnz);
+        biases[l] = ok ? (double*)malloc(csr->rows * sizeof(double)) : NULL;
+        ok = ok && biases[l] &&
+             model_read_block(file, csr->row_ptr, (csr->rows + 1) * sizeof(int32_t), &crc) &&
+             model_read_block(file, csr->col_idx, nnz * sizeof(int32_t), &crc) &&
+             model_read_block(file, csr->values, nnz * sizeof(double), &crc) &&
+             model_read_block(file, biases[l], csr->rows * sizeof(double), &crc) && csr_is_valid(csr);
+        if (ok) expected_size += sparse_layer_bytes(csr);
+    }
+    if (ok && expected_size != header.file_size) ok = 0;
+    if (ok && crc != header.crc32) {
+        fprintf(stderr, "Checksum mismatch in %s; the file is corrupt.\n", filepath);
+        ok = 0;
+    }
+    fclose(file);
+
+    // Densify for everything that reads Matrix weights, and keep the CSR
+    // copy for inference
+    NeuralNetwork* net = ok ? create_zeroed_network(num_layers, architecture) : NULL;
+    for (int l = 0; net && l < num_layers - 1; l++) {
+        const CsrMatrix* csr = &sparse->layers[l];
+        for (int j = 0; j < csr->rows; j++) {
+            for (int p = csr->row_ptr[j]; p < csr->row_ptr[j + 1]; p++) {
+                net->weights[l]->data[csr->col_idx[p]][j] = csr->values[p];
+            }
+            net->biases[l]->data[0][j] = biases[l][j];
+        }
+    }
+    if (net) {
+        net->sparse = sparse;
+        sparse = NULL;
+    }
+
+    for (int l = 0; biases && l < num_layers - 1; l++) free(biases[l]);
+    free(biases);
+    free_sparse_weights(sparse);
+    free(architecture);
+    return net;
+}
@@ -0,0 +1,61 @@
+#include "specialized_forward.h"
+#include <math.h>
+
+// --- Kernels ---
+
+// One fully connected sigmoid layer for a single row. With IN and OUT as
+// literals the compiler unrolls and vectorizes the inner loop over the
+// contiguous weight row. Terms are summed in the same order as dot_product
+// followed by add_bias, so results match the generic path exactly.
+#define LAYER_BODY(IN, OUT, in, weights, bias, out)                \
+    do {                                                           \
+        double acc[OUT] = {0};                                     \
+        for (int k = 0; k < (IN); k++) {                           \
+            const double x = (in)[k];                              \
+            const double* w = (weights) + (size_t)k * (OUT);       \
+            for (int j = 0; j < (OUT); j++) acc[j] += x * w[j];    \
+        }                                                          \
+        for (int j = 0; j < (OUT); j++) {                          \
+            (out)[j] = 1.0 / (1.0 + exp(-(acc[j] + (bias)[j])));   \
+        }                                                          \
+    } while (0)
+
+#define DEFINE_FORWARD_KERNEL(IN, HIDDEN, OUT)                                                      \
+    static void forward_##IN##_##HIDDEN##_##OUT(const NeuralNetwork* net, const double* input,       \
+                                               double* output, int rows) {                          \
+        const double* w0 = net->weights[0]->data[0];                                                 \
+        const double* b0 = net->biases[0]->data[0];                                                  \
+        const double* w1 = net->weights[1]->data[0];                                                 \
+        const double* b1 = net->biases[1]->data[0];                                                  \
+        for (int r = 0; r < rows; r++) {                                                             \
+            double hidden[HIDDEN];                                                                   \
+            LAYER_BODY(IN, HIDDEN, input + (size_t)r * (IN), w0, b0, hidden);                        \
+            LAYER_BODY(HIDDEN, OUT, hidden, w1, b1, output + (size_t)r * (OUT));                     \
+        }                                                                                            \
+    }
+
+SPECIALIZED_ARCHITECTURES(DEFINE_FORWARD_KERNEL)
+
+// --- Registry ---
+
+typedef struct {
+    int architecture[3];
+    ForwardKernel kernel;
+} KernelEntry;
+
+#define KERNEL_ENTRY(IN, HIDDEN, OUT) {{IN, HIDDEN, OUT}, forward_##IN##_##HIDDEN##_##OUT},
+
+static const KernelEntry kernel_registry[] = {
+    SPECIALIZED_ARCHITECTURES(KERNEL_ENTRY)
+};
+
+ForwardKernel find_forward_kernel(int num_layers, const int* architecture) {
+    if (num_layers != 3) return NULL;
+    for (size_t i = 0; i < sizeof(kernel_registry) / sizeof(kernel_registry[0]); i++) {
+        const int* entry = kernel_registry[i].architecture;
+        if (entry[0] == architecture[0] && entry[1] == architecture[1] && entry[2] == architecture[2]) {
+            return kernel_registry[i].kernel;
+        }
+    }
+    return NULL;
+}
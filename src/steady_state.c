@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "steady_state.h"
+#include "inference.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+void default_steady_state_config(SteadyStateConfig* config) {
+    config->population = 50;
+    config->evaluations = 5000;
+    config->tournament_size = 3;
+    config->mutation_rate = 0.05f;
+    config->mutation_chance = 0.1f;
+    config->num_samples = 1000;
+    config->threads = parallel_num_threads();
+    config->seed = 1;
+    config->report_every = 0;
+}
+
+typedef struct {
+    const SteadyStateConfig* config;
+    const Dataset* dataset;
+    int num_layers;
+    const int* architecture;
+    NetworkFitness* population;
+    pthread_rwlock_t lock;
+    atomic_long next_child;   // Tickets for the evaluation budget
+    atomic_long insertions;
+} SteadyState;
+
+typedef struct {
+    SteadyState* state;
+    Rng rng;
+    double lock_wait_seconds;
+} SteadyWorker;
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void score_initial_body(int begin, int end, void* context) {
+    SteadyState* state = (SteadyState*)context;
+    for (int i = begin; i < end; i++) {
+        NetworkFitness* member = &state->population[i];
+        member->fitness = network_accuracy(member->network, state->dataset, state->config->num_samples);
+    }
+}
+
+// Caller holds the lock for reading
+static const NeuralNetwork* tournament(const SteadyState* state, Rng* rng) {
+    int best = rng_below(rng, state->config->population);
+    for (int k = 1; k < state->config->tournament_size; k++) {
+        int contestant = rng_below(rng, state->config->population);
+        if (state->population[contestant].fitness > state->population[best].fitness) best = contestant;
+    }
+    return state->population[best].network;
+}
+
+// Caller holds the lock
+static double best_fitness_locked(const SteadyState* state) {
+    double best = state->population[0].fitness;
+    for (int i = 1; i < state->config->population; i++) {
+        if (state->population[i].fitness > best) best = state->population[i].fitness;
+    }
+    return best;
+}
+
+static void* steady_worker_main(void* arg) {
+    SteadyWorker* worker = (SteadyWorker*)arg;
+    SteadyState* state = worker->state;
+    const SteadyStateConfig* config = state->config;
+    struct timespec wait_start;
+
+    for (;;) {
+        long child_index = atomic_fetch_add(&state->next_child, 1);
+        if (child_index >= config->evaluations) break;
+
+        // The child is allocated before the lock is taken; the lock covers
+        // only the tournaments and the averaging. Parents are only read, so
+        // any number of workers breed at once.
+        NeuralNetwork* child = create_zeroed_network(state->num_layers, state->architecture);
+        if (!child) continue;
+        clock_gettime(CLOCK_MONOTONIC, &wait_start);
+        pthread_rwlock_rdlock(&state->lock);
+        worker->lock_wait_seconds += elapsed_seconds(&wait_start);
+        const NeuralNetwork* parent1 = tournament(state, &worker->rng);
+        const NeuralNetwork* parent2 = tournament(state, &worker->rng);
+        crossover_into(child, parent1, parent2);
+        pthread_rwlock_unlock(&state->lock);
+
+        mutate_network_rng(child, config->mutation_rate, config->mutation_chance, &worker->rng);
+        double fitness = network_accuracy(child, state->dataset, config->num_samples);
+
+        clock_gettime(CLOCK_MONOTONIC, &wait_start);
+        pthread_rwlock_wrlock(&state->lock);
+        worker->lock_wait_seconds += elapsed_seconds(&wait_start);
+        int worst = 0;
+        for (int i = 1; i < config->population; i++) {
+            if (state->population[i].fitness < state->population[worst].fitness) worst = i;
+        }
+        // Ties are replaced too, so the population can drift across plateaus
+        NeuralNetwork* discarded = child;
+        if (fitness >= state->population[worst].fitness) {
+            discarded = state->population[worst].network;
+            state->population[worst].network = child;
+            state->population[worst].fitness = fitness;
+            atomic_fetch_add(&state->insertions, 1);
+        }
+        double best = config->report_every > 0 && (child_index + 1) % config->report_every == 0
+                          ? best_fitness_locked(state)
+                          : -1.0;
+        pthread_rwlock_unlock(&state->lock);
+        free_neural_network(discarded);
+        if (best >= 0.0) {
+            printf("Children %ld/%ld | Best Accuracy: %.2f%%\n", child_index + 1, config->evaluations, best * 100.0);
+        }
+    }
+    return NULL;
+}
+
+NeuralNetwork* run_steady_state(const SteadyStateConfig* config, int num_layers, const int* architecture,
+                                const Dataset* dataset, SteadyStateStats* stats, double* best_fitness) {
+    if (config->population < 2 || config->evaluations < 0 || config->tournament_size < 1 || config->threads < 1 ||
+        config->num_samples < 1 || config->num_samples > dataset->num_items) {
+        return NULL;
+    }
+    SteadyState state;
+    state.config = config;
+    state.dataset = dataset;
+    state.num_layers = num_layers;
+    state.architecture = architecture;
+    atomic_init(&state.next_child, 0);
+    atomic_init(&state.insertions, 0);
+    state.population = (NetworkFitness*)calloc(config->population, sizeof(NetworkFitness));
+    SteadyWorker* workers = (SteadyWorker*)calloc(config->threads, sizeof(SteadyWorker));
+    pthread_t* threads = (pthread_t*)calloc(config->threads, sizeof(pthread_t));
+    int* started = (int*)calloc(config->threads, sizeof(int));
+    int ok = state.population && workers && threads && started && pthread_rwlock_init(&state.lock, NULL) == 0;
+    int lock_ready = ok;
+    // The first networks come from a stream of their own, after the workers'
+    Rng init_rng;
+    rng_seed_stream(&init_rng, config->seed, (uint64_t)config->threads);
+    NeuralNetwork** initial =
+        ok ? create_initial_population_rng(config->population, num_layers, architecture, &init_rng) : NULL;
+    ok = initial != NULL;
+    for (int i = 0; ok && i < config->population; i++) state.population[i].network = initial[i];
+    free(initial);
+
+    NeuralNetwork* best = NULL;
+    SteadyStateStats result = {0};
+    if (ok) {
+        parallel_for(config->population, 1, score_initial_body, &state);
+        result.initial_best_fitness = best_fitness_locked(&state);
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int t = 0; t < config->threads; t++) {
+            workers[t].state = &state;
+            rng_seed_stream(&workers[t].rng, config->seed, (uint64_t)t);
+            started[t] = pthread_create(&threads[t], NULL, steady_worker_main, &workers[t]) == 0;
+        }
+        int running = 0;
+        for (int t = 0; t < config->threads; t++) running += started[t];
+        if (!running) steady_worker_main(&workers[0]);
+        for (int t = 0; t < config->threads; t++) {
+            if (started[t]) pthread_join(threads[t], NULL);
+            result.lock_wait_seconds += workers[t].lock_wait_seconds;
+        }
+        result.seconds = elapsed_seconds(&start);
+
+        int fittest = 0;
+        for (int i = 1; i < config->population; i++) {
+            if (state.population[i].fitness > state.population[fittest].fitness) fittest = i;
+        }
+        best = clone_network(state.population[fittest].network);
+        result.best_fitness = state.population[fittest].fitness;
+        long claimed = atomic_load(&state.next_child);
+        result.evaluations = claimed < config->evaluations ? claimed : config->evaluations;
+        result.insertions = atomic_load(&state.insertions);
+    }
+
+    if (stats) *stats = result;
+    if (best_fitness) *best_fitness = result.best_fitness;
+    for (int i = 0; state.population && i < config->population; i++) {
+        free_neural_network(state.population[i].network);
+    }
+    if (lock_ready) pthread_rwlock_destroy(&state.lock);
+    free(state.population);
+    free(workers);
+    free(threads);
+    free(started);
+    return best;
+}
@@ -0,0 +1,99 @@
+#include "synthetic_dataset.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include "parallel.h"
+#include "rng.h"
+
+// RNG stream indices: class centers use streams [0, num_classes), samples
+// use streams offset by SAMPLE_STREAM_BASE so the two never overlap
+#define SAMPLE_STREAM_BASE (1ULL << 32)
+
+// Shared state of a parallel generation job
+typedef struct {
+    const SyntheticConfig* config;
+    const double* centers; // num_classes * input_size, or NULL when unclustered
+    Dataset* dataset;
+} SyntheticJob;
+
+static double clamp_unit(double x) {
+    if (x < 0.0) return 0.0;
+    if (x > 1.0) return 1.0;
+    return x;
+}
+
+// Generates samples [begin, end)
+static void generate_samples(int begin, int end, void* context) {
+    SyntheticJob* job = (SyntheticJob*)context;
+    const SyntheticConfig* config = job->config;
+
+    for (int i = begin; i < end; i++) {
+        Rng rng;
+        rng_seed_stream(&rng, config->seed, SAMPLE_STREAM_BASE + (uint64_t)i);
+
+        int label = (int)rng_below(&rng, (uint32_t)config->num_classes);
+        double* row = job->dataset->images->data[i];
+        if (job->centers) {
+            // Zeroed center values stay zero, so sparsity is a per-class pattern
+            const double* center = job->centers + (size_t)label * config->input_size;
+            for (int j = 0; j < config->input_size; j++) {
+                row[j] = center[j] == 0.0 ? 0.0 : clamp_unit(center[j] + config->cluster_spread * rng_gaussian(&rng));
+            }
+        } else {
+            for (int j = 0; j < config->input_size; j++) {
+                double value = rng_uniform(&rng);
+                row[j] = rng_uniform(&rng) < config->sparsity ? 0.0 : value;
+            }
+        }
+        job->dataset->label_indices[i] = (unsigned char)label;
+        job->dataset->labels->data[i][label] = 1.0;
+    }
+}
+
+// Returns a config matching MNIST's shape with learnable clusters
+SyntheticConfig default_synthetic_config(int num_items, uint64_t seed) {
+    SyntheticConfig config;
+    config.num_items = num_items;
+    config.input_size = MNIST_IMAGE_SIZE;
+    config.num_classes = MNIST_NUM_CLASSES;
+    config.sparsity = 0.8; // Roughly the fraction of blank MNIST pixels
+    config.clustered = 1;
+    config.cluster_spread = 0.2;
+    config.seed = seed;
+    return config;
+}
+
+// Generates a dataset in parallel from the given config
+Dataset* create_synthetic_dataset(const SyntheticConfig* config) {
+    if (config->num_items < 0 || config->input_size <= 0 ||
+        config->num_classes <= 0 || config->num_classes > 256 ||
+        config->sparsity < 0.0 || config->sparsity >= 1.0) {
+        fprintf(stderr, "Invalid synthetic dataset configuration.\n");
+        return NULL;
+    }
+
+    Dataset* dataset = create_dataset(config->num_items, config->input_size, config->num_classes);
+    if (!dataset) return NULL;
+
+    double* centers = NULL;
+    if (config->clustered) {
+        centers = (double*)malloc((size_t)config->num_classes * config->input_size * sizeof(double));
+        if (!centers) {
+            free_dataset(dataset);
+            return NULL;
+        }
+        for (int c = 0; c < config->num_classes; c++) {
+            Rng rng;
+            rng_seed_stream(&rng, config->seed, (uint64_t)c);
+            for (int j = 0; j < config->input_size; j++) {
+                double value = rng_uniform(&rng);
+                centers[(size_t)c * config->input_size + j] = rng_uniform(&rng) < config->sparsity ? 0.0 : value;
+            }
+        }
+    }
+
+    SyntheticJob job = {config, centers, dataset};
+    parallel_for(config->num_items, 256, generate_samples, &job);
+
+    free(centers);
+    return dataset;
+}
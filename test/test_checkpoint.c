@@ -0,0 +1,58 @@
+#include "minunit.h"
+#include "../include/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+
+const char* test_checkpoint_roundtrip() {
+    int architecture[] = {4, 3, 2};
+    NeuralNetwork* population[3];
+    double fitness[3] = {0.25, 0.5, 0.75};
+    for (int i = 0; i < 3; i++) population[i] = create_neural_network(3, architecture);
+
+    EvolutionState* snapshot = snapshot_evolution_state(population, fitness, 3);
+    mu_assert("Failed to snapshot the population", snapshot != NULL);
+    snapshot->generation = 7;
+    snapshot->num_generations = 100;
+    snapshot->mutation_rate = 0.05f;
+    snapshot->mutation_chance = 0.1f;
+    snapshot->fitness_samples = 1000;
+    snapshot->rng_seed = 12345u;
+
+    // The background writer must leave a complete file once stopped
+    const char* filepath = "test_checkpoint.ckpt";
+    CheckpointWriter* writer = start_checkpoint_writer(filepath);
+    mu_assert("Failed to start the checkpoint writer", writer != NULL);
+    checkpoint_writer_submit(writer, snapshot);
+    stop_checkpoint_writer(writer);
+
+    EvolutionState* loaded = load_checkpoint(filepath);
+    mu_assert("Failed to load checkpoint", loaded != NULL);
+    mu_assert("Checkpoint has wrong generation", loaded->generation == 7);
+    mu_assert("Checkpoint has wrong population size", loaded->population_size == 3);
+    mu_assert("Checkpoint has wrong seed", loaded->rng_seed == 12345u);
+    mu_assert("Checkpoint has wrong mutation rate", loaded->mutation_rate == 0.05f);
+    for (int n = 0; n < 3; n++) {
+        mu_assert("Checkpoint has wrong fitness", loaded->fitness[n] == fitness[n]);
+        for (int i = 0; i < 2; i++) {
+            const Matrix* a = population[n]->weights[i];
+            const Matrix* b = loaded->population[n]->weights[i];
+            mu_assert("Checkpoint has wrong weights",
+                      memcmp(a->data[0], b->data[0], a->rows * a->cols * sizeof(double)) == 0);
+            mu_assert("Checkpoint has wrong biases",
+                      memcmp(population[n]->biases[i]->data[0], loaded->population[n]->biases[i]->data[0],
+                             population[n]->biases[i]->cols * sizeof(double)) == 0);
+        }
+    }
+    free_evolution_state(loaded);
+
+    // A damaged checkpoint is rejected rather than resumed from
+    FILE* file = fopen(filepath, "r+b");
+    fseek(file, 80, SEEK_SET);
+    fputc(0x5A, file);
+    fclose(file);
+    mu_assert("Corrupt checkpoint was accepted", load_checkpoint(filepath) == NULL);
+
+    remove(filepath);
+    for (int i = 0; i < 3; i++) free_neural_network(population[i]);
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include "minunit.h"
+#include "../include/data_loader.h"
+#include "../include/dataset_stream.h"
+#include "../include/synthetic_dataset.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+extern const double TEST_EPSILON;
+
+const char* test_dataset_cache_roundtrip() {
+    Dataset* original = create_dummy_dataset(5);
+    mu_assert("Failed to create dummy dataset", original != NULL);
+
+    const char* filepath = "test_dataset.cache";
+    mu_assert("Unsupported precision was accepted", save_dataset_cache(original, filepath, 2) == 0);
+
+    // Float64 caches are exact; float32 caches hold each pixel rounded to float
+    const int dtype_sizes[] = {sizeof(double), sizeof(float)};
+    for (int d = 0; d < 2; d++) {
+        mu_assert("Failed to save dataset cache", save_dataset_cache(original, filepath, dtype_sizes[d]) == 1);
+
+        Dataset* mapped = map_dataset_cache(filepath);
+        mu_assert("Failed to map dataset cache", mapped != NULL);
+        mu_assert("Mapped dataset has wrong size", mapped->num_items == original->num_items);
+        mu_assert("Mapped images have wrong width", mapped->images->cols == MNIST_IMAGE_SIZE);
+        mu_assert("Mapped labels have wrong width", mapped->labels->cols == MNIST_NUM_CLASSES);
+
+        for (int i = 0; i < original->num_items; i++) {
+            for (int j = 0; j < MNIST_IMAGE_SIZE; j++) {
+                double expected = original->images->data[i][j];
+                if (dtype_sizes[d] == sizeof(float)) expected = (float)expected;
+                double diff = fabs(expected - mapped->images->data[i][j]);
+                mu_assert("Mapped dataset has wrong pixels", diff < TEST_EPSILON);
+            }
+            mu_assert("Mapped dataset has wrong label index", original->label_indices[i] == mapped->label_indices[i]);
+            mu_assert("Mapped dataset has wrong one-hot label",
+                      mapped->labels->data[i][mapped->label_indices[i]] == 1.0);
+        }
+        free_dataset(mapped);
+    }
+
+    free_dataset(original);
+    remove(filepath);
+
+    return NULL;
+}
+
+// Writes a tiny IDX image/label pair where every pixel of record i equals i
+static int write_test_idx_files(const char* image_path, const char* label_path, int num_items) {
+    FILE* image_file = fopen(image_path, "wb");
+    FILE* label_file = fopen(label_path, "wb");
+    if (!image_file || !label_file) {
+        if (image_file) fclose(image_file);
+        if (label_file) fclose(label_file);
+        return 0;
+    }
+    unsigned char image_header[16] = {0, 0, 8, 3, 0, 0, 0, (unsigned char)num_items, 0, 0, 0, 28, 0, 0, 0, 28};
+    unsigned char label_header[8] = {0, 0, 8, 1, 0, 0, 0, (unsigned char)num_items};
+    fwrite(image_header, 1, sizeof(image_header), image_file);
+    fwrite(label_header, 1, sizeof(label_header), label_file);
+    unsigned char pixels[MNIST_IMAGE_SIZE];
+    for (int i = 0; i < num_items; i++) {
+        for (int j = 0; j < MNIST_IMAGE_SIZE; j++) pixels[j] = (unsigned char)i;
+        unsigned char label = (unsigned char)(i % MNIST_NUM_CLASSES);
+        fwrite(pixels, 1, sizeof(pixels), image_file);
+        fwrite(&label, 1, 1, label_file);
+    }
+    fclose(image_file);
+    fclose(label_file);
+    return 1;
+}
+
+const char* test_load_mnist_range_and_subset() {
+    const char* image_path = "test_images.idx3";
+    const char* label_path = "test_labels.idx1";
+    mu_assert("Failed to write test IDX files", write_test_idx_files(image_path, label_path, 20));
+
+    Dataset* range = load_mnist_range(image_path, label_path, 5, 3);
+    mu_assert("Range load failed", range != NULL);
+    mu_assert("Range has wrong size", range->num_items == 3);
+    mu_assert("Range has wrong first pixel", fabs(range->images->data[0][0] - 5.0 / 255.0) < TEST_EPSILON);
+    mu_assert("Range has wrong last label", range->label_indices[2] == 7);
+    mu_assert("Range one-hot label is wrong", range->labels->data[2][7] == 1.0);
+    free_dataset(range);
+
+    mu_assert("Out-of-range load should fail", load_mnist_range(image_path, label_path, 18, 3) == NULL);
+
+    int indices[] = {12, 3, 4, 19};
+    Dataset* subset = load_mnist_subset(image_path, label_path, indices, 4);
+    mu_assert("Subset load failed", subset != NULL);
+    for (int i = 0; i < 4; i++) {
+        mu_assert("Subset has wrong pixels", fabs(subset->images->data[i][MNIST_IMAGE_SIZE - 1] - indices[i] / 255.0) < TEST_EPSILON);
+        mu_assert("Subset has wrong labels", subset->label_indices[i] == indices[i] % MNIST_NUM_CLASSES);
+    }
+    free_dataset(subset);
+
+    PagedDataset* paged = open_paged_dataset(image_path, label_path, 8);
+    mu_assert("Paged open failed", paged != NULL);
+    mu_assert("Paged dataset should start empty", paged->resident_pages == 0);
+    const double* image = paged_dataset_image(paged, 17);
+    mu_assert("Paged image is wrong", image != NULL && fabs(image[0] - 17.0 / 255.0) < TEST_EPSILON);
+    mu_assert("Paged label is wrong", paged_dataset_label(paged, 17) == 7);
+    mu_assert("Only one page should be resident", paged->resident_pages == 1);
+    close_paged_dataset(paged);
+
+    remove(image_path);
+    remove(label_path);
+    return NULL;
+}
+
+static void put_big_endian(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+// Pixel j of record i in the parallel decode test
+static unsigned char decode_test_pixel(int i, int j) {
+    return (unsigned char)((i * 131 + j * 29 + (i >> 3)) & 0xff);
+}
+
+const char* test_parallel_decode_matches_scalar() {
+    const char* image_path = "test_decode_images.idx3";
+    const char* label_path = "test_decode_labels.idx1";
+    // 5x7 pixels is not a multiple of the 16-pixel SSE2 step, so every
+    // record ends in the scalar tail and most start unaligned
+    const int rows = 5, cols = 7, image_size = rows * cols;
+    const int threads = 4;
+    const int num_items = DECODE_MIN_RECORDS_PER_THREAD * threads + 77;
+
+    FILE* image_file = fopen(image_path, "wb");
+    FILE* label_file = fopen(label_path, "wb");
+    mu_assert("Failed to open test IDX files", image_file != NULL && label_file != NULL);
+    unsigned char image_header[16], label_header[8];
+    put_big_endian(image_header, 2051);
+    put_big_endian(image_header + 4, (uint32_t)num_items);
+    put_big_endian(image_header + 8, (uint32_t)rows);
+    put_big_endian(image_header + 12, (uint32_t)cols);
+    put_big_endian(label_header, 2049);
+    put_big_endian(label_header + 4, (uint32_t)num_items);
+    fwrite(image_header, 1, sizeof(image_header), image_file);
+    fwrite(label_header, 1, sizeof(label_header), label_file);
+    unsigned char pixels[5 * 7];
+    for (int i = 0; i < num_items; i++) {
+        for (int j = 0; j < image_size; j++) pixels[j] = decode_test_pixel(i, j);
+        unsigned char label = (unsigned char)(i % MNIST_NUM_CLASSES);
+        fwrite(pixels, 1, sizeof(pixels), image_file);
+        fwrite(&label, 1, 1, label_file);
+    }
+    fclose(image_file);
+    fclose(label_file);
+
+    setenv("GENNET_THREADS", "4", 1);
+    Dataset* full = load_mnist_dataset(image_path, label_path);
+    Dataset* range = load_mnist_range(image_path, label_path, 1001, num_items - 1001);
+    unsetenv("GENNET_THREADS");
+    mu_assert("Parallel decode failed", full != NULL && range != NULL);
+    mu_assert("Parallel decode has wrong shape", full->num_items == num_items && full->images->cols == image_size);
+
+    for (int i = 0; i < num_items; i++) {
+        mu_assert("Parallel decode has wrong labels", full->label_indices[i] == i % MNIST_NUM_CLASSES);
+        for (int j = 0; j < image_size; j++) {
+            double expected = (double)decode_test_pixel(i, j) / 255.0;
+            mu_assert("Parallel decode differs from scalar", full->images->data[i][j] == expected);
+            if (i >= 1001) {
+                mu_assert("Parallel range decode differs from scalar", range->images->data[i - 1001][j] == expected);
+            }
+        }
+    }
+
+    free_dataset(full);
+    free_dataset(range);
+    remove(image_path);
+    remove(label_path);
+    return NULL;
+}
+
+const char* test_dataset_stream_batches() {
+    const char* image_path = "test_stream_images.idx3";
+    const char* label_path = "test_stream_labels.idx1";
+    mu_assert("Failed to write test IDX files", write_test_idx_files(image_path, label_path, 20));
+
+    DatasetStream* stream = open_dataset_stream(image_path, label_path, 8);
+    mu_assert("Stream open failed", stream != NULL);
+    mu_assert("Stream has wrong size", dataset_stream_num_items(stream) == 20);
+
+    for (int pass = 0; pass < 2; pass++) {
+        int expected_sizes[] = {8, 8, 4};
+        int record = 0;
+        for (int b = 0; b < 3; b++) {
+            const Dataset* batch = dataset_stream_next(stream);
+            mu_assert("Stream ended early", batch != NULL);
+            mu_assert("Stream batch has wrong size", batch->num_items == expected_sizes[b]);
+            for (int i = 0; i < batch->num_items; i++, record++) {
+                mu_assert("Stream batch has wrong pixels", fabs(batch->images->data[i][0] - record / 255.0) < TEST_EPSILON);
+                mu_assert("Stream batch has wrong labels", batch->label_indices[i] == record % MNIST_NUM_CLASSES);
+            }
+        }
+        mu_assert("Stream should be exhausted", dataset_stream_next(stream) == NULL);
+        dataset_stream_rewind(stream);
+    }
+
+    close_dataset_stream(stream);
+    remove(image_path);
+    remove(label_path);
+    return NULL;
+}
+
+const char* test_synthetic_dataset_is_deterministic() {
+    SyntheticConfig config = default_synthetic_config(600, 7);
+    config.input_size = 16;
+    config.num_classes = 3;
+
+    setenv("GENNET_THREADS", "1", 1);
+    Dataset* serial = create_synthetic_dataset(&config);
+    setenv("GENNET_THREADS", "4", 1);
+    Dataset* parallel = create_synthetic_dataset(&config);
+    unsetenv("GENNET_THREADS");
+    mu_assert("Synthetic generation failed", serial != NULL && parallel != NULL);
+    mu_assert("Synthetic dataset has wrong shape", serial->images->cols == 16 && serial->labels->cols == 3);
+
+    for (int i = 0; i < config.num_items; i++) {
+        mu_assert("Synthetic labels depend on thread count", serial->label_indices[i] == parallel->label_indices[i]);
+        mu_assert("Synthetic label out of range", serial->label_indices[i] < 3);
+        for (int j = 0; j < config.input_size; j++) {
+            mu_assert("Synthetic pixels depend on thread count", serial->images->data[i][j] == parallel->images->data[i][j]);
+            mu_assert("Synthetic pixel out of range", serial->images->data[i][j] >= 0.0 && serial->images->data[i][j] <= 1.0);
+        }
+    }
+
+    free_dataset(serial);
+    free_dataset(parallel);
+    return NULL;
+}
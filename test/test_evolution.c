@@ -1,6 +1,14 @@
 #include "minunit.h"
 #include "../include/evolution.h"
+#include "../include/island.h"
+#include "../include/distributed.h"
+#include "../include/steady_state.h"
+#include "../include/inference.h"
+#include "../include/synthetic_dataset.h"
 #include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
 
 extern const double TEST_EPSILON;
 
@@ -28,9 +36,273 @@ const char* test_crossover() {
     double actual_bias = child->biases[0]->data[0][0];
     mu_assert("Crossover bias calculation is incorrect", fabs(actual_bias - expected_bias) < TEST_EPSILON);
 
+    // Children and clones overwrite every parameter, so neither draws from
+    // rand(), whose lock would serialize threads breeding at once
+    srand(7);
+    int expected_draw = rand();
+    srand(7);
+    NeuralNetwork* second_child = crossover(parent1, parent2);
+    NeuralNetwork* copy = clone_network(child);
+    mu_assert("Crossover or clone drew from rand()", rand() == expected_draw);
+    mu_assert("Clone differs from its source", copy->weights[0]->data[0][0] == child->weights[0]->data[0][0]);
+    free_neural_network(second_child);
+    free_neural_network(copy);
+
     free_neural_network(parent1);
     free_neural_network(parent2);
     free_neural_network(child);
 
     return NULL;
 }
+
+const char* test_quantized_crossover_and_mutation() {
+    int architecture[] = {2, 2, 1};
+    QuantizedNetwork* parent1 = create_quantized_genome(3, architecture);
+    QuantizedNetwork* parent2 = create_quantized_genome(3, architecture);
+    mu_assert("Failed to create genomes", parent1 != NULL && parent2 != NULL);
+    float scale = parent1->scales[0][0];
+
+    // Averages round half away from zero
+    parent1->weights[0][0] = 3;
+    parent2->weights[0][0] = 6;
+    parent1->weights[0][1] = -3;
+    parent2->weights[0][1] = -6;
+    parent1->biases[0][0] = 2 * scale;
+    parent2->biases[0][0] = 5 * scale;
+
+    QuantizedNetwork* child = crossover_quantized(parent1, parent2);
+    mu_assert("Quantized crossover failed to create a child", child != NULL);
+    mu_assert("Quantized crossover weight is not the rounded average", child->weights[0][0] == 5);
+    mu_assert("Negative average rounds the wrong way", child->weights[0][1] == -5);
+    mu_assert("Quantized crossover bias is not a rounded step", child->biases[0][0] == 4 * scale);
+
+    // Mutation moves every parameter by whole steps and keeps int8 bounds
+    child->weights[0][0] = 127;
+    mutate_quantized_network(child, 1000.0f, 1.0f);
+    mu_assert("Mutation escaped the int8 range", child->weights[0][0] >= -127 && child->weights[0][0] <= 127);
+    double steps = child->biases[0][0] / scale;
+    mu_assert("Mutated bias is not a whole step", fabs(steps - lrint(steps)) < 1e-3);
+    mu_assert("Padding weights must stay zero", child->weights[0][2] == 0);
+
+    free_quantized_network(parent1);
+    free_quantized_network(parent2);
+    free_quantized_network(child);
+    return NULL;
+}
+
+const char* test_migration_queue_is_fifo() {
+    int architecture[] = {2, 2, 1};
+    MigrationQueue queue;
+    mu_assert("Failed to create the queue", init_migration_queue(&queue, 3));
+    mu_assert("Capacity is not rounded to a power of two", queue.capacity == 4);
+
+    NetworkFitness migrant;
+    mu_assert("A fresh queue is not empty", !migration_queue_pop(&queue, &migrant));
+    for (int i = 0; i < 4; i++) {
+        NetworkFitness entry = {create_neural_network(3, architecture), i};
+        mu_assert("Push failed below capacity", migration_queue_push(&queue, entry));
+    }
+    NetworkFitness extra = {create_neural_network(3, architecture), 4};
+    mu_assert("Push succeeded into a full queue", !migration_queue_push(&queue, extra));
+    free_neural_network(extra.network);
+
+    // Wraps around after the first pops
+    for (int i = 0; i < 2; i++) {
+        mu_assert("Pop failed", migration_queue_pop(&queue, &migrant));
+        mu_assert("Queue is not first in, first out", migrant.fitness == i);
+        free_neural_network(migrant.network);
+    }
+    NetworkFitness wrapped = {create_neural_network(3, architecture), 4};
+    mu_assert("Push failed after wrapping", migration_queue_push(&queue, wrapped));
+    mu_assert("Pop failed", migration_queue_pop(&queue, &migrant));
+    mu_assert("Queue is not first in, first out", migrant.fitness == 2);
+    free_neural_network(migrant.network);
+
+    // The remaining networks are freed with the queue
+    destroy_migration_queue(&queue);
+    return NULL;
+}
+
+const char* test_islands_exchange_migrants() {
+    SyntheticConfig data_config = default_synthetic_config(200, 11);
+    data_config.input_size = 12;
+    data_config.num_classes = 4;
+    Dataset* dataset = create_synthetic_dataset(&data_config);
+    mu_assert("Failed to create dataset", dataset != NULL);
+    int architecture[] = {12, 8, 4};
+
+    const MigrationTopology topologies[] = {MIGRATION_RING, MIGRATION_ALL_TO_ALL};
+    for (int t = 0; t < 2; t++) {
+        IslandConfig config;
+        default_island_config(&config);
+        config.num_islands = 3;
+        config.population = 6;
+        config.generations = 8;
+        config.migration_interval = 1;
+        config.migrants = 1;
+        config.topology = topologies[t];
+        config.num_samples = 200;
+
+        IslandStats stats[3];
+        double best_fitness = -1.0;
+        NeuralNetwork* best = run_islands(&config, 3, architecture, dataset, stats, &best_fitness);
+        mu_assert("Island evolution failed", best != NULL);
+
+        long sent = 0;
+        double best_island = 0.0;
+        for (int i = 0; i < 3; i++) {
+            mu_assert("An island skipped generations", stats[i].evaluations == 6 * 8);
+            sent += stats[i].migrants_sent;
+            if (stats[i].best_fitness > best_island) best_island = stats[i].best_fitness;
+        }
+        // Each island emigrates after every generation but the last
+        long expected = 3 * 7 * (config.topology == MIGRATION_RING ? 1 : 2);
+        mu_assert("Emigrations went missing", sent + stats[0].migrants_dropped + stats[1].migrants_dropped +
+                  stats[2].migrants_dropped >= expected);
+        mu_assert("No migrant was sent", sent > 0);
+        mu_assert("Best network is not the best island's", best_fitness == best_island);
+
+        PackedNetwork* packed = pack_network(best);
+        int correct = 0;
+        for (int i = 0; i < 200; i++) {
+            if (predict_class(packed, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+        }
+        free_packed_network(packed);
+        mu_assert("Returned network does not score its fitness", fabs(correct / 200.0 - best_fitness) < 1e-12);
+        free_neural_network(best);
+    }
+
+    free_dataset(dataset);
+    return NULL;
+}
+
+const char* test_steady_state_never_loses_the_best() {
+    SyntheticConfig data_config = default_synthetic_config(200, 13);
+    data_config.input_size = 12;
+    data_config.num_classes = 4;
+    Dataset* dataset = create_synthetic_dataset(&data_config);
+    mu_assert("Failed to create dataset", dataset != NULL);
+    int architecture[] = {12, 8, 4};
+
+    SteadyStateConfig config;
+    default_steady_state_config(&config);
+    config.population = 8;
+    config.evaluations = 120;
+    config.num_samples = 200;
+    config.threads = 3;
+    SteadyStateStats stats;
+    double best_fitness = -1.0;
+    NeuralNetwork* best = run_steady_state(&config, 3, architecture, dataset, &stats, &best_fitness);
+    mu_assert("Steady-state evolution failed", best != NULL);
+    mu_assert("Workers did not spend the whole budget", stats.evaluations == 120);
+    mu_assert("More insertions than children", stats.insertions >= 0 && stats.insertions <= 120);
+    mu_assert("Best fitness dropped below the initial population's",
+              best_fitness >= stats.initial_best_fitness && best_fitness == stats.best_fitness);
+
+    PackedNetwork* packed = pack_network(best);
+    int correct = 0;
+    for (int i = 0; i < 200; i++) {
+        if (predict_class(packed, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+    }
+    free_packed_network(packed);
+    mu_assert("Returned network does not score its fitness", fabs(correct / 200.0 - best_fitness) < 1e-12);
+
+    free_neural_network(best);
+    free_dataset(dataset);
+    return NULL;
+}
+
+typedef struct {
+    const char* address;
+    const Dataset* dataset;
+    const Dataset* foreign_dataset; // Same shape, other records
+    long foreign_scored;
+    long first_scored;
+    long second_scored;
+} WorkerThread;
+
+// A worker holding other records is turned away. The next one quits after
+// one genome, abandoning the rest of its batches; a third connects
+// afterwards and finishes the run.
+static void* worker_thread_main(void* arg) {
+    WorkerThread* worker = (WorkerThread*)arg;
+    worker->foreign_scored = run_worker(worker->address, worker->foreign_dataset, 0);
+    worker->first_scored = run_worker(worker->address, worker->dataset, 1);
+    worker->second_scored = run_worker(worker->address, worker->dataset, 0);
+    return NULL;
+}
+
+// Accuracy of the network after the float32 round trip workers apply
+static double rounded_accuracy(const NeuralNetwork* net, const Dataset* dataset, int num_samples) {
+    size_t count = network_num_params(net);
+    double* params = (double*)malloc(count * sizeof(double));
+    NeuralNetwork* rounded = clone_network(net);
+    flatten_network(net, params);
+    for (size_t p = 0; p < count; p++) params[p] = (float)params[p];
+    unflatten_network(rounded, params);
+    PackedNetwork* packed = pack_network(rounded);
+    int correct = 0;
+    for (int i = 0; i < num_samples; i++) {
+        if (predict_class(packed, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+    }
+    free_packed_network(packed);
+    free_neural_network(rounded);
+    free(params);
+    return (double)correct / num_samples;
+}
+
+const char* test_distributed_evaluation_requeues_lost_work() {
+    SyntheticConfig data_config = default_synthetic_config(100, 5);
+    data_config.input_size = 12;
+    data_config.num_classes = 4;
+    Dataset* dataset = create_synthetic_dataset(&data_config);
+    data_config.seed = 6;
+    Dataset* foreign = create_synthetic_dataset(&data_config);
+    mu_assert("Failed to create dataset", dataset != NULL && foreign != NULL);
+    mu_assert("Different records share a fingerprint",
+              dataset_fingerprint(dataset, 100) != dataset_fingerprint(foreign, 100));
+    int architecture[] = {12, 8, 4};
+    NetworkFitness population[10];
+    for (int i = 0; i < 10; i++) {
+        population[i].network = create_neural_network(3, architecture);
+        population[i].fitness = -1.0;
+    }
+
+    char address[64];
+    snprintf(address, sizeof(address), "unix:/tmp/gennet_test_%d.sock", (int)getpid());
+    DistributedMaster* master = start_master(address, 3, architecture, 100, 4, dataset, 0);
+    mu_assert("Failed to start the master", master != NULL);
+    WorkerThread worker = {address, dataset, foreign, 0, 0, 0};
+    pthread_t thread;
+    mu_assert("Failed to start the worker", pthread_create(&thread, NULL, worker_thread_main, &worker) == 0);
+    mu_assert("Distributed evaluation failed", distributed_evaluate(master, population, 10));
+    DistributedStats stats;
+    distributed_stats(master, &stats);
+    stop_master(master);
+    pthread_join(thread, NULL);
+
+    mu_assert("Worker with other records was not turned away", worker.foreign_scored == -1);
+    mu_assert("First worker did not stop after one genome", worker.first_scored == 1);
+    mu_assert("Second worker did not finish the population", worker.second_scored == 9);
+    mu_assert("Abandoned genomes were not re-queued", stats.jobs_requeued >= 1);
+    mu_assert("Sent genomes do not add up", stats.jobs_sent == 10 + stats.jobs_requeued);
+    for (int i = 0; i < 10; i++) {
+        mu_assert("Worker fitness differs from a local evaluation",
+                  population[i].fitness == rounded_accuracy(population[i].network, dataset, 100));
+    }
+
+    // Without workers a master allowed to score locally does so
+    master = start_master(address, 3, architecture, 100, 4, dataset, 1);
+    mu_assert("Failed to restart the master", master != NULL);
+    mu_assert("Local evaluation failed", distributed_evaluate(master, population, 10));
+    distributed_stats(master, &stats);
+    stop_master(master);
+    mu_assert("The master did not score locally", stats.jobs_local == 10 && stats.jobs_sent == 0);
+    for (int i = 0; i < 10; i++) {
+        mu_assert("Local fitness differs", population[i].fitness == rounded_accuracy(population[i].network, dataset, 100));
+        free_neural_network(population[i].network);
+    }
+    free_dataset(dataset);
+    free_dataset(foreign);
+    return NULL;
+}
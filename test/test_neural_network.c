@@ -1,6 +1,12 @@
 #include "minunit.h"
 #include "../include/neural_network.h"
+#include "../include/specialized_forward.h"
+#include "../include/inference.h"
+#include "../include/sparse_network.h"
+#include "../include/model_format.h"
+#include <stdio.h>
 #include <math.h>
+#include <string.h>
 
 extern const double TEST_EPSILON;
 
@@ -81,3 +87,158 @@ const char* test_nn_forward_pass() {
 
     return NULL;
 }
+
+// The compiled-in kernels must reproduce the generic layer-by-layer path bit for bit
+const char* test_specialized_forward_matches_generic() {
+    int small[] = {2, 2, 1};
+    mu_assert("Unregistered architecture found a kernel", find_forward_kernel(3, small) == NULL);
+
+    int architecture[] = {784, 128, 10};
+    mu_assert("Default architecture has no kernel", find_forward_kernel(3, architecture) != NULL);
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    Matrix* input = create_matrix(3, 784);
+    for (int r = 0; r < input->rows; r++) {
+        for (int c = 0; c < input->cols; c++) input->data[r][c] = ((r * 784 + c) % 255) / 255.0;
+    }
+
+    Matrix* generic = create_matrix(input->rows, input->cols);
+    memcpy(generic->data[0], input->data[0], input->rows * input->cols * sizeof(double));
+    for (int i = 0; i < net->num_layers - 1; i++) {
+        Matrix* next = dot_product(generic, net->weights[i]);
+        add_bias(next, net->biases[i]);
+        apply_sigmoid(next);
+        free_matrix(generic);
+        generic = next;
+    }
+
+    Matrix* output = forward_pass(net, input);
+    mu_assert("Specialized forward pass returned NULL", output != NULL);
+    mu_assert("Specialized forward pass has wrong shape", output->rows == 3 && output->cols == 10);
+    mu_assert("Specialized forward pass differs from the generic path",
+              memcmp(output->data[0], generic->data[0], 3 * 10 * sizeof(double)) == 0);
+
+    free_matrix(output);
+    free_matrix(generic);
+    free_matrix(input);
+    free_neural_network(net);
+    return NULL;
+}
+
+// The packed single-sample path must reproduce forward_pass exactly, including odd layer widths
+const char* test_packed_forward_matches_forward_pass() {
+    int architecture[] = {13, 11, 3};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    PackedNetwork* packed = pack_network(net);
+    mu_assert("Failed to pack network", packed != NULL);
+
+    Matrix* input = create_matrix(1, 13);
+    for (int c = 0; c < 13; c++) input->data[0][c] = c / 13.0 - 0.5;
+    Matrix* expected = forward_pass(net, input);
+
+    double output[3];
+    packed_forward(packed, input->data[0], output);
+    mu_assert("Packed forward pass differs from forward_pass",
+              memcmp(output, expected->data[0], sizeof(output)) == 0);
+
+    packed->prefetch_distance = 4;
+    int best = 0;
+    for (int j = 1; j < 3; j++) if (expected->data[0][j] > expected->data[0][best]) best = j;
+    mu_assert("Packed prediction is wrong", predict_class(packed, input->data[0]) == best);
+
+    free_matrix(expected);
+    free_matrix(input);
+    free_packed_network(packed);
+    free_neural_network(net);
+    return NULL;
+}
+
+// Top-k must rank classes by their output like a full sort would, best first
+const char* test_predict_top_k_orders_classes() {
+    int architecture[] = {6, 5, 10};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    PackedNetwork* packed = pack_network(net);
+    double input[6] = {0.1, 0.9, 0.3, 0.7, 0.5, 0.2};
+
+    double outputs[10];
+    packed_forward(packed, input, outputs);
+
+    int classes[4];
+    double scores[4];
+    int count = predict_top_k(packed, input, 4, classes, scores);
+    mu_assert("Top-k returned the wrong count", count == 4);
+    mu_assert("Top-1 differs from predict_class", classes[0] == predict_class(packed, input));
+    for (int i = 0; i < count; i++) {
+        mu_assert("Top-k score is not the class output", fabs(scores[i] - outputs[classes[i]]) < TEST_EPSILON);
+        if (i > 0) mu_assert("Top-k is not sorted", scores[i] <= scores[i - 1]);
+    }
+    int better = 0;
+    for (int j = 0; j < 10; j++) {
+        if (outputs[j] > scores[3]) better++;
+    }
+    mu_assert("Top-k skipped a stronger class", better <= 3);
+
+    int all[12];
+    mu_assert("Top-k did not clamp k to the output count", predict_top_k(packed, input, 12, all, NULL) == 10);
+
+    free_packed_network(packed);
+    free_neural_network(net);
+    return NULL;
+}
+
+const char* test_pruned_network_uses_sparse_kernels() {
+    int architecture[] = {50, 30, 10};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    for (int j = 0; j < 30; j++) net->biases[0]->data[0][j] = 0.01 * j - 0.1;
+
+    // Per-layer pruning hits the target in every layer; global pruning
+    // hits it overall
+    NeuralNetwork* per_layer = clone_network(net);
+    prune_network(per_layer, 0.6, PRUNE_PER_LAYER);
+    SparseWeights* layers = build_sparse_weights(per_layer);
+    mu_assert("Per-layer pruning missed layer 0", layers->layers[0].nnz == 600);
+    mu_assert("Per-layer pruning missed layer 1", layers->layers[1].nnz == 120);
+    free_sparse_weights(layers);
+    free_neural_network(per_layer);
+
+    double achieved = prune_network(net, 0.75, PRUNE_GLOBAL);
+    mu_assert("Global pruning missed its target", fabs(achieved - 0.75) < 1e-9);
+
+    double input[50];
+    for (int k = 0; k < 50; k++) input[k] = cos(k * 0.53);
+    Matrix* view = create_matrix_view(1, 50, input);
+    Matrix* dense = forward_pass(net, view);
+    mu_assert("Failed to attach sparse weights", attach_sparse_weights(net) == 1);
+    mu_assert("Wrong nonzero count", sparse_weights_nnz(net->sparse) == 450);
+    Matrix* sparse = forward_pass(net, view);
+    for (int j = 0; j < 10; j++) {
+        mu_assert("Sparse forward_pass differs from dense", fabs(sparse->data[0][j] - dense->data[0][j]) < 1e-12);
+    }
+
+    // load_network reads sparse files back with the CSR copy attached
+    const char* filepath = "test_network.sparse";
+    mu_assert("Failed to save sparse network", save_network_sparse(net, filepath) == 1);
+    mu_assert("Sparse model not detected", detect_model_format(filepath) == MODEL_FORMAT_SPARSE);
+    NeuralNetwork* loaded = load_network(filepath);
+    mu_assert("Failed to load sparse network", loaded != NULL && loaded->sparse != NULL);
+    for (int k = 0; k < 50; k++) {
+        for (int j = 0; j < 30; j++) {
+            mu_assert("Reloaded weight differs", loaded->weights[0]->data[k][j] == net->weights[0]->data[k][j]);
+        }
+    }
+    double scratch[100];
+    PackedNetwork* packed = pack_network(net);
+    mu_assert("Sparse prediction differs", sparse_predict(loaded, input, scratch) == predict_class(packed, input));
+    remove(filepath);
+
+    // Mutation invalidates the CSR copy
+    mutate_network(loaded, 0.05f, 0.5f);
+    mu_assert("Mutation kept a stale sparse copy", loaded->sparse == NULL);
+
+    free_packed_network(packed);
+    free_neural_network(loaded);
+    free_matrix(sparse);
+    free_matrix(dense);
+    free_matrix(view);
+    free_neural_network(net);
+    return 0;
+}
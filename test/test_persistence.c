@@ -1,7 +1,10 @@
 #include "minunit.h"
 #include "../include/neural_network.h"
+#include "../include/model_format.h"
+#include "../include/codegen.h"
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 
 extern const double TEST_EPSILON;
 
@@ -46,3 +49,113 @@ const char* test_save_and_load_network() {
 
     return NULL;
 }
+
+const char* test_load_legacy_text_network() {
+    int architecture[] = {2, 3, 1};
+    NeuralNetwork* original_net = create_neural_network(3, architecture);
+    original_net->weights[1]->data[2][0] = -0.789;
+
+    const char* filepath = "test_network_text.dat";
+    mu_assert("Failed to save text network", save_network_text(original_net, filepath) == 1);
+    mu_assert("Text network not detected", detect_model_format(filepath) == MODEL_FORMAT_TEXT);
+
+    NeuralNetwork* loaded_net = load_network(filepath);
+    mu_assert("Failed to load text network", loaded_net != NULL);
+    mu_assert("Text network has wrong weights", fabs(loaded_net->weights[1]->data[2][0] + 0.789) < TEST_EPSILON);
+
+    free_neural_network(original_net);
+    free_neural_network(loaded_net);
+    remove(filepath);
+    return NULL;
+}
+
+const char* test_binary_network_detects_corruption() {
+    int architecture[] = {3, 4, 2};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+
+    const char* filepath = "test_network_corrupt.dat";
+    mu_assert("Failed to save network", save_network(net, filepath) == 1);
+    mu_assert("Binary network not detected", detect_model_format(filepath) == MODEL_FORMAT_BINARY);
+
+    // Flip one byte inside the first weight block
+    uint64_t weight_offsets[2];
+    model_layout(3, architecture, weight_offsets, NULL);
+    FILE* file = fopen(filepath, "r+b");
+    mu_assert("Failed to reopen network file", file != NULL);
+    fseek(file, (long)weight_offsets[0] + 3, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, (long)weight_offsets[0] + 3, SEEK_SET);
+    fputc(byte ^ 0xff, file);
+    fclose(file);
+
+    mu_assert("Corrupt network should not load", load_network(filepath) == NULL);
+
+    free_neural_network(net);
+    remove(filepath);
+    return NULL;
+}
+
+const char* test_map_network_shares_file_data() {
+    int architecture[] = {3, 4, 2};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    net->weights[1]->data[3][1] = 0.625;
+    net->biases[0]->data[0][2] = -1.5;
+
+    const char* filepath = "test_network_mapped.dat";
+    mu_assert("Failed to save network", save_network(net, filepath) == 1);
+
+    MappedNetwork* mapped = map_network(filepath, 1);
+    mu_assert("Failed to map network", mapped != NULL);
+    mu_assert("Mapped network has wrong architecture", mapped->net->num_layers == 3 && mapped->net->architecture[1] == 4);
+    mu_assert("Mapped weights are wrong", mapped->net->weights[1]->data[3][1] == 0.625);
+    mu_assert("Mapped biases are wrong", mapped->net->biases[0]->data[0][2] == -1.5);
+    mu_assert("Mapped weights are not views", mapped->net->weights[0]->owns_data == 0);
+    const char* base = (const char*)mapped->mapping;
+    const char* weights = (const char*)mapped->net->weights[0]->data[0];
+    mu_assert("Mapped weights do not point into the file", weights > base && weights < base + mapped->mapping_size);
+    mu_assert("Mapped weights are not aligned", ((uintptr_t)weights % MODEL_ALIGNMENT) == 0);
+
+    // Saving over a mapped file must leave the mapping intact, even when the
+    // new file is shorter
+    int small_architecture[] = {2, 2};
+    NeuralNetwork* small = create_neural_network(2, small_architecture);
+    mu_assert("Failed to overwrite mapped network", save_network(small, filepath) == 1);
+    mu_assert("Mapped weights changed after overwrite", mapped->net->weights[1]->data[3][1] == 0.625);
+    mu_assert("Mapped biases changed after overwrite", mapped->net->biases[0]->data[0][2] == -1.5);
+    free_neural_network(small);
+
+    unmap_network(mapped);
+    free_neural_network(net);
+    remove(filepath);
+    return NULL;
+}
+
+const char* test_compile_network_source() {
+    int architecture[] = {2, 3, 2};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    net->weights[0]->data[1][2] = 0.375;
+
+    mu_assert("Invalid identifier was accepted",
+              compile_network_source(net, "2bad", "test_compiled.c", "test_compiled.h") == 0);
+    mu_assert("Failed to compile network", compile_network_source(net, "tiny_net", "test_compiled.c", "test_compiled.h") == 1);
+
+    char source[65536];
+    FILE* file = fopen("test_compiled.c", "r");
+    size_t length = fread(source, 1, sizeof(source) - 1, file);
+    fclose(file);
+    source[length] = '\0';
+    mu_assert("Generated source lacks the forward function", strstr(source, "void tiny_net_forward(") != NULL);
+    mu_assert("Generated source lacks the weight arrays", strstr(source, "tiny_net_w1[3][2]") != NULL);
+    mu_assert("Generated weights are not exact", strstr(source, "0x1.8p-2") != NULL);
+
+    file = fopen("test_compiled.h", "r");
+    length = fread(source, 1, sizeof(source) - 1, file);
+    fclose(file);
+    source[length] = '\0';
+    mu_assert("Generated header lacks the input size", strstr(source, "#define tiny_net_INPUT_SIZE 2") != NULL);
+
+    remove("test_compiled.c");
+    remove("test_compiled.h");
+    free_neural_network(net);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "minunit.h"
+#include "../include/projection.h"
+#include <stdio.h>
+#include <math.h>
+
+extern const double TEST_EPSILON;
+
+const char* test_pca_finds_dominant_direction() {
+    // Points spread along (1, 1, 0) with a little spread along z
+    Dataset* dataset = create_dataset(200, 3, 2);
+    mu_assert("Failed to create dataset", dataset != NULL);
+    for (int i = 0; i < dataset->num_items; i++) {
+        double t = (i - 100) / 50.0;
+        dataset->images->data[i][0] = t;
+        dataset->images->data[i][1] = t;
+        dataset->images->data[i][2] = (i % 2 ? 0.01 : -0.01);
+    }
+
+    Projection* pca = fit_pca(dataset, 1, 0);
+    mu_assert("PCA fit failed", pca != NULL);
+    mu_assert("PCA has wrong shape", pca->input_size == 3 && pca->output_size == 1);
+    double x = pca->basis->data[0][0], y = pca->basis->data[1][0], z = pca->basis->data[2][0];
+    mu_assert("PCA component is not the dominant direction", fabs(fabs(x) - sqrt(0.5)) < 1e-6 && fabs(x - y) < 1e-6 && fabs(z) < 1e-3);
+
+    Dataset* projected = project_dataset(pca, dataset);
+    mu_assert("Projection failed", projected != NULL && projected->images->cols == 1);
+    double expected = (dataset->images->data[0][0] - pca->mean[0]) * x + (dataset->images->data[0][1] - pca->mean[1]) * y
+                      + (dataset->images->data[0][2] - pca->mean[2]) * z;
+    mu_assert("Projected value is wrong", fabs(projected->images->data[0][0] - expected) < TEST_EPSILON);
+
+    const char* filepath = "test_projection.proj";
+    mu_assert("Failed to save projection", save_projection(pca, filepath) == 1);
+    Projection* loaded = load_projection(filepath);
+    mu_assert("Failed to load projection", loaded != NULL);
+    mu_assert("Loaded projection has wrong kind", loaded->kind == PROJECTION_PCA);
+    mu_assert("Loaded projection has wrong basis", fabs(loaded->basis->data[1][0] - y) < TEST_EPSILON);
+    mu_assert("Loaded projection has wrong mean", fabs(loaded->mean[0] - pca->mean[0]) < TEST_EPSILON);
+
+    free_projection(loaded);
+    free_projection(pca);
+    free_dataset(projected);
+    free_dataset(dataset);
+    remove(filepath);
+    return NULL;
+}
@@ -0,0 +1,234 @@
+#include "minunit.h"
+#include "../include/quantization.h"
+#include "../include/inference.h"
+#include "../include/model_format.h"
+#include "../include/half_network.h"
+#include "../include/binarized_network.h"
+#include "../include/codebook.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+const char* test_quantized_network_tracks_float() {
+    int architecture[] = {70, 33, 10};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    QuantizedNetwork* qnet = quantize_network(net);
+    mu_assert("Failed to quantize network", qnet != NULL);
+    mu_assert("Rows are not padded", qnet->padded_inputs[0] == 128 && qnet->padded_inputs[1] == 64);
+
+    // Inputs with negative values exercise the first-layer offset
+    double input[70];
+    for (int k = 0; k < 70; k++) input[k] = sin(k * 0.37);
+    Matrix* view = create_matrix_view(1, 70, input);
+    Matrix* expected = forward_pass(net, view);
+    double output[10];
+    quantized_forward(qnet, input, output);
+    for (int j = 0; j < 10; j++) {
+        mu_assert("Quantized output strays from the float network", fabs(output[j] - expected->data[0][j]) < 0.02);
+    }
+
+    // A saved and reloaded model must predict exactly like the original
+    const char* filepath = "test_network.q8";
+    mu_assert("Failed to save quantized network", save_quantized_network(qnet, filepath) == 1);
+    QuantizedNetwork* loaded = load_quantized_network(filepath);
+    mu_assert("Failed to load quantized network", loaded != NULL);
+    double reloaded[10];
+    quantized_forward(loaded, input, reloaded);
+    for (int j = 0; j < 10; j++) {
+        mu_assert("Reloaded quantized network differs", reloaded[j] == output[j]);
+    }
+    mu_assert("Quantized predictions differ after reload",
+              quantized_predict(loaded, input) == quantized_predict(qnet, input));
+
+    remove(filepath);
+    free_quantized_network(loaded);
+    free_matrix(expected);
+    free_matrix(view);
+    free_quantized_network(qnet);
+    free_neural_network(net);
+    return 0;
+}
+
+const char* test_half_network_conversions() {
+    // Rounding matches IEEE round-to-nearest-even, including ties and overflow
+    mu_assert("fp16 1.0", float_to_half(1.0f, HALF_FP16) == 0x3C00);
+    mu_assert("fp16 max", float_to_half(65504.0f, HALF_FP16) == 0x7BFF);
+    mu_assert("fp16 overflow", float_to_half(65520.0f, HALF_FP16) == 0x7C00);
+    mu_assert("fp16 tie to even", float_to_half(1.0f + 1.0f / 2048, HALF_FP16) == 0x3C00);
+    mu_assert("fp16 tie up", float_to_half(1.0f + 3.0f / 2048, HALF_FP16) == 0x3C02);
+    mu_assert("fp16 subnormal", float_to_half(-ldexpf(1.0f, -24), HALF_FP16) == 0x8001);
+    mu_assert("bf16 1.0", float_to_half(1.0f, HALF_BF16) == 0x3F80);
+    mu_assert("bf16 tie to even", float_to_half(1.0f + 1.0f / 256, HALF_BF16) == 0x3F80);
+    for (int bits = 0; bits < 0x10000; bits++) {
+        if ((bits & 0x7C00) == 0x7C00 && (bits & 0x03FF)) continue; // NaN payloads
+        mu_assert("fp16 roundtrip", float_to_half(half_to_float(bits, HALF_FP16), HALF_FP16) == bits);
+    }
+    for (int bits = 0; bits < 0x10000; bits++) {
+        if ((bits & 0x7F80) == 0x7F80 && (bits & 0x007F)) continue;
+        mu_assert("bf16 roundtrip", float_to_half(half_to_float(bits, HALF_BF16), HALF_BF16) == bits);
+    }
+
+    // Half genomes predict like the double network they were rounded from
+    int architecture[] = {70, 33, 10};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    HalfNetwork* half = half_network_from_network(net, HALF_BF16);
+    mu_assert("Failed to convert network", half != NULL);
+    mu_assert("Half network is not a quarter of the doubles",
+              half_network_size(half) == (70 * 33 + 33 + 33 * 10 + 10) * sizeof(uint16_t));
+    NeuralNetwork* widened = half_network_to_network(half);
+    PackedNetwork* packed = pack_network(widened);
+    float* scratch = (float*)malloc(half_network_scratch_size(half) * sizeof(float));
+    double input[70];
+    for (int trial = 0; trial < 8; trial++) {
+        for (int k = 0; k < 70; k++) input[k] = sin(k * 0.37 + trial);
+        mu_assert("Half prediction differs", half_predict(half, input, scratch) == predict_class(packed, input));
+    }
+
+    // Crossing a genome with itself reproduces it; mutation stays in format
+    HalfNetwork* child = crossover_half(half, half);
+    mu_assert("Failed to cross over", child != NULL);
+    mu_assert("Self-crossover changed weights",
+              memcmp(child->weights[0], half->weights[0], 70 * 33 * sizeof(uint16_t)) == 0);
+    mutate_half_network(child, 0.05f, 1.0f);
+    mu_assert("Mutation left weights unchanged",
+              memcmp(child->weights[0], half->weights[0], 70 * 33 * sizeof(uint16_t)) != 0);
+
+    free(scratch);
+    free_packed_network(packed);
+    free_neural_network(widened);
+    free_half_network(child);
+    free_half_network(half);
+    free_neural_network(net);
+    return 0;
+}
+
+// Reference +-1 arithmetic for one layer, one value per int
+static void reference_binarized_layer(const BinarizedNetwork* net, int l, const int* in, int* out, int activate) {
+    for (int j = 0; j < net->architecture[l + 1]; j++) {
+        int dot = 0;
+        for (int k = 0; k < net->architecture[l]; k++) {
+            uint64_t word = net->weights[l][(size_t)j * net->words[l] + k / 64];
+            dot += in[k] * ((word >> (k % 64)) & 1 ? 1 : -1);
+        }
+        out[j] = activate ? (dot >= net->thresholds[l][j] ? 1 : -1) : dot - net->thresholds[l][j];
+    }
+}
+
+const char* test_binarized_network_matches_reference() {
+    // Widths that are not multiples of 64 exercise the padding bits
+    int architecture[] = {100, 70, 10};
+    BinarizedNetwork* net = create_binarized_genome(3, architecture);
+    mu_assert("Failed to create binarized network", net != NULL);
+    for (int j = 0; j < 70; j++) net->thresholds[0][j] = (j % 7) - 3;
+
+    double pixels[100];
+    for (int k = 0; k < 100; k++) pixels[k] = 0.5 + 0.5 * sin(k * 0.91);
+    uint64_t input[2];
+    pack_threshold_bits(pixels, 100, MNIST_BINARIZE_THRESHOLD, input);
+    mu_assert("Padding bits are set", (input[1] >> 36) == 0);
+
+    int values[100], hidden[70], expected[10];
+    for (int k = 0; k < 100; k++) values[k] = pixels[k] >= MNIST_BINARIZE_THRESHOLD ? 1 : -1;
+    reference_binarized_layer(net, 0, values, hidden, 1);
+    reference_binarized_layer(net, 1, hidden, expected, 0);
+
+    uint64_t* scratch = (uint64_t*)malloc(binarized_scratch_words(net) * sizeof(uint64_t));
+    int32_t scores[10];
+    int predicted = binarized_forward(net, input, scratch, scores);
+    int best = 0;
+    for (int j = 0; j < 10; j++) {
+        mu_assert("XNOR-popcount score differs from reference", scores[j] == expected[j]);
+        if (expected[j] > expected[best]) best = j;
+    }
+    mu_assert("Binarized prediction is not the best score", predicted == best);
+
+    // Saving and reloading keeps every bit
+    const char* filepath = "test_network.bnn";
+    mu_assert("Failed to save binarized network", save_binarized_network(net, filepath) == 1);
+    mu_assert("Binarized model not detected", detect_model_format(filepath) == MODEL_FORMAT_BINARIZED);
+    BinarizedNetwork* loaded = load_binarized_network(filepath);
+    mu_assert("Failed to load binarized network", loaded != NULL);
+    mu_assert("Reloaded weights differ", memcmp(loaded->weights[0], net->weights[0], 70 * 2 * sizeof(uint64_t)) == 0);
+    mu_assert("Reloaded thresholds differ", memcmp(loaded->thresholds[0], net->thresholds[0], 70 * sizeof(int32_t)) == 0);
+    remove(filepath);
+
+    // Crossing a genome with itself reproduces it; flipping every bit
+    // inverts the real weights and leaves the padding clear
+    BinarizedNetwork* child = crossover_binarized(net, net);
+    mu_assert("Self-crossover changed weights", memcmp(child->weights[0], net->weights[0], 70 * 2 * sizeof(uint64_t)) == 0);
+    mutate_binarized_network(child, 0.0f, 1.0f);
+    for (int j = 0; j < 70; j++) {
+        mu_assert("Mutation missed a bit", child->weights[0][j * 2] == ~net->weights[0][j * 2]);
+        mu_assert("Mutation touched padding", child->weights[0][j * 2 + 1] == (~net->weights[0][j * 2 + 1] & 0xFFFFFFFFFull));
+    }
+
+    free(scratch);
+    free_binarized_network(child);
+    free_binarized_network(loaded);
+    free_binarized_network(net);
+    return 0;
+}
+
+const char* test_codebook_network_shares_weights() {
+    int architecture[] = {70, 33, 10};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    double input[70];
+    for (int k = 0; k < 70; k++) input[k] = sin(k * 0.37);
+    Matrix* view = create_matrix_view(1, 70, input);
+
+    const int sizes[] = {CODEBOOK_MIN_CENTROIDS, CODEBOOK_MAX_CENTROIDS};
+    for (int s = 0; s < 2; s++) {
+        CodebookNetwork* cnet = compress_network(net, sizes[s]);
+        mu_assert("Failed to compress network", cnet != NULL);
+        mu_assert("Wrong index width", cnet->index_bits[0] == (sizes[s] == 16 ? 4 : 8));
+        for (int c = 1; c < sizes[s]; c++) {
+            mu_assert("Centroids are not ascending", cnet->centroids[0][c - 1] <= cnet->centroids[0][c]);
+        }
+
+        // The reference network holds each weight's nearest centroid, so the
+        // codebook kernels must agree with it up to float rounding
+        NeuralNetwork* shared = clone_network(net);
+        for (int l = 0; l < 2; l++) {
+            for (int k = 0; k < architecture[l]; k++) {
+                for (int j = 0; j < architecture[l + 1]; j++) {
+                    double w = shared->weights[l]->data[k][j];
+                    int best = 0;
+                    for (int c = 1; c < sizes[s]; c++) {
+                        if (fabs(cnet->centroids[l][c] - w) < fabs(cnet->centroids[l][best] - w)) best = c;
+                    }
+                    shared->weights[l]->data[k][j] = cnet->centroids[l][best];
+                }
+            }
+        }
+        Matrix* expected = forward_pass(shared, view);
+        double output[10];
+        codebook_forward(cnet, input, output);
+        for (int j = 0; j < 10; j++) {
+            mu_assert("Codebook output differs from shared weights", fabs(output[j] - expected->data[0][j]) < 1e-4);
+        }
+        mu_assert("Weight error too large", codebook_weight_error(cnet, net) < (sizes[s] == 16 ? 0.05 : 0.005));
+
+        const char* filepath = "test_network.cb";
+        mu_assert("Failed to save codebook network", save_codebook_network(cnet, filepath) == 1);
+        mu_assert("Codebook model not detected", detect_model_format(filepath) == MODEL_FORMAT_CODEBOOK);
+        CodebookNetwork* loaded = load_codebook_network(filepath);
+        mu_assert("Failed to load codebook network", loaded != NULL);
+        double reloaded[10];
+        codebook_forward(loaded, input, reloaded);
+        for (int j = 0; j < 10; j++) {
+            mu_assert("Reloaded codebook network differs", reloaded[j] == output[j]);
+        }
+        remove(filepath);
+
+        free_codebook_network(loaded);
+        free_matrix(expected);
+        free_neural_network(shared);
+        free_codebook_network(cnet);
+    }
+    mu_assert("Too few centroids accepted", compress_network(net, 8) == NULL);
+
+    free_matrix(view);
+    free_neural_network(net);
+    return 0;
+}
@@ -12,12 +12,51 @@ const char* all_suites() {
     // Run tests from test_neural_network.c
     mu_run_test(test_nn_creation);
     mu_run_test(test_nn_forward_pass);
+    mu_run_test(test_specialized_forward_matches_generic);
+    mu_run_test(test_packed_forward_matches_forward_pass);
+    mu_run_test(test_predict_top_k_orders_classes);
+    mu_run_test(test_pruned_network_uses_sparse_kernels);
 
     // Run tests from test_persistence.c
     mu_run_test(test_save_and_load_network);
+    mu_run_test(test_load_legacy_text_network);
+    mu_run_test(test_binary_network_detects_corruption);
+    mu_run_test(test_map_network_shares_file_data);
+    mu_run_test(test_compile_network_source);
 
     // Run tests from test_evolution.c
     mu_run_test(test_crossover);
+    mu_run_test(test_quantized_crossover_and_mutation);
+    mu_run_test(test_migration_queue_is_fifo);
+    mu_run_test(test_islands_exchange_migrants);
+    mu_run_test(test_steady_state_never_loses_the_best);
+    mu_run_test(test_distributed_evaluation_requeues_lost_work);
+
+    // Run tests from test_data_loader.c
+    mu_run_test(test_dataset_cache_roundtrip);
+    mu_run_test(test_load_mnist_range_and_subset);
+    mu_run_test(test_parallel_decode_matches_scalar);
+    mu_run_test(test_dataset_stream_batches);
+    mu_run_test(test_synthetic_dataset_is_deterministic);
+
+    // Run tests from test_projection.c
+    mu_run_test(test_pca_finds_dominant_direction);
+
+    // Run tests from test_checkpoint.c
+    mu_run_test(test_checkpoint_roundtrip);
+
+    // Run tests from test_quantization.c
+    mu_run_test(test_quantized_network_tracks_float);
+    mu_run_test(test_half_network_conversions);
+    mu_run_test(test_binarized_network_matches_reference);
+    mu_run_test(test_codebook_network_shares_weights);
+
+    // Run tests from test_training.c
+    mu_run_test(test_backprop_gradients_match_finite_differences);
+    mu_run_test(test_optimizers_reduce_loss);
+    mu_run_test(test_ridge_fits_output_layer);
+    mu_run_test(test_evolution_strategies_from_seeds);
+    mu_run_test(test_evolution_strategies_improve_mean);
 
     return NULL;
 }
@@ -8,12 +8,51 @@ const char* test_matrix_dot_product();
 // test_neural_network.c
 const char* test_nn_creation();
 const char* test_nn_forward_pass();
+const char* test_specialized_forward_matches_generic();
+const char* test_packed_forward_matches_forward_pass();
+const char* test_predict_top_k_orders_classes();
+const char* test_pruned_network_uses_sparse_kernels();
 
 // test_persistence.c
 const char* test_save_and_load_network();
+const char* test_load_legacy_text_network();
+const char* test_binary_network_detects_corruption();
+const char* test_map_network_shares_file_data();
+const char* test_compile_network_source();
 
 // test_evolution.c
 const char* test_crossover();
+const char* test_quantized_crossover_and_mutation();
+const char* test_migration_queue_is_fifo();
+const char* test_islands_exchange_migrants();
+const char* test_steady_state_never_loses_the_best();
+const char* test_distributed_evaluation_requeues_lost_work();
+
+// test_data_loader.c
+const char* test_dataset_cache_roundtrip();
+const char* test_load_mnist_range_and_subset();
+const char* test_parallel_decode_matches_scalar();
+const char* test_dataset_stream_batches();
+const char* test_synthetic_dataset_is_deterministic();
+
+// test_projection.c
+const char* test_pca_finds_dominant_direction();
+
+// test_checkpoint.c
+const char* test_checkpoint_roundtrip();
+
+// test_quantization.c
+const char* test_quantized_network_tracks_float();
+const char* test_half_network_conversions();
+const char* test_binarized_network_matches_reference();
+const char* test_codebook_network_shares_weights();
+
+// test_training.c
+const char* test_backprop_gradients_match_finite_differences();
+const char* test_optimizers_reduce_loss();
+const char* test_ridge_fits_output_layer();
+const char* test_evolution_strategies_from_seeds();
+const char* test_evolution_strategies_improve_mean();
 
 // Add declarations for other test suites here
 
@@ -0,0 +1,211 @@
+#include "minunit.h"
+#include "../include/backprop.h"
+#include "../include/ridge.h"
+#include "../include/evolution_strategies.h"
+#include "../include/inference.h"
+#include "../include/synthetic_dataset.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Small clustered problem that trains in a few milliseconds
+static Dataset* small_dataset(int num_items, uint64_t seed) {
+    SyntheticConfig config = default_synthetic_config(num_items, seed);
+    config.input_size = 12;
+    config.num_classes = 4;
+    config.sparsity = 0.3;
+    return create_synthetic_dataset(&config);
+}
+
+const char* test_backprop_gradients_match_finite_differences() {
+    int architecture[] = {12, 7, 4};
+    Dataset* dataset = small_dataset(16, 3);
+    mu_assert("Failed to create dataset", dataset != NULL);
+    int indices[16];
+    for (int i = 0; i < 16; i++) indices[i] = i;
+
+    const Activation activations[] = {ACTIVATION_SIGMOID, ACTIVATION_TANH};
+    for (int a = 0; a < 2; a++) {
+        NeuralNetwork* net = create_neural_network(3, architecture);
+        Rng rng;
+        rng_seed(&rng, 11);
+        initialize_network_for_training(net, &rng);
+        TrainerConfig config;
+        default_trainer_config(&config, OPTIMIZER_SGD);
+        config.batch_size = 16;
+        config.hidden_activation = activations[a];
+        Trainer* trainer = create_trainer(net, &config);
+        mu_assert("Failed to create trainer", trainer != NULL);
+
+        compute_batch_gradients(trainer, dataset, indices, 16);
+        double* analytic = (double*)malloc(trainer->num_params * sizeof(double));
+        for (size_t p = 0; p < trainer->num_params; p++) analytic[p] = trainer->gradients[p];
+
+        // Weights and biases of both layers, in the flat gradient order
+        double* params[] = {net->weights[0]->data[0], net->biases[0]->data[0],
+                            net->weights[1]->data[0], net->biases[1]->data[0]};
+        size_t counts[] = {12 * 7, 7, 7 * 4, 4};
+        size_t offset = 0;
+        for (int b = 0; b < 4; b++) {
+            for (size_t p = 0; p < counts[b]; p += 3) {
+                double saved = params[b][p];
+                params[b][p] = saved + 1e-6;
+                double above = compute_batch_gradients(trainer, dataset, indices, 16);
+                params[b][p] = saved - 1e-6;
+                double below = compute_batch_gradients(trainer, dataset, indices, 16);
+                params[b][p] = saved;
+                double numeric = (above - below) / 2e-6;
+                mu_assert("Backprop gradient differs from finite difference",
+                          fabs(numeric - analytic[offset + p]) < 1e-6 + 1e-4 * fabs(numeric));
+            }
+            offset += counts[b];
+        }
+
+        free(analytic);
+        free_trainer(trainer);
+        free_neural_network(net);
+    }
+    free_dataset(dataset);
+    return 0;
+}
+
+const char* test_optimizers_reduce_loss() {
+    int architecture[] = {12, 16, 4};
+    Dataset* dataset = small_dataset(256, 5);
+    mu_assert("Failed to create dataset", dataset != NULL);
+
+    const OptimizerKind optimizers[] = {OPTIMIZER_SGD, OPTIMIZER_MOMENTUM, OPTIMIZER_ADAM};
+    for (int o = 0; o < 3; o++) {
+        NeuralNetwork* net = create_neural_network(3, architecture);
+        Rng rng;
+        rng_seed(&rng, 21);
+        initialize_network_for_training(net, &rng);
+        TrainerConfig config;
+        default_trainer_config(&config, optimizers[o]);
+        config.batch_size = 32;
+        if (optimizers[o] == OPTIMIZER_ADAM) config.learning_rate = 0.01;
+        Trainer* trainer = create_trainer(net, &config);
+        mu_assert("Failed to create trainer", trainer != NULL);
+
+        double first = train_epoch(trainer, dataset, dataset->num_items, &rng);
+        double last = first;
+        for (int epoch = 0; epoch < 30; epoch++) {
+            last = train_epoch(trainer, dataset, dataset->num_items, &rng);
+        }
+        mu_assert("Training did not reduce the loss", last < 0.5 * first);
+        mu_assert("Optimizer took no steps", trainer->step == 31 * 8);
+
+        free_trainer(trainer);
+        free_neural_network(net);
+    }
+    free_dataset(dataset);
+    return 0;
+}
+
+const char* test_ridge_fits_output_layer() {
+    // A X = B with a known solution
+    double a[9] = {4, 2, 0.4, 2, 5, 1, 0.4, 1, 3};
+    double x[6] = {1, -2, 0.5, 3, -1, 0.25};
+    double b[6] = {0};
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) {
+            for (int r = 0; r < 2; r++) b[i * 2 + r] += a[i * 3 + k] * x[k * 2 + r];
+        }
+    }
+    mu_assert("Cholesky rejected a positive definite matrix", cholesky_solve(a, 3, b, 2) == 1);
+    for (int e = 0; e < 6; e++) mu_assert("Cholesky solution is wrong", fabs(b[e] - x[e]) < 1e-12);
+    double singular[4] = {1, 1, 1, 1};
+    double rhs[2] = {1, 1};
+    mu_assert("Cholesky accepted a singular matrix", cholesky_solve(singular, 2, rhs, 1) == 0);
+
+    // The random hidden layer is kept and the output layer alone separates
+    // the clusters
+    int architecture[] = {12, 32, 4};
+    Dataset* dataset = small_dataset(512, 9);
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    double first_weight = net->weights[0]->data[0][0];
+    mu_assert("Ridge fit failed", fit_output_layer(net, dataset, dataset->num_items, RIDGE_DEFAULT_LAMBDA) == 1);
+    mu_assert("Ridge fit changed the hidden layer", net->weights[0]->data[0][0] == first_weight);
+    PackedNetwork* packed = pack_network(net);
+    int correct = 0;
+    for (int i = 0; i < dataset->num_items; i++) {
+        if (predict_class(packed, dataset->images->data[i]) == dataset->label_indices[i]) correct++;
+    }
+    mu_assert("Ridge output layer does not separate the classes", correct > dataset->num_items * 9 / 10);
+
+    free_packed_network(packed);
+    free_neural_network(net);
+    free_dataset(dataset);
+    return 0;
+}
+
+const char* test_evolution_strategies_from_seeds() {
+    int architecture[] = {12, 8, 4};
+    NeuralNetwork* net = create_neural_network(3, architecture);
+    size_t n = network_num_params(net);
+    mu_assert("Wrong parameter count", n == (12 + 1) * 8 + (8 + 1) * 4);
+    double* params = (double*)malloc(n * sizeof(double));
+    double* partner = (double*)malloc(n * sizeof(double));
+    flatten_network(net, params);
+    NeuralNetwork* copy = create_neural_network(3, architecture);
+    unflatten_network(copy, params);
+    mu_assert("Flatten roundtrip lost a weight", copy->weights[1]->data[7][3] == net->weights[1]->data[7][3]);
+    mu_assert("Flatten roundtrip lost a bias", copy->biases[0]->data[0][5] == net->biases[0]->data[0][5]);
+
+    // Antithetic partners mirror each other around the mean, and a seed
+    // alone reproduces a candidate
+    EsConfig config;
+    default_es_config(&config, ES_OPENAI);
+    config.population = 4;
+    EvolutionStrategy* es = create_evolution_strategy(net, &config);
+    mu_assert("Failed to create strategy", es != NULL);
+    es_ask(es);
+    mu_assert("Partners do not share a seed", es->seeds[0] == es->seeds[1] && es->seeds[1] != es->seeds[2]);
+    es_candidate(es, 0, params);
+    es_candidate(es, 1, partner);
+    for (size_t p = 0; p < n; p++) {
+        mu_assert("Partners are not mirrored", fabs(params[p] + partner[p] - 2.0 * es->mean[p]) < 1e-12);
+    }
+    es_candidate(es, 0, partner);
+    for (size_t p = 0; p < n; p++) mu_assert("Candidate is not reproducible", params[p] == partner[p]);
+
+    free_evolution_strategy(es);
+    free_neural_network(copy);
+    free(partner);
+    free(params);
+    free_neural_network(net);
+    return 0;
+}
+
+const char* test_evolution_strategies_improve_mean() {
+    int architecture[] = {12, 8, 4};
+    Dataset* dataset = small_dataset(256, 13);
+    const EsKind kinds[] = {ES_OPENAI, ES_SEPARABLE_CMA};
+    for (int k = 0; k < 2; k++) {
+        NeuralNetwork* net = create_neural_network(3, architecture);
+        Rng rng;
+        rng_seed(&rng, 17);
+        initialize_network_for_training(net, &rng);
+        double before = network_accuracy(net, dataset, dataset->num_items);
+
+        EsConfig config;
+        default_es_config(&config, kinds[k]);
+        config.population = 20;
+        config.sigma = 0.1;
+        config.learning_rate = 0.01;
+        EvolutionStrategy* es = create_evolution_strategy(net, &config);
+        double fitness[20];
+        for (int gen = 0; gen < 40; gen++) {
+            es_ask(es);
+            es_evaluate(es, net, dataset, dataset->num_items, fitness);
+            es_tell(es, fitness);
+        }
+        es_mean_network(es, net);
+        double after = network_accuracy(net, dataset, dataset->num_items);
+        mu_assert("Evolution strategy did not improve the mean", after > before + 0.2);
+
+        free_evolution_strategy(es);
+        free_neural_network(net);
+    }
+    free_dataset(dataset);
+    return 0;
+}